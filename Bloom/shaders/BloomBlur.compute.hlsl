@@ -4,9 +4,11 @@
 cbuffer PushConstants
 {
     int2 u_FullSize;
-    int u_Horizontal;
 };
 
+// baked into separate horizontal and vertical pipelines
+[[vk::constant_id(0)]] const bool c_Horizontal = true;
+
 [[vk::binding(0, 0)]]
 Texture2D<float4> r_SrcImage;
 
@@ -32,7 +34,7 @@ void CShader(uint3 DTid : SV_DispatchThreadID)
     for (int i = 0; i < 5; i++)
     {
         float offset = float(i);
-        offsets[i] = u_Horizontal != 0 ? float2(offset, 0.0) * texelSize : float2(0.0, offset) * texelSize;
+        offsets[i] = c_Horizontal ? float2(offset, 0.0) * texelSize : float2(0.0, offset) * texelSize;
     }
 
     float3 color = r_SrcImage.Sample(r_Sampler, uv).rgb * weights[0];
@@ -6,10 +6,11 @@ cbuffer PushConstants
     float4x4 ViewProjection;
 };
 
-struct VertexInput
+// per instance, see PrimitiveRenderer
+struct InstanceInput
 {
-    float3 WorldPosition : POSITION;
-    float3 LocalPosition : TEXCOORD0;
+    float3 Position : POSITION; // center
+    float Radius : TEXCOORD0;
     float4 Color : COLOR;
     float Thickness : TEXCOORD1;
     float Fade : TEXCOORD2;
@@ -24,10 +25,19 @@ struct VertexOutput
     float Fade : TEXCOORD2;
 };
 
-void VShader(in VertexInput input, out VertexOutput output)
+// two triangles covering -1 to 1, indexed by SV_VertexID
+static const float2 s_Corners[6] =
 {
-    output.Position = mul(ViewProjection, float4(input.WorldPosition, 1.0f));
-    output.LocalPosition = input.LocalPosition;
+    float2(-1.0f, -1.0f), float2(1.0f, -1.0f), float2(1.0f, 1.0f),
+    float2(1.0f, 1.0f), float2(-1.0f, 1.0f), float2(-1.0f, -1.0f)
+};
+
+void VShader(in InstanceInput input, in uint vertexID : SV_VertexID, out VertexOutput output)
+{
+    float2 corner = s_Corners[vertexID];
+
+    output.Position = mul(ViewProjection, float4(input.Position.xy + corner * input.Radius, input.Position.z, 1.0f));
+    output.LocalPosition = float3(corner, 0.0f);
     output.Color = input.Color;
     output.Thickness = input.Thickness;
     output.Fade = input.Fade;
@@ -6,9 +6,11 @@ cbuffer PushConstants
     float4x4 ViewProjection;
 };
 
-struct VertexInput
+// per instance, see PrimitiveRenderer
+struct InstanceInput
 {
-    float3 Position : POSITION;
+    float3 Start : POSITION;
+    float3 End : TEXCOORD0;
     float4 Color : COLOR;
 };
 
@@ -18,9 +20,9 @@ struct VertexOutput
     float4 Color : COLOR;
 };
 
-void VShader(in VertexInput input, out VertexOutput output)
+void VShader(in InstanceInput input, in uint vertexID : SV_VertexID, out VertexOutput output)
 {
-    output.Position = mul(ViewProjection, float4(input.Position, 1.0f));
+    output.Position = mul(ViewProjection, float4(vertexID == 0 ? input.Start : input.End, 1.0f));
     output.Color = input.Color;
 }
 
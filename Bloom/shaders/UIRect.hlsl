@@ -9,12 +9,14 @@ cbuffer PushConstants
 Texture2D r_Textures[32] : register(t0);
 SamplerState r_Sampler : register(s1);
 
-struct VertexInput
+// per instance, see PrimitiveRenderer
+struct InstanceInput
 {
-    float3 Position : POSITION;
+    float3 Position : POSITION; // center
+    float2 Size : TEXCOORD0;
     float4 Color : COLOR;
-    float2 TexCoord : TEXCOORD0;
-    int TextureIndex : TEXCOORD1;
+    float4 TexCoord : TEXCOORD1; // left, bottom, right, top
+    int TextureIndex : TEXCOORD2;
 };
 
 struct VertexOutput
@@ -25,11 +27,21 @@ struct VertexOutput
     int TextureIndex : TEXCOORD1;
 };
 
-void VShader(in VertexInput input, out VertexOutput output)
+// two triangles covering -1 to 1, indexed by SV_VertexID
+static const float2 s_Corners[6] =
+{
+    float2(-1.0f, -1.0f), float2(1.0f, -1.0f), float2(1.0f, 1.0f),
+    float2(1.0f, 1.0f), float2(-1.0f, 1.0f), float2(-1.0f, -1.0f)
+};
+
+void VShader(in InstanceInput input, in uint vertexID : SV_VertexID, out VertexOutput output)
 {
-    output.Position = mul(ViewProjection, float4(input.Position.xyz, 1.0f));
+    float2 corner = s_Corners[vertexID];
+    float2 uv = corner * 0.5f + 0.5f;
+
+    output.Position = mul(ViewProjection, float4(input.Position.xy + corner * input.Size * 0.5f, input.Position.z, 1.0f));
     output.Color = input.Color;
-    output.TexCoord = input.TexCoord;
+    output.TexCoord = lerp(input.TexCoord.xy, input.TexCoord.zw, uv);
     output.TextureIndex = input.TextureIndex;
 }
 
@@ -0,0 +1,1282 @@
+#pragma pack_matrix(column_major)
+
+// msdfgen's generateDistanceField with the OverlappingContourCombiner, in two passes (see c_Pass).
+// everything is evaluated in double precision and in the same order as the cpu generator, the scanline
+// sign correction and error correction that follow it stay on the cpu (see MSDFComputeGenerator).
+// vulkan only has to round double add, sub and mul correctly, so division and sqrt are rounded by hand
+// below, and every value is precise so the driver cannot fuse or reorder what the cpu does not
+
+[[vk::push_constant]]
+cbuffer PushConstants
+{
+    uint u_FirstGlyph;
+    uint u_GlyphCount;
+    uint u_FirstContour;
+    uint u_ContourCount;
+};
+
+// 1 = sdf, 3 = msdf, 4 = mtsdf
+[[vk::constant_id(0)]] const uint c_ChannelCount = 4;
+// 0 = a thread per contour, 1 = a thread per texel
+[[vk::constant_id(1)]] const uint c_Pass = 0;
+
+// MSDFComputeGenerator falls back to the cpu for glyphs with more contours
+#define MAX_CONTOURS 32
+
+// constants a float literal cannot hold exactly
+#define INFINITE_DISTANCE asdouble(0xde7ad7e3u, 0x71c33234u) // 1e240, SignedDistance::INFINITE
+#define TOO_LARGE_RATIO asdouble(0xa2000000u, 0x426d1a94u)   // 1e12
+#define ROOT_EPSILON asdouble(0x86a12b9bu, 0x3d06849bu)      // 1e-14
+#define SQRT_3 asdouble(0xe8584caau, 0x3ffbb67au)
+#define PI asdouble(0x54442d18u, 0x400921fbu)                // M_PI
+#define ONE_THIRD asdouble(0x55555555u, 0x3fd55555u)         // 1/3.
+#define SPLITTER asdouble(0x02000000u, 0x41a00000u)          // 2^27 + 1
+#define LN_2 asdouble(0xfefa39efu, 0x3fe62e42u)
+#define DISTANCE_DELTA_FACTOR asdouble(0x9374bc6au, 0x3ff00418u) // 1.001
+
+// fdlibm's acos and cos
+#define PIO2_HI asdouble(0x54442d18u, 0x3ff921fbu)
+#define PIO2_LO asdouble(0x33145c07u, 0x3c91a626u)
+#define PS0 asdouble(0x55555555u, 0x3fc55555u)
+#define PS1 asdouble(0x03eb6f7du, 0xbfd4d612u)
+#define PS2 asdouble(0x0e884455u, 0x3fc9c155u)
+#define PS3 asdouble(0xb5688f3bu, 0xbfa48228u)
+#define PS4 asdouble(0x7501b288u, 0x3f49efe0u)
+#define PS5 asdouble(0x0dfdf709u, 0x3f023de1u)
+#define QS1 asdouble(0x1c8a2d4bu, 0xc0033a27u)
+#define QS2 asdouble(0x9c598ac8u, 0x40002ae5u)
+#define QS3 asdouble(0x1b8d0159u, 0xbfe6066cu)
+#define QS4 asdouble(0xb12e9282u, 0x3fb3b8c5u)
+#define INV_PIO2 asdouble(0x6dc9c883u, 0x3fe45f30u)
+#define PIO2_1 asdouble(0x54400000u, 0x3ff921fbu)
+#define PIO2_1T asdouble(0x1a626331u, 0x3dd0b461u)
+#define PIO2_2 asdouble(0x1a600000u, 0x3dd0b461u)
+#define PIO2_2T asdouble(0x2e037073u, 0x3ba3198au)
+#define PIO2_3 asdouble(0x2e000000u, 0x3ba3198au)
+#define PIO2_3T asdouble(0x252049c1u, 0x397b839au)
+#define C1 asdouble(0x5555554cu, 0x3fa55555u)
+#define C2 asdouble(0x16c15177u, 0xbf56c16cu)
+#define C3 asdouble(0x19cb1590u, 0x3efa01a0u)
+#define C4 asdouble(0x809c52adu, 0xbe927e4fu)
+#define C5 asdouble(0xbdb4b1c4u, 0x3e21ee9eu)
+#define C6 asdouble(0xbe8838d4u, 0xbda8fae9u)
+#define S1 asdouble(0x55555549u, 0xbfc55555u)
+#define S2 asdouble(0x1110f8a6u, 0x3f811111u)
+#define S3 asdouble(0x19c161d5u, 0xbf2a01a0u)
+#define S4 asdouble(0x57b1fe7du, 0x3ec71de3u)
+#define S5 asdouble(0x8a2b9cebu, 0xbe5ae5e6u)
+#define S6 asdouble(0x5acfd57cu, 0x3de5d93au)
+
+struct GlyphData
+{
+    uint FirstContour;
+    uint ContourCount;
+    uint Width;
+    uint Height;
+    uint OutputOffset;    // in floats
+    uint FirstCoordinate; // Width unprojected x coordinates, then Height y coordinates
+    uint InverseY;
+    uint FirstSelector; // into r_ContourSelectors, ContourCount per texel
+    double InvRange;
+};
+
+struct ContourData
+{
+    uint FirstEdge;
+    uint EdgeCount;
+    int Winding;
+    uint Glyph;
+};
+
+struct EdgeData
+{
+    double P[8];
+    uint Degree; // 1 = linear, 2 = quadratic, 3 = cubic
+    uint Color;  // msdfgen::EdgeColor
+};
+
+// EdgeCache of the pseudo distance selectors, the true distance selector only uses the point and AbsDistance
+struct EdgeCache
+{
+    double PointX;
+    double PointY;
+    double AbsDistance;
+    double ADomainDistance;
+    double BDomainDistance;
+    double APseudoDistance;
+    double BPseudoDistance;
+    double Padding;
+};
+
+[[vk::binding(0, 0)]]
+StructuredBuffer<GlyphData> r_Glyphs;
+
+[[vk::binding(1, 0)]]
+StructuredBuffer<ContourData> r_Contours;
+
+[[vk::binding(2, 0)]]
+StructuredBuffer<EdgeData> r_Edges;
+
+[[vk::binding(3, 0)]]
+StructuredBuffer<double> r_Coordinates;
+
+[[vk::binding(4, 0)]]
+RWStructuredBuffer<float> r_Output;
+
+// one per edge, only touched by the thread of the edge's contour
+[[vk::binding(5, 0)]]
+RWStructuredBuffer<EdgeCache> r_EdgeCaches;
+
+uint HighWord(double x)
+{
+    uint low, high;
+    asuint(x, low, high);
+    return high;
+}
+
+// the unbiased exponent, 1024 for infinity and nan
+int Exponent(double x)
+{
+    return int((HighWord(x) >> 20) & 0x7FFu) - 1023;
+}
+
+double Pow2(int exponent)
+{
+    return asdouble(0u, uint(exponent + 1023) << 20);
+}
+
+// the next double after x, away from zero or towards it
+double NextMagnitude(double x, bool up)
+{
+    uint low, high;
+    asuint(x, low, high);
+
+    if (up)
+    {
+        low += 1u;
+        if (low == 0u)
+            high += 1u;
+    }
+    else
+    {
+        if (low == 0u)
+            high -= 1u;
+        low -= 1u;
+    }
+
+    return asdouble(low, high);
+}
+
+// a * b = product + error exactly (dekker), without relying on a fused fma
+double TwoProduct(double a, double b, out double error)
+{
+    precise double sa = SPLITTER * a;
+    precise double aHigh = sa - (sa - a);
+    precise double aLow = a - aHigh;
+    precise double sb = SPLITTER * b;
+    precise double bHigh = sb - (sb - b);
+    precise double bLow = b - bHigh;
+
+    precise double product = a * b;
+    precise double productError = ((aHigh * bHigh - product) + aHigh * bLow + aLow * bHigh) + aLow * bLow;
+
+    error = productError;
+    return product;
+}
+
+// correctly rounded a / b. the quotient of the scaled operands is refined until it is within an ulp,
+// its exact residual then tells which neighbour is nearest
+double Div(double a, double b)
+{
+    int exponentA = Exponent(a);
+    int exponentB = Exponent(b);
+    if (a == 0 || b == 0 || abs(exponentA) > 1000 || abs(exponentB) > 1000 || abs(exponentA - exponentB) > 1000)
+        return a / b;
+
+    precise double sa = a * Pow2(-exponentA);
+    precise double sb = b * Pow2(-exponentB);
+
+    precise double reciprocal = double(1.0f / float(sb));
+    reciprocal = reciprocal * (2 - sb * reciprocal);
+    reciprocal = reciprocal * (2 - sb * reciprocal);
+
+    precise double quotient = sa * reciprocal;
+    precise double error;
+    precise double product;
+    for (int i = 0; i < 2; i++)
+    {
+        product = TwoProduct(quotient, sb, error);
+        quotient = quotient + ((sa - product) - error) * reciprocal;
+    }
+
+    product = TwoProduct(quotient, sb, error);
+    precise double residual = (sa - product) - error;
+    if (residual != 0)
+    {
+        // residual / sb is what the quotient is missing, the midpoint to the neighbour on that side decides
+        double next = NextMagnitude(quotient, ((residual > 0) == (sb > 0)) == (quotient > 0));
+        precise double half = abs(next - quotient) * 0.5 * abs(sb);
+
+        uint low, high;
+        asuint(quotient, low, high);
+        if (abs(residual) > half || (abs(residual) == half && (low & 1u) != 0))
+            quotient = next;
+    }
+
+    precise double result = quotient * Pow2(exponentA - exponentB);
+    return result;
+}
+
+// correctly rounded sqrt, from a newton refined reciprocal root of the mantissa and the exact residual
+double Sqrt(double x)
+{
+    if (x <= 0)
+        return 0;
+
+    int exponent = Exponent(x);
+    if (exponent == 1024)
+        return x;
+
+    // subnormals are scaled up first, the root of 2^54 is 2^27
+    precise double scale = 1;
+    if (exponent == -1023)
+    {
+        x = x * Pow2(54);
+        scale = Pow2(-27);
+        exponent = Exponent(x);
+    }
+
+    int k = exponent >> 1;
+    precise double m = x * Pow2(-k) * Pow2(-k); // [1, 4)
+
+    precise double inverse = double(rsqrt(float(m)));
+    inverse = inverse * (1.5 - 0.5 * m * inverse * inverse);
+    inverse = inverse * (1.5 - 0.5 * m * inverse * inverse);
+
+    precise double root = m * inverse;
+    precise double error;
+    precise double square = TwoProduct(root, root, error);
+    root = root + 0.5 * inverse * ((m - square) - error);
+
+    square = TwoProduct(root, root, error);
+    precise double residual = (m - square) - error;
+    if (residual > 0)
+    {
+        double next = NextMagnitude(root, true);
+        precise double midpoint = root * (next - root);
+        if (residual > midpoint)
+            root = next;
+    }
+    else if (residual < 0)
+    {
+        double next = NextMagnitude(root, false);
+        precise double midpoint = root * (root - next);
+        if (-residual >= midpoint)
+            root = next;
+    }
+
+    precise double result = root * Pow2(k) * scale;
+    return result;
+}
+
+// pow(x, 1/3.) like the cpu, which is not quite the cube root as 1/3. is short of a third by d = 2^-54 / 3.
+// the cube root is refined to beyond double precision and then scaled by x^-d = 1 - d ln x
+double PowOneThird(double x)
+{
+    if (x <= 0)
+        return 0;
+
+    int exponent = Exponent(x);
+    if (exponent == 1024)
+        return x;
+
+    // subnormals are scaled up first, the cube root of 2^54 is 2^18
+    precise double scale = 1;
+    int shift = 0;
+    if (exponent == -1023)
+    {
+        x = x * Pow2(54);
+        scale = Pow2(-18);
+        shift = 54;
+        exponent = Exponent(x);
+    }
+
+    int k = (exponent >= 0 ? exponent : exponent - 2) / 3;
+    precise double m = x * Pow2(-k) * Pow2(-2 * k); // [1, 8)
+
+    precise double inverse = double(exp2(-log2(float(m)) / 3));
+    inverse = inverse + inverse * (1 - m * inverse * inverse * inverse) * ONE_THIRD;
+    inverse = inverse + inverse * (1 - m * inverse * inverse * inverse) * ONE_THIRD;
+
+    precise double root = m * inverse * inverse;
+    precise double squareError;
+    precise double square = TwoProduct(root, root, squareError);
+    precise double cubeError;
+    precise double cube = TwoProduct(root, square, cubeError);
+    precise double residual = (m - cube) - (cubeError + root * squareError);
+
+    precise double lnX = double(log(float(m))) + (k * 3 - shift) * LN_2;
+    precise double d = asdouble(0x55555555u, 0x3c755555u);
+    root = root + (residual * inverse * inverse * ONE_THIRD - root * d * lnX);
+
+    precise double result = root * Pow2(k) * scale;
+    return result;
+}
+
+// acos and cos have no double precision intrinsics, these are fdlibm's, which is within an ulp of the cpu's libm
+double Acos(double x)
+{
+    uint ix = HighWord(x) & 0x7FFFFFFFu;
+    if (ix >= 0x3FF00000u) // x is clamped to [-1, 1]
+    {
+        precise double pi = PI + 2 * PIO2_LO;
+        return x > 0 ? 0 : pi;
+    }
+
+    if (ix < 0x3FE00000u)
+    {
+        if (ix <= 0x3C600000u)
+        {
+            precise double halfPi = PIO2_HI + PIO2_LO;
+            return halfPi;
+        }
+
+        precise double z = x * x;
+        precise double p = z * (PS0 + z * (PS1 + z * (PS2 + z * (PS3 + z * (PS4 + z * PS5)))));
+        precise double q = 1 + z * (QS1 + z * (QS2 + z * (QS3 + z * QS4)));
+        precise double r = Div(p, q);
+        precise double result = PIO2_HI - (x - (PIO2_LO - x * r));
+        return result;
+    }
+
+    if (x < 0)
+    {
+        precise double z = (1 + x) * 0.5;
+        precise double p = z * (PS0 + z * (PS1 + z * (PS2 + z * (PS3 + z * (PS4 + z * PS5)))));
+        precise double q = 1 + z * (QS1 + z * (QS2 + z * (QS3 + z * QS4)));
+        precise double s = Sqrt(z);
+        precise double r = Div(p, q);
+        precise double w = r * s - PIO2_LO;
+        precise double result = PI - 2 * (s + w);
+        return result;
+    }
+
+    precise double z = (1 - x) * 0.5;
+    precise double s = Sqrt(z);
+    precise double df = asdouble(0u, HighWord(s));
+    precise double c = Div(z - df * df, s + df);
+    precise double p = z * (PS0 + z * (PS1 + z * (PS2 + z * (PS3 + z * (PS4 + z * PS5)))));
+    precise double q = 1 + z * (QS1 + z * (QS2 + z * (QS3 + z * QS4)));
+    precise double r = Div(p, q);
+    precise double w = r * s + c;
+    precise double result = 2 * (df + w);
+    return result;
+}
+
+// cos and sin of x + y on [-pi/4, pi/4]
+double KernelCos(double x, double y)
+{
+    uint ix = HighWord(x) & 0x7FFFFFFFu;
+    if (ix < 0x3E400000u)
+        return 1;
+
+    precise double z = x * x;
+    precise double r = z * (C1 + z * (C2 + z * (C3 + z * (C4 + z * (C5 + z * C6)))));
+    if (ix < 0x3FD33333u)
+    {
+        precise double result = 1 - (0.5 * z - (z * r - x * y));
+        return result;
+    }
+
+    precise double qx = ix > 0x3FE90000u ? 0.28125 : asdouble(0u, ix - 0x00200000u);
+    precise double hz = 0.5 * z - qx;
+    precise double a = 1 - qx;
+    precise double result = a - (hz - (z * r - x * y));
+    return result;
+}
+
+double KernelSin(double x, double y)
+{
+    uint ix = HighWord(x) & 0x7FFFFFFFu;
+    if (ix < 0x3E400000u)
+        return x;
+
+    precise double z = x * x;
+    precise double v = z * x;
+    precise double r = S2 + z * (S3 + z * (S4 + z * (S5 + z * S6)));
+    precise double result = x - ((z * (0.5 * y - v * r) - y) - v * S1);
+    return result;
+}
+
+// only for |x| <= pi, which is all SolveCubicNormed asks for
+double Cos(double x)
+{
+    precise double t = abs(x);
+    uint ix = HighWord(t);
+    if (ix <= 0x3FE921FBu)
+        return KernelCos(t, 0);
+
+    // __ieee754_rem_pio2, with as many parts of pi/2 as the cancellation needs
+    int n = int(t * INV_PIO2 + 0.5);
+    precise double fn = double(n);
+    precise double r = t - fn * PIO2_1;
+    precise double w = fn * PIO2_1T;
+    precise double y0 = r - w;
+
+    int j = int(ix >> 20);
+    if (j - int((HighWord(y0) >> 20) & 0x7FFu) > 16)
+    {
+        precise double u = r;
+        w = fn * PIO2_2;
+        r = u - w;
+        w = fn * PIO2_2T - ((u - r) - w);
+        y0 = r - w;
+
+        if (j - int((HighWord(y0) >> 20) & 0x7FFu) > 49)
+        {
+            u = r;
+            w = fn * PIO2_3;
+            r = u - w;
+            w = fn * PIO2_3T - ((u - r) - w);
+            y0 = r - w;
+        }
+    }
+
+    precise double y1 = (r - y0) - w;
+    switch (n & 3)
+    {
+    case 0:
+        return KernelCos(y0, y1);
+    case 1:
+        return -KernelSin(y0, y1);
+    case 2:
+        return -KernelCos(y0, y1);
+    default:
+        return KernelSin(y0, y1);
+    }
+}
+
+double Dot(double2 a, double2 b)
+{
+    precise double result = a.x * b.x + a.y * b.y;
+    return result;
+}
+
+double Cross(double2 a, double2 b)
+{
+    precise double result = a.x * b.y - a.y * b.x;
+    return result;
+}
+
+double Length(double2 v)
+{
+    precise double squaredLength = v.x * v.x + v.y * v.y;
+    return Sqrt(squaredLength);
+}
+
+double2 Normalize(double2 v, bool allowZero)
+{
+    double length = Length(v);
+    if (length == 0)
+        return double2(0, allowZero ? 0 : 1);
+
+    return double2(Div(v.x, length), Div(v.y, length));
+}
+
+double NonZeroSign(double n)
+{
+    return n > 0 ? 1 : -1;
+}
+
+// msdfgen's min and max keep a when the comparison fails, unlike the intrinsics with nan or signed zeros
+double Min(double a, double b)
+{
+    return b < a ? b : a;
+}
+
+double Max(double a, double b)
+{
+    return a < b ? b : a;
+}
+
+double Median(double a, double b, double c)
+{
+    return Max(Min(a, b), Min(Max(a, b), c));
+}
+
+int SolveQuadratic(out double2 x, double a, double b, double c)
+{
+    x = double2(0, 0);
+
+    precise double aLimit = TOO_LARGE_RATIO * abs(a);
+    precise double bcSum = abs(b) + abs(c);
+    if (a == 0 || bcSum > aLimit)
+    {
+        precise double bLimit = TOO_LARGE_RATIO * abs(b);
+        if (b == 0 || abs(c) > bLimit)
+            return c == 0 ? -1 : 0;
+
+        x.x = Div(-c, b);
+        return 1;
+    }
+
+    precise double discriminant = b * b - 4 * a * c;
+    if (discriminant > 0)
+    {
+        discriminant = Sqrt(discriminant);
+        x.x = Div(-b + discriminant, 2 * a);
+        x.y = Div(-b - discriminant, 2 * a);
+        return 2;
+    }
+    else if (discriminant == 0)
+    {
+        x.x = Div(-b, 2 * a);
+        return 1;
+    }
+
+    return 0;
+}
+
+// msdfgen's solveCubicNormed operation for operation
+int SolveCubicNormed(out double3 x, double a, double b, double c)
+{
+    precise double a2 = a * a;
+    precise double q = Div(a2 - 3 * b, 9);
+    precise double r = Div(a * (2 * a2 - 9 * b) + 27 * c, 54);
+    precise double r2 = r * r;
+    precise double q3 = q * q * q;
+
+    if (r2 < q3)
+    {
+        precise double t = Div(r, Sqrt(q3));
+        if (t < -1)
+            t = -1;
+        if (t > 1)
+            t = 1;
+
+        t = Acos(t);
+        precise double a3 = Div(a, 3);
+        precise double m = -2 * Sqrt(q);
+
+        precise double x0 = m * Cos(Div(t, 3)) - a3;
+        precise double x1 = m * Cos(Div(t + 2 * PI, 3)) - a3;
+        precise double x2 = m * Cos(Div(t - 2 * PI, 3)) - a3;
+        x = double3(x0, x1, x2);
+        return 3;
+    }
+
+    precise double A = -PowOneThird(abs(r) + Sqrt(r2 - q3));
+    if (r < 0)
+        A = -A;
+
+    precise double B = A == 0 ? 0 : Div(q, A);
+    precise double a3 = Div(a, 3);
+
+    precise double x0 = (A + B) - a3;
+    precise double x1 = -0.5 * (A + B) - a3;
+    precise double x2 = 0.5 * SQRT_3 * (A - B);
+    x = double3(x0, x1, x2);
+
+    return abs(x2) < ROOT_EPSILON ? 2 : 1;
+}
+
+int SolveCubic(out double3 x, double a, double b, double c, double d)
+{
+    if (a != 0)
+    {
+        double bn = Div(b, a), cn = Div(c, a), dn = Div(d, a);
+        if (abs(bn) < TOO_LARGE_RATIO && abs(cn) < TOO_LARGE_RATIO && abs(dn) < TOO_LARGE_RATIO)
+            return SolveCubicNormed(x, bn, cn, dn);
+    }
+
+    double2 quadratic;
+    int solutions = SolveQuadratic(quadratic, b, c, d);
+
+    x = double3(quadratic, 0);
+    return solutions;
+}
+
+double2 ControlPoint(EdgeData edge, uint index)
+{
+    return double2(edge.P[index * 2], edge.P[index * 2 + 1]);
+}
+
+// point(0) and point(1)
+double2 EndPoint(EdgeData edge, uint end)
+{
+    return ControlPoint(edge, end == 0 ? 0 : edge.Degree);
+}
+
+// direction(0) and direction(1)
+double2 Direction(EdgeData edge, uint end)
+{
+    double2 p0 = ControlPoint(edge, 0);
+    double2 p1 = ControlPoint(edge, 1);
+    double2 p2 = ControlPoint(edge, 2);
+    double2 p3 = ControlPoint(edge, 3);
+
+    if (edge.Degree == 1)
+        return p1 - p0;
+
+    if (edge.Degree == 2)
+    {
+        double2 tangent = end == 0 ? p1 - p0 : p2 - p1;
+        if (tangent.x == 0 && tangent.y == 0)
+            return p2 - p0;
+
+        return tangent;
+    }
+
+    double2 tangent = end == 0 ? p1 - p0 : p3 - p2;
+    if (tangent.x == 0 && tangent.y == 0)
+        return end == 0 ? p2 - p0 : p3 - p1;
+
+    return tangent;
+}
+
+struct SignedDistance
+{
+    double Distance;
+    double Dot;
+};
+
+SignedDistance CreateSignedDistance(double distance, double dot)
+{
+    SignedDistance result;
+    result.Distance = distance;
+    result.Dot = dot;
+    return result;
+}
+
+bool IsCloser(SignedDistance a, SignedDistance b)
+{
+    return abs(a.Distance) < abs(b.Distance) || (abs(a.Distance) == abs(b.Distance) && a.Dot < b.Dot);
+}
+
+SignedDistance LinearSignedDistance(EdgeData edge, double2 origin, out double param)
+{
+    double2 p0 = ControlPoint(edge, 0);
+    double2 p1 = ControlPoint(edge, 1);
+
+    double2 aq = origin - p0;
+    double2 ab = p1 - p0;
+    param = Div(Dot(aq, ab), Dot(ab, ab));
+
+    double2 eq = (param > 0.5 ? p1 : p0) - origin;
+    double endpointDistance = Length(eq);
+    if (param > 0 && param < 1)
+    {
+        double length = Length(ab);
+        double2 orthonormal = length == 0 ? double2(0, -1) : double2(Div(ab.y, length), Div(-ab.x, length));
+
+        double orthoDistance = Dot(orthonormal, aq);
+        if (abs(orthoDistance) < endpointDistance)
+            return CreateSignedDistance(orthoDistance, 0);
+    }
+
+    return CreateSignedDistance(NonZeroSign(Cross(aq, ab)) * endpointDistance, abs(Dot(Normalize(ab, false), Normalize(eq, false))));
+}
+
+SignedDistance QuadraticSignedDistance(EdgeData edge, double2 origin, out double param)
+{
+    double2 p0 = ControlPoint(edge, 0);
+    double2 p1 = ControlPoint(edge, 1);
+    double2 p2 = ControlPoint(edge, 2);
+
+    double2 qa = p0 - origin;
+    double2 ab = p1 - p0;
+    double2 br = p2 - p1 - ab;
+    double a = Dot(br, br);
+    precise double b = 3 * Dot(ab, br);
+    precise double c = 2 * Dot(ab, ab) + Dot(qa, br);
+    double d = Dot(qa, ab);
+
+    double3 t;
+    int solutions = SolveCubic(t, a, b, c, d);
+
+    double2 epDir = Direction(edge, 0);
+    double minDistance = NonZeroSign(Cross(epDir, qa)) * Length(qa);
+    param = Div(-Dot(qa, epDir), Dot(epDir, epDir));
+    {
+        epDir = Direction(edge, 1);
+        double distance = Length(p2 - origin);
+        if (distance < abs(minDistance))
+        {
+            minDistance = NonZeroSign(Cross(epDir, p2 - origin)) * distance;
+            param = Div(Dot(origin - p1, epDir), Dot(epDir, epDir));
+        }
+    }
+
+    for (int i = 0; i < solutions; i++)
+    {
+        if (t[i] > 0 && t[i] < 1)
+        {
+            precise double2 qe = qa + 2 * t[i] * ab + t[i] * t[i] * br;
+            double distance = Length(qe);
+            if (distance <= abs(minDistance))
+            {
+                precise double2 tangent = ab + t[i] * br;
+                minDistance = NonZeroSign(Cross(tangent, qe)) * distance;
+                param = t[i];
+            }
+        }
+    }
+
+    if (param >= 0 && param <= 1)
+        return CreateSignedDistance(minDistance, 0);
+    if (param < 0.5)
+        return CreateSignedDistance(minDistance, abs(Dot(Normalize(Direction(edge, 0), false), Normalize(qa, false))));
+
+    return CreateSignedDistance(minDistance, abs(Dot(Normalize(Direction(edge, 1), false), Normalize(p2 - origin, false))));
+}
+
+SignedDistance CubicSignedDistance(EdgeData edge, double2 origin, out double param)
+{
+    double2 p0 = ControlPoint(edge, 0);
+    double2 p1 = ControlPoint(edge, 1);
+    double2 p2 = ControlPoint(edge, 2);
+    double2 p3 = ControlPoint(edge, 3);
+
+    double2 qa = p0 - origin;
+    double2 ab = p1 - p0;
+    double2 br = p2 - p1 - ab;
+    double2 ac = (p3 - p2) - (p2 - p1) - br;
+
+    double2 epDir = Direction(edge, 0);
+    double minDistance = NonZeroSign(Cross(epDir, qa)) * Length(qa);
+    param = Div(-Dot(qa, epDir), Dot(epDir, epDir));
+    {
+        epDir = Direction(edge, 1);
+        double distance = Length(p3 - origin);
+        if (distance < abs(minDistance))
+        {
+            minDistance = NonZeroSign(Cross(epDir, p3 - origin)) * distance;
+            param = Div(Dot(epDir - (p3 - origin), epDir), Dot(epDir, epDir));
+        }
+    }
+
+    // MSDFGEN_CUBIC_SEARCH_STARTS and MSDFGEN_CUBIC_SEARCH_STEPS
+    for (int i = 0; i <= 4; i++)
+    {
+        precise double t = Div(double(i), 4);
+        precise double2 qe = qa + 3 * t * ab + 3 * t * t * br + t * t * t * ac;
+        for (int step = 0; step < 4; step++)
+        {
+            precise double2 d1 = 3 * ab + 6 * t * br + 3 * t * t * ac;
+            precise double2 d2 = 6 * br + 6 * t * ac;
+            precise double denominator = Dot(d1, d1) + Dot(qe, d2);
+            t -= Div(Dot(qe, d1), denominator);
+            if (t <= 0 || t >= 1)
+                break;
+
+            qe = qa + 3 * t * ab + 3 * t * t * br + t * t * t * ac;
+            double distance = Length(qe);
+            if (distance < abs(minDistance))
+            {
+                minDistance = NonZeroSign(Cross(d1, qe)) * distance;
+                param = t;
+            }
+        }
+    }
+
+    if (param >= 0 && param <= 1)
+        return CreateSignedDistance(minDistance, 0);
+    if (param < 0.5)
+        return CreateSignedDistance(minDistance, abs(Dot(Normalize(Direction(edge, 0), false), Normalize(qa, false))));
+
+    return CreateSignedDistance(minDistance, abs(Dot(Normalize(Direction(edge, 1), false), Normalize(p3 - origin, false))));
+}
+
+SignedDistance EdgeSignedDistance(EdgeData edge, double2 origin, out double param)
+{
+    if (edge.Degree == 1)
+        return LinearSignedDistance(edge, origin, param);
+    if (edge.Degree == 2)
+        return QuadraticSignedDistance(edge, origin, param);
+
+    return CubicSignedDistance(edge, origin, param);
+}
+
+void DistanceToPseudoDistance(EdgeData edge, inout SignedDistance distance, double2 origin, double param)
+{
+    if (param < 0)
+    {
+        double2 dir = Normalize(Direction(edge, 0), false);
+        double2 aq = origin - EndPoint(edge, 0);
+        double ts = Dot(aq, dir);
+        if (ts < 0)
+        {
+            double pseudoDistance = Cross(aq, dir);
+            if (abs(pseudoDistance) <= abs(distance.Distance))
+            {
+                distance.Distance = pseudoDistance;
+                distance.Dot = 0;
+            }
+        }
+    }
+    else if (param > 1)
+    {
+        double2 dir = Normalize(Direction(edge, 1), false);
+        double2 bq = origin - EndPoint(edge, 1);
+        double ts = Dot(bq, dir);
+        if (ts > 0)
+        {
+            double pseudoDistance = Cross(bq, dir);
+            if (abs(pseudoDistance) <= abs(distance.Distance))
+            {
+                distance.Distance = pseudoDistance;
+                distance.Dot = 0;
+            }
+        }
+    }
+}
+
+bool GetPseudoDistance(inout double distance, double2 ep, double2 edgeDir)
+{
+    double ts = Dot(ep, edgeDir);
+    if (ts > 0)
+    {
+        double pseudoDistance = Cross(ep, edgeDir);
+        if (abs(pseudoDistance) < abs(distance))
+        {
+            distance = pseudoDistance;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+// PseudoDistanceSelectorBase, msdf keeps one per channel and sdf only uses the true distance of the first
+struct ChannelSelector
+{
+    SignedDistance MinTrueDistance;
+    double MinNegativePseudoDistance;
+    double MinPositivePseudoDistance;
+    int NearEdge; // -1 = none
+    double NearEdgeParam;
+};
+
+struct Selector
+{
+    ChannelSelector Channels[3];
+};
+
+// pass 0 leaves the selector of every contour at every texel here for pass 1 to combine
+[[vk::binding(6, 0)]]
+RWStructuredBuffer<Selector> r_ContourSelectors;
+
+Selector CreateSelector()
+{
+    ChannelSelector channel;
+    channel.MinTrueDistance = CreateSignedDistance(-INFINITE_DISTANCE, 1);
+    channel.MinNegativePseudoDistance = -INFINITE_DISTANCE;
+    channel.MinPositivePseudoDistance = INFINITE_DISTANCE;
+    channel.NearEdge = -1;
+    channel.NearEdgeParam = 0;
+
+    Selector selector;
+    for (int i = 0; i < 3; i++)
+        selector.Channels[i] = channel;
+
+    return selector;
+}
+
+EdgeCache CreateEdgeCache()
+{
+    EdgeCache cache;
+    cache.PointX = 0;
+    cache.PointY = 0;
+    cache.AbsDistance = 0;
+    cache.ADomainDistance = 0;
+    cache.BDomainDistance = 0;
+    cache.APseudoDistance = 0;
+    cache.BPseudoDistance = 0;
+    cache.Padding = 0;
+    return cache;
+}
+
+// PseudoDistanceSelectorBase::reset and TrueDistanceSelector::reset, delta is how far the texel moved
+void ResetChannel(inout ChannelSelector channel, double delta)
+{
+    precise double distance = channel.MinTrueDistance.Distance + NonZeroSign(channel.MinTrueDistance.Distance) * delta;
+
+    channel.MinTrueDistance.Distance = distance;
+    channel.MinNegativePseudoDistance = -abs(distance);
+    channel.MinPositivePseudoDistance = abs(distance);
+    channel.NearEdge = -1;
+    channel.NearEdgeParam = 0;
+}
+
+void Reset(inout Selector selector, double delta)
+{
+    for (int i = 0; i < 3; i++)
+        ResetChannel(selector.Channels[i], delta);
+}
+
+bool IsEdgeRelevant(ChannelSelector channel, EdgeCache cache, double delta)
+{
+    precise double absDistance = cache.AbsDistance - delta;
+    precise double aNegativePseudoDistance = cache.APseudoDistance + delta;
+    precise double aPositivePseudoDistance = cache.APseudoDistance - delta;
+    precise double bNegativePseudoDistance = cache.BPseudoDistance + delta;
+    precise double bPositivePseudoDistance = cache.BPseudoDistance - delta;
+
+    return absDistance <= abs(channel.MinTrueDistance.Distance) ||
+        abs(cache.ADomainDistance) < delta ||
+        abs(cache.BDomainDistance) < delta ||
+        (cache.ADomainDistance > 0 && (cache.APseudoDistance < 0 ?
+            aNegativePseudoDistance >= channel.MinNegativePseudoDistance :
+            aPositivePseudoDistance <= channel.MinPositivePseudoDistance)) ||
+        (cache.BDomainDistance > 0 && (cache.BPseudoDistance < 0 ?
+            bNegativePseudoDistance >= channel.MinNegativePseudoDistance :
+            bPositivePseudoDistance <= channel.MinPositivePseudoDistance));
+}
+
+void AddEdgeTrueDistance(inout ChannelSelector channel, int edge, SignedDistance distance, double param)
+{
+    if (IsCloser(distance, channel.MinTrueDistance))
+    {
+        channel.MinTrueDistance = distance;
+        channel.NearEdge = edge;
+        channel.NearEdgeParam = param;
+    }
+}
+
+void AddEdgePseudoDistance(inout ChannelSelector channel, double distance)
+{
+    if (distance <= 0 && distance > channel.MinNegativePseudoDistance)
+        channel.MinNegativePseudoDistance = distance;
+    if (distance >= 0 && distance < channel.MinPositivePseudoDistance)
+        channel.MinPositivePseudoDistance = distance;
+}
+
+void MergeChannel(inout ChannelSelector channel, ChannelSelector other)
+{
+    if (IsCloser(other.MinTrueDistance, channel.MinTrueDistance))
+    {
+        channel.MinTrueDistance = other.MinTrueDistance;
+        channel.NearEdge = other.NearEdge;
+        channel.NearEdgeParam = other.NearEdgeParam;
+    }
+    if (other.MinNegativePseudoDistance > channel.MinNegativePseudoDistance)
+        channel.MinNegativePseudoDistance = other.MinNegativePseudoDistance;
+    if (other.MinPositivePseudoDistance < channel.MinPositivePseudoDistance)
+        channel.MinPositivePseudoDistance = other.MinPositivePseudoDistance;
+}
+
+void Merge(inout Selector selector, Selector other)
+{
+    for (int i = 0; i < 3; i++)
+        MergeChannel(selector.Channels[i], other.Channels[i]);
+}
+
+double ComputeDistance(ChannelSelector channel, double2 p)
+{
+    double minDistance = channel.MinTrueDistance.Distance < 0 ? channel.MinNegativePseudoDistance : channel.MinPositivePseudoDistance;
+    if (channel.NearEdge >= 0)
+    {
+        SignedDistance distance = channel.MinTrueDistance;
+        DistanceToPseudoDistance(r_Edges[channel.NearEdge], distance, p, channel.NearEdgeParam);
+        if (abs(distance.Distance) < abs(minDistance))
+            minDistance = distance.Distance;
+    }
+
+    return minDistance;
+}
+
+// TrueDistanceSelector, MultiDistanceSelector or MultiAndTrueDistanceSelector::addEdge.
+// edges that cannot beat the minimums since the cache was last filled are skipped, exactly as on the cpu
+void AddEdge(inout Selector selector, inout EdgeCache cache, int edgeIndex, EdgeData prevEdge, EdgeData edge, EdgeData nextEdge, double2 p)
+{
+    precise double delta = DISTANCE_DELTA_FACTOR * Length(p - double2(cache.PointX, cache.PointY));
+    double param;
+
+    if (c_ChannelCount == 1)
+    {
+        precise double absDistance = cache.AbsDistance - delta;
+        if (absDistance <= abs(selector.Channels[0].MinTrueDistance.Distance))
+        {
+            SignedDistance distance = EdgeSignedDistance(edge, p, param);
+            if (IsCloser(distance, selector.Channels[0].MinTrueDistance))
+                selector.Channels[0].MinTrueDistance = distance;
+
+            cache.PointX = p.x;
+            cache.PointY = p.y;
+            cache.AbsDistance = abs(distance.Distance);
+        }
+
+        return;
+    }
+
+    bool relevant = false;
+    for (int i = 0; i < 3; i++)
+    {
+        if ((edge.Color & (1u << i)) != 0 && IsEdgeRelevant(selector.Channels[i], cache, delta))
+            relevant = true;
+    }
+
+    if (!relevant)
+        return;
+
+    SignedDistance distance = EdgeSignedDistance(edge, p, param);
+    for (int i = 0; i < 3; i++)
+    {
+        if (edge.Color & (1u << i))
+            AddEdgeTrueDistance(selector.Channels[i], edgeIndex, distance, param);
+    }
+
+    cache.PointX = p.x;
+    cache.PointY = p.y;
+    cache.AbsDistance = abs(distance.Distance);
+
+    double2 ap = p - EndPoint(edge, 0);
+    double2 bp = p - EndPoint(edge, 1);
+    double2 aDir = Normalize(Direction(edge, 0), true);
+    double2 bDir = Normalize(Direction(edge, 1), true);
+    double2 prevDir = Normalize(Direction(prevEdge, 1), true);
+    double2 nextDir = Normalize(Direction(nextEdge, 0), true);
+    double add = Dot(ap, Normalize(prevDir + aDir, true));
+    double bdd = -Dot(bp, Normalize(bDir + nextDir, true));
+
+    if (add > 0)
+    {
+        double pd = distance.Distance;
+        if (GetPseudoDistance(pd, ap, -aDir))
+        {
+            pd = -pd;
+            for (int i = 0; i < 3; i++)
+            {
+                if (edge.Color & (1u << i))
+                    AddEdgePseudoDistance(selector.Channels[i], pd);
+            }
+        }
+
+        cache.APseudoDistance = pd;
+    }
+
+    if (bdd > 0)
+    {
+        double pd = distance.Distance;
+        if (GetPseudoDistance(pd, bp, bDir))
+        {
+            for (int i = 0; i < 3; i++)
+            {
+                if (edge.Color & (1u << i))
+                    AddEdgePseudoDistance(selector.Channels[i], pd);
+            }
+        }
+
+        cache.BPseudoDistance = pd;
+    }
+
+    cache.ADomainDistance = add;
+    cache.BDomainDistance = bdd;
+}
+
+// r, g, b and the true distance in a, only x for sdf
+double4 GetDistance(Selector selector, double2 p)
+{
+    if (c_ChannelCount == 1)
+        return double4(selector.Channels[0].MinTrueDistance.Distance, 0, 0, 0);
+
+    SignedDistance trueDistance = selector.Channels[0].MinTrueDistance;
+    if (IsCloser(selector.Channels[1].MinTrueDistance, trueDistance))
+        trueDistance = selector.Channels[1].MinTrueDistance;
+    if (IsCloser(selector.Channels[2].MinTrueDistance, trueDistance))
+        trueDistance = selector.Channels[2].MinTrueDistance;
+
+    return double4(
+        ComputeDistance(selector.Channels[0], p),
+        ComputeDistance(selector.Channels[1], p),
+        ComputeDistance(selector.Channels[2], p),
+        trueDistance.Distance
+    );
+}
+
+double ResolveDistance(double4 distance)
+{
+    return c_ChannelCount == 1 ? distance.x : Median(distance.x, distance.y, distance.z);
+}
+
+// the edge loop of ShapeDistanceFinder::distance, edges are visited starting with the last one
+void AddContourEdges(inout Selector selector, ContourData contour, double2 p)
+{
+    if (contour.EdgeCount == 0)
+        return;
+
+    uint edgeCount = contour.EdgeCount;
+
+    EdgeData prevEdge = r_Edges[contour.FirstEdge + (edgeCount >= 2 ? edgeCount - 2 : 0)];
+    EdgeData edge = r_Edges[contour.FirstEdge + edgeCount - 1];
+    uint edgeIndex = contour.FirstEdge + edgeCount - 1;
+
+    for (uint j = 0; j < edgeCount; j++)
+    {
+        EdgeData nextEdge = r_Edges[contour.FirstEdge + j];
+
+        // the cache belongs to the j-th edge of the contour, not to the edge being added
+        EdgeCache cache = r_EdgeCaches[contour.FirstEdge + j];
+        AddEdge(selector, cache, int(edgeIndex), prevEdge, edge, nextEdge, p);
+        r_EdgeCaches[contour.FirstEdge + j] = cache;
+
+        prevEdge = edge;
+        edge = nextEdge;
+        edgeIndex = contour.FirstEdge + j;
+    }
+}
+
+double2 GetTexelPosition(GlyphData glyph, uint x, uint y)
+{
+    return double2(r_Coordinates[glyph.FirstCoordinate + x], r_Coordinates[glyph.FirstCoordinate + glyph.Width + y]);
+}
+
+// msdfgen carries the selector of every contour and the edge caches from texel to texel, and which edges it
+// skips depends on them. a contour's state never depends on the other contours though, so every contour
+// walks the glyph on its own in the cpu's order: rows from the bottom, alternating left to right and right to left
+void TraceContour(uint contourIndex)
+{
+    ContourData contour = r_Contours[contourIndex];
+    GlyphData glyph = r_Glyphs[contour.Glyph];
+    uint contourInGlyph = contourIndex - glyph.FirstContour;
+
+    // a new ShapeDistanceFinder, its selectors and caches were last at the origin
+    Selector selector = CreateSelector();
+    for (uint j = 0; j < contour.EdgeCount; j++)
+        r_EdgeCaches[contour.FirstEdge + j] = CreateEdgeCache();
+
+    double2 lastP = double2(0, 0);
+    bool rightToLeft = false;
+
+    for (uint y = 0; y < glyph.Height; y++)
+    {
+        for (uint column = 0; column < glyph.Width; column++)
+        {
+            uint x = rightToLeft ? glyph.Width - column - 1 : column;
+            double2 p = GetTexelPosition(glyph, x, y);
+
+            // OverlappingContourCombiner::reset
+            precise double delta = DISTANCE_DELTA_FACTOR * Length(p - lastP);
+            Reset(selector, delta);
+
+            AddContourEdges(selector, contour, p);
+            lastP = p;
+
+            r_ContourSelectors[glyph.FirstSelector + (y * glyph.Width + x) * glyph.ContourCount + contourInGlyph] = selector;
+        }
+
+        rightToLeft = !rightToLeft;
+    }
+}
+
+// OverlappingContourCombiner::distance over the selectors pass 0 left for the texel
+double4 CombineContours(GlyphData glyph, uint x, uint y, double2 p)
+{
+    double4 contourDistances[MAX_CONTOURS];
+
+    Selector shapeSelector = CreateSelector();
+    Selector innerSelector = CreateSelector();
+    Selector outerSelector = CreateSelector();
+
+    uint firstSelector = glyph.FirstSelector + (y * glyph.Width + x) * glyph.ContourCount;
+
+    for (uint i = 0; i < glyph.ContourCount; i++)
+    {
+        Selector selector = r_ContourSelectors[firstSelector + i];
+        int winding = r_Contours[glyph.FirstContour + i].Winding;
+
+        double4 edgeDistance = GetDistance(selector, p);
+        contourDistances[i] = edgeDistance;
+
+        Merge(shapeSelector, selector);
+        if (winding > 0 && ResolveDistance(edgeDistance) >= 0)
+            Merge(innerSelector, selector);
+        if (winding < 0 && ResolveDistance(edgeDistance) <= 0)
+            Merge(outerSelector, selector);
+    }
+
+    double4 shapeDistance = GetDistance(shapeSelector, p);
+    double4 innerDistance = GetDistance(innerSelector, p);
+    double4 outerDistance = GetDistance(outerSelector, p);
+    double innerScalarDistance = ResolveDistance(innerDistance);
+    double outerScalarDistance = ResolveDistance(outerDistance);
+
+    double4 distance = shapeDistance;
+    int winding = 0;
+
+    if (innerScalarDistance >= 0 && abs(innerScalarDistance) <= abs(outerScalarDistance))
+    {
+        distance = innerDistance;
+        winding = 1;
+        for (uint i = 0; i < glyph.ContourCount; i++)
+        {
+            double4 contourDistance = contourDistances[i];
+            if (r_Contours[glyph.FirstContour + i].Winding > 0 &&
+                abs(ResolveDistance(contourDistance)) < abs(outerScalarDistance) && ResolveDistance(contourDistance) > ResolveDistance(distance))
+                distance = contourDistance;
+        }
+    }
+    else if (outerScalarDistance <= 0 && abs(outerScalarDistance) < abs(innerScalarDistance))
+    {
+        distance = outerDistance;
+        winding = -1;
+        for (uint i = 0; i < glyph.ContourCount; i++)
+        {
+            double4 contourDistance = contourDistances[i];
+            if (r_Contours[glyph.FirstContour + i].Winding < 0 &&
+                abs(ResolveDistance(contourDistance)) < abs(innerScalarDistance) && ResolveDistance(contourDistance) < ResolveDistance(distance))
+                distance = contourDistance;
+        }
+    }
+
+    if (winding != 0)
+    {
+        for (uint i = 0; i < glyph.ContourCount; i++)
+        {
+            double4 contourDistance = contourDistances[i];
+            if (r_Contours[glyph.FirstContour + i].Winding != winding &&
+                ResolveDistance(contourDistance) * ResolveDistance(distance) >= 0 && abs(ResolveDistance(contourDistance)) < abs(ResolveDistance(distance)))
+                distance = contourDistance;
+        }
+
+        if (ResolveDistance(distance) == ResolveDistance(shapeDistance))
+            distance = shapeDistance;
+    }
+
+    return distance;
+}
+
+// pass 0: DTid.x is the contour. pass 1: DTid.x is the texel and DTid.y the glyph
+[numthreads(64, 1, 1)]
+void CShader(uint3 DTid : SV_DispatchThreadID)
+{
+    if (c_Pass == 0)
+    {
+        if (DTid.x < u_ContourCount)
+            TraceContour(u_FirstContour + DTid.x);
+
+        return;
+    }
+
+    if (DTid.y >= u_GlyphCount)
+        return;
+
+    GlyphData glyph = r_Glyphs[u_FirstGlyph + DTid.y];
+    if (DTid.x >= glyph.Width * glyph.Height)
+        return;
+
+    uint x = DTid.x % glyph.Width;
+    uint y = DTid.x / glyph.Width;
+
+    double4 distance = CombineContours(glyph, x, y, GetTexelPosition(glyph, x, y));
+
+    // DistancePixelConversion
+    uint row = glyph.InverseY != 0 ? glyph.Height - y - 1 : y;
+    uint offset = glyph.OutputOffset + (row * glyph.Width + x) * c_ChannelCount;
+
+    for (uint c = 0; c < c_ChannelCount; c++)
+    {
+        precise double value = glyph.InvRange * distance[c] + 0.5;
+        r_Output[offset + c] = float(value);
+    }
+}
@@ -46,7 +46,6 @@ namespace bloom {
     struct BlurPushConstants
     {
         glm::ivec2 FullSize;
-        int Horizontal;
     };
 
     struct CombinePushConstants
@@ -182,6 +181,9 @@ namespace bloom {
         wire::ComputePipelineDesc computeInfo{};
         computeInfo.Layout = computeLayout;
         computeInfo.ShaderPath = "shadercache://BloomBrightPassDownsample.compute.hlsl";
+        computeInfo.CompileAsync = true;
+        // the kernels bounds check every thread, so any tile shape works and the fastest is kept per device
+        computeInfo.WorkgroupSizeCandidates = { { 8, 8, 1 }, { 16, 8, 1 }, { 16, 16, 1 }, { 32, 8, 1 }, { 64, 4, 1 } };
 
         m_BrightPassDownsamplePipeline = m_Device->createComputePipeline(computeInfo, "BloomLayer::m_BrightPassDownsamplePipeline");
 
@@ -224,7 +226,13 @@ namespace bloom {
         };
         computeInfo.Layout = computeLayout;
         computeInfo.ShaderPath = "shadercache://BloomBlur.compute.hlsl";
-        m_BlurPipeline = m_Device->createComputePipeline(computeInfo, "BloomLayer::m_BlurPipeline");
+        computeInfo.SpecializationConstants = { { 0, true } };
+        m_BlurHorizontalPipeline = m_Device->createComputePipeline(computeInfo, "BloomLayer::m_BlurHorizontalPipeline");
+
+        computeInfo.SpecializationConstants = { { 0, false } };
+        m_BlurVerticalPipeline = m_Device->createComputePipeline(computeInfo, "BloomLayer::m_BlurVerticalPipeline");
+
+        computeInfo.SpecializationConstants.clear();
 
         for (size_t i = 0; i < m_MipCount - 2; i++)
         {
@@ -335,6 +343,7 @@ namespace bloom {
         highSamplerInfo.BorderColor = wire::BorderColor::IntOpaqueBlack;
         
         m_UpsampleHighSampler = m_Device->createSampler(highSamplerInfo, "BloomLayer::m_UpsampleHighSampler");
+        framebufferInfo.Usage = wire::AttachmentUsage::Storage | wire::AttachmentUsage::Sampled | wire::AttachmentUsage::TransferDst;
         m_UpsampleFramebuffer = m_Device->createFramebuffer(framebufferInfo, "BloomLayer::m_UpsampleFramebuffer");
 
         std::shared_ptr<wire::Texture2D> blurTexture = m_BlurFramebuffer->asTexture2D();
@@ -510,77 +519,85 @@ namespace bloom {
 
         commandList.imageMemoryBarrier(m_ColorFramebuffer, wire::AttachmentLayout::Color, wire::AttachmentLayout::ShaderReadOnly);
 
-        BrightPassPushConstants brightPassPushConstants{
-            .SourceSize = (glm::ivec2)extent,
-            .DestinationSize = (glm::ivec2)extent / 2,
-            .Threshold = m_Threshold,
-            .Intensity = m_Intensity
-        };
+        // the chain needs all of its pipelines, read once so one finishing while this is recorded cannot split it
+        bool bloomReady = m_BrightPassDownsamplePipeline->isReady() && m_BlurHorizontalPipeline->isReady() && m_BlurVerticalPipeline->isReady() && m_UpsamplePipeline->isReady();
 
-        std::vector<glm::ivec2> sizes;
+        if (bloomReady)
+        {
+            BrightPassPushConstants brightPassPushConstants{
+                .SourceSize = (glm::ivec2)extent,
+                .DestinationSize = (glm::ivec2)extent / 2,
+                .Threshold = m_Threshold,
+                .Intensity = m_Intensity
+            };
 
-        commandList.bindPipeline(m_BrightPassDownsamplePipeline);
+            std::vector<glm::ivec2> sizes;
 
-        sizes.push_back(brightPassPushConstants.SourceSize);
-        for (uint32_t i = 0; i < m_MipCount - 1; i++)
-        {
-            commandList.pushConstants(wire::ShaderType::Compute, brightPassPushConstants);
-            commandList.bindShaderResource(0, m_BrightPassResources[i]);
+            commandList.bindPipeline(m_BrightPassDownsamplePipeline);
 
-            uint32_t groupCountX = ((uint32_t)extent.x + 15) / 16;
-            uint32_t groupCountY = ((uint32_t)extent.y + 15) / 16;
-            commandList.dispatch(groupCountX, groupCountY, 1);
+            sizes.push_back(brightPassPushConstants.SourceSize);
+            for (uint32_t i = 0; i < m_MipCount - 1; i++)
+            {
+                commandList.pushConstants(wire::ShaderType::Compute, brightPassPushConstants);
+                commandList.bindShaderResource(0, m_BrightPassResources[i]);
 
-            commandList.imageMemoryBarrier(m_BrightPassFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, i + 1);
+                commandList.dispatchThreads((uint32_t)brightPassPushConstants.DestinationSize.x, (uint32_t)brightPassPushConstants.DestinationSize.y);
 
-            brightPassPushConstants.SourceSize = brightPassPushConstants.DestinationSize;
-            brightPassPushConstants.DestinationSize /= 2;
+                commandList.imageMemoryBarrier(m_BrightPassFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, i + 1);
 
-            sizes.push_back(brightPassPushConstants.SourceSize);
-        }
+                brightPassPushConstants.SourceSize = brightPassPushConstants.DestinationSize;
+                brightPassPushConstants.DestinationSize /= 2;
 
-        BlurPushConstants blurPushConstants{};
+                sizes.push_back(brightPassPushConstants.SourceSize);
+            }
 
-        commandList.bindPipeline(m_BlurPipeline);
+            BlurPushConstants blurPushConstants{};
 
-        uint32_t sizeIndex = static_cast<uint32_t>(sizes.size()) - 1;
-        for (uint32_t i = 0; i < m_BlurResources.size(); i++)
-        {
-            blurPushConstants.FullSize = sizes[sizeIndex--];
-            blurPushConstants.Horizontal = 1;
+            uint32_t sizeIndex = static_cast<uint32_t>(sizes.size()) - 1;
+            for (uint32_t i = 0; i < m_BlurResources.size(); i++)
+            {
+                blurPushConstants.FullSize = sizes[sizeIndex--];
 
-            commandList.pushConstants(wire::ShaderType::Compute, blurPushConstants);
-            commandList.bindShaderResource(0, m_BlurResources[i][0]);
+                commandList.bindPipeline(m_BlurHorizontalPipeline);
+                commandList.pushConstants(wire::ShaderType::Compute, blurPushConstants);
+                commandList.bindShaderResource(0, m_BlurResources[i][0]);
 
-            uint32_t groupCountX = ((uint32_t)blurPushConstants.FullSize.x + 15) / 16;
-            uint32_t groupCountY = ((uint32_t)blurPushConstants.FullSize.y + 15) / 16;
-            commandList.dispatch(groupCountX, groupCountY, 1);
+                commandList.dispatchThreads((uint32_t)blurPushConstants.FullSize.x, (uint32_t)blurPushConstants.FullSize.y);
 
-            blurPushConstants.Horizontal = 0;
-            commandList.imageMemoryBarrier(m_BlurIntermediateFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, m_MipCount - (i + 1));
+                commandList.imageMemoryBarrier(m_BlurIntermediateFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, m_MipCount - (i + 1));
 
-            commandList.pushConstants(wire::ShaderType::Compute, blurPushConstants);
-            commandList.bindShaderResource(0, m_BlurResources[i][1]);
+                commandList.bindPipeline(m_BlurVerticalPipeline);
+                commandList.pushConstants(wire::ShaderType::Compute, blurPushConstants);
+                commandList.bindShaderResource(0, m_BlurResources[i][1]);
 
-            commandList.dispatch(groupCountX, groupCountY, 1);
-        }
+                commandList.dispatchThreads((uint32_t)blurPushConstants.FullSize.x, (uint32_t)blurPushConstants.FullSize.y);
+            }
 
-        sizeIndex = static_cast<uint32_t>(sizes.size()) - 2;
+            sizeIndex = static_cast<uint32_t>(sizes.size()) - 2;
 
-        commandList.bindPipeline(m_UpsamplePipeline);
+            commandList.bindPipeline(m_UpsamplePipeline);
 
-        commandList.imageMemoryBarrier(m_BrightPassFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, 1);
-        commandList.imageMemoryBarrier(m_BlurFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, m_BlurFramebuffer->getNumMips());
+            commandList.imageMemoryBarrier(m_BrightPassFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, 1);
+            commandList.imageMemoryBarrier(m_BlurFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, m_BlurFramebuffer->getNumMips());
 
-        for (uint32_t i = 0; i < m_UpsampleResources.size(); i++)
-        {
-            commandList.bindShaderResource(0, m_UpsampleResources[i]);
+            for (uint32_t i = 0; i < m_UpsampleResources.size(); i++)
+            {
+                commandList.bindShaderResource(0, m_UpsampleResources[i]);
 
-            uint32_t groupCountX = ((uint32_t)extent.x + 15) / 16;
-            uint32_t groupCountY = ((uint32_t)extent.y + 15) / 16;
-            commandList.dispatch(groupCountX, groupCountY, 1);
+                commandList.dispatchThreads((uint32_t)extent.x, (uint32_t)extent.y);
+
+                commandList.imageMemoryBarrier(m_UpsampleFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, m_MipCount - (i + 2));
+            }
+        }
+        else
+        {
+            // keep the combine input black and leave every mip in the layout the chain would have
+            commandList.clearImage(m_UpsampleFramebuffer, { 0.0f, 0.0f, 0.0f, 0.0f }, wire::AttachmentLayout::General);
 
-            commandList.imageMemoryBarrier(m_UpsampleFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, m_MipCount - (i + 2));
+            commandList.imageMemoryBarrier(m_BrightPassFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, m_MipCount);
+            commandList.imageMemoryBarrier(m_BlurIntermediateFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 2, m_MipCount - 2);
+            commandList.imageMemoryBarrier(m_BlurFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, m_BlurFramebuffer->getNumMips());
+            commandList.imageMemoryBarrier(m_UpsampleFramebuffer, wire::AttachmentLayout::General, wire::AttachmentLayout::ShaderReadOnly, 0, m_MipCount - 1);
         }
 
         CombinePushConstants combinePushConstants{
@@ -40,7 +40,8 @@ namespace bloom {
         std::vector<std::shared_ptr<wire::ShaderResource>> m_BrightPassResources;
         std::shared_ptr<wire::Sampler> m_BrightPassSampler = nullptr;
 
-        std::shared_ptr<wire::ComputePipeline> m_BlurPipeline = nullptr;
+        std::shared_ptr<wire::ComputePipeline> m_BlurHorizontalPipeline = nullptr;
+        std::shared_ptr<wire::ComputePipeline> m_BlurVerticalPipeline = nullptr;
         std::shared_ptr<wire::Framebuffer> m_BlurIntermediateFramebuffer = nullptr;
         std::shared_ptr<wire::Framebuffer> m_BlurFramebuffer = nullptr;
         std::shared_ptr<wire::ShaderResourceLayout> m_BlurResourceLayout = nullptr;
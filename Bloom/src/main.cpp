@@ -13,6 +13,11 @@ int main()
 	desc.WindowTitle = "bloom";
 	desc.WindowWidth = 1280;
 	desc.WindowHeight = 720;
+#ifdef WR_DIST
+	desc.LoadPrebuiltShaderCache = true;
+#else
+	desc.HotReloadShaders = true;
+#endif
 
 	wire::Application app(desc);
 	
@@ -33,6 +38,7 @@ int APIENTRY WinMain(HINSTANCE, HINSTANCE, LPSTR, int)
 	desc.WindowTitle = "bloom";
 	desc.WindowWidth = 1280;
 	desc.WindowHeight = 720;
+	desc.LoadPrebuiltShaderCache = true;
 
 	wire::Application app(desc);
 
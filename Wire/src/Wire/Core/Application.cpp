@@ -3,6 +3,7 @@
 #include "Wire/Audio/AudioEngine.h"
 
 #include "Wire/Renderer/Instance.h"
+#include "Wire/Renderer/ShaderCompiler.h"
 
 #include "Wire/Utils/Windows.h"
 #include "Wire/Utils/macOS.h"
@@ -112,31 +113,25 @@ namespace wire {
 		DeviceInfo deviceInfo{};
 		deviceInfo.ShaderCache.CachePath = "wire.shadercache";
 		deviceInfo.FontCache.CachePath = "wire.fontcache";
+		deviceInfo.PipelineCachePath = "wire.pipelinecache";
         
-        if (!std::filesystem::exists("shaders/"))
-            std::filesystem::create_directory("shaders/");
+        deviceInfo.ShaderCache.LoadOnly = m_Desc.LoadPrebuiltShaderCache;
+        deviceInfo.ShaderCache.HotReload = m_Desc.HotReloadShaders;
+        deviceInfo.FontCache.ComputeGeneration = m_Desc.ComputeFontGeneration;
+        deviceInfo.FontCache.ValidateComputeGeneration = m_Desc.ValidateComputeFontGeneration;
 
-        for (const auto& dir : std::filesystem::directory_iterator("shaders/"))
+        if (!m_Desc.LoadPrebuiltShaderCache)
         {
-            if (dir.path().has_extension() && dir.path().extension() == ".hlsl")
+            if (!std::filesystem::exists("shaders/"))
+                std::filesystem::create_directory("shaders/");
+
+            deviceInfo.ShaderCache.ShaderInfos = ShaderCompiler::findShaders("shaders/");
+
+            // wire-shaderc only builds shaders/, so a shader that fails to compile here cannot break a dist build
+            if (m_Desc.ComputeFontGeneration)
             {
-                if (dir.path().string().ends_with(".compute.hlsl"))
-                {
-                    deviceInfo.ShaderCache.ShaderInfos.push_back(ShaderInfo{
-                        .Path = dir.path(),
-                        .IsGraphics = false,
-                        .VertexOrComputeEntryPoint = "CShader"
-                    });
-
-                    continue;
-                }
-
-                deviceInfo.ShaderCache.ShaderInfos.push_back(ShaderInfo{
-                    .Path = dir.path(),
-                    .IsGraphics = true,
-                    .VertexOrComputeEntryPoint = "VShader",
-                    .PixelEntryPoint = "PShader"
-                });
+                std::vector<ShaderInfo> unvalidated = ShaderCompiler::findShaders("shaders/unvalidated/");
+                deviceInfo.ShaderCache.ShaderInfos.insert(deviceInfo.ShaderCache.ShaderInfos.end(), unvalidated.begin(), unvalidated.end());
             }
         }
 
@@ -20,6 +20,18 @@ namespace wire {
 		std::string WindowTitle;
 		uint32_t WindowWidth, WindowHeight;
 
+		// load wire.shadercache as built by wire-shaderc, shaders are never compiled at startup
+		bool LoadPrebuiltShaderCache = false;
+
+		// recompile shaders/ on change and rebuild the pipelines that use them, without restarting
+		bool HotReloadShaders = false;
+
+		// build missing font atlases with a compute shader where the gpu has double precision. the shader is compiled
+		// from shaders/unvalidated/ only then, it has not run on a real driver yet and is left out of prebuilt caches
+		bool ComputeFontGeneration = false;
+		// generate those atlases on the cpu as well and keep the cpu bytes where they differ, for checking the shader
+		bool ValidateComputeFontGeneration = false;
+
 	private:
 		bool m_Running = true;
 		bool m_WasWindowResized = false;
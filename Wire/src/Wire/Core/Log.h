@@ -7,6 +7,7 @@
 #include <vector>
 #include <fstream>
 #include <mutex>
+#include <memory>
 
 namespace wire {
 
@@ -0,0 +1,115 @@
+#include "ThreadPool.h"
+
+#include <algorithm>
+
+namespace wire {
+
+	ThreadPool::ThreadPool(uint32_t threadCount)
+	{
+		if (threadCount == 0)
+			threadCount = getHardwareThreadCount();
+
+		m_Threads.reserve(threadCount);
+		for (uint32_t i = 0; i < threadCount; i++)
+			m_Threads.emplace_back(&ThreadPool::workerLoop, this);
+	}
+
+	ThreadPool::~ThreadPool()
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Stopping = true;
+		}
+		m_Condition.notify_all();
+
+		for (auto& thread : m_Threads)
+			thread.join();
+	}
+
+	void ThreadPool::parallelFor(uint32_t count, const std::function<void(uint32_t)>& func)
+	{
+		if (count == 0)
+			return;
+
+		struct ForState
+		{
+			std::atomic<uint32_t> Next = 0;
+			std::atomic<uint32_t> Completed = 0;
+			uint32_t Count = 0;
+			const std::function<void(uint32_t)>* Func = nullptr;
+
+			std::mutex Mutex;
+			std::condition_variable Condition;
+		};
+
+		auto state = std::make_shared<ForState>();
+		state->Count = count;
+		state->Func = &func;
+
+		auto work = [state]()
+		{
+			uint32_t index;
+			while ((index = state->Next.fetch_add(1)) < state->Count)
+			{
+				(*state->Func)(index);
+
+				if (state->Completed.fetch_add(1) + 1 == state->Count)
+				{
+					std::lock_guard lock(state->Mutex);
+					state->Condition.notify_all();
+				}
+			}
+		};
+
+		uint32_t helpers = std::min(count - 1, getThreadCount());
+		for (uint32_t i = 0; i < helpers; i++)
+			enqueue(work);
+
+		work();
+
+		std::unique_lock lock(state->Mutex);
+		state->Condition.wait(lock, [&state]() { return state->Completed.load() == state->Count; });
+	}
+
+	uint32_t ThreadPool::getHardwareThreadCount()
+	{
+		return std::max(1u, std::thread::hardware_concurrency());
+	}
+
+	ThreadPool& ThreadPool::shared()
+	{
+		static ThreadPool pool;
+		return pool;
+	}
+
+	void ThreadPool::enqueue(std::function<void()>&& task)
+	{
+		{
+			std::lock_guard lock(m_Mutex);
+			m_Tasks.push(std::move(task));
+		}
+		m_Condition.notify_one();
+	}
+
+	void ThreadPool::workerLoop()
+	{
+		while (true)
+		{
+			std::function<void()> task;
+
+			{
+				std::unique_lock lock(m_Mutex);
+				m_Condition.wait(lock, [this]() { return m_Stopping || !m_Tasks.empty(); });
+
+				if (m_Stopping && m_Tasks.empty())
+					return;
+
+				task = std::move(m_Tasks.front());
+				m_Tasks.pop();
+			}
+
+			task();
+		}
+	}
+
+}
@@ -0,0 +1,56 @@
+#pragma once
+
+#include <mutex>
+#include <queue>
+#include <atomic>
+#include <future>
+#include <thread>
+#include <vector>
+#include <cstdint>
+#include <functional>
+#include <condition_variable>
+
+namespace wire {
+
+	class ThreadPool
+	{
+	public:
+		ThreadPool(uint32_t threadCount = 0);
+		~ThreadPool();
+
+		ThreadPool(const ThreadPool&) = delete;
+		ThreadPool& operator=(const ThreadPool&) = delete;
+
+		template<typename Func>
+		auto submit(Func&& func) -> std::future<std::invoke_result_t<Func>>
+		{
+			using ReturnType = std::invoke_result_t<Func>;
+
+			auto task = std::make_shared<std::packaged_task<ReturnType()>>(std::forward<Func>(func));
+			std::future<ReturnType> future = task->get_future();
+
+			enqueue([task]() { (*task)(); });
+
+			return future;
+		}
+
+		// runs func(i) for i in [0, count), the calling thread takes part so nested calls cannot deadlock
+		void parallelFor(uint32_t count, const std::function<void(uint32_t)>& func);
+
+		uint32_t getThreadCount() const { return static_cast<uint32_t>(m_Threads.size()); }
+
+		static uint32_t getHardwareThreadCount();
+		static ThreadPool& shared();
+	private:
+		void enqueue(std::function<void()>&& task);
+		void workerLoop();
+	private:
+		std::vector<std::thread> m_Threads;
+		std::queue<std::function<void()>> m_Tasks;
+
+		std::mutex m_Mutex;
+		std::condition_variable m_Condition;
+		bool m_Stopping = false;
+	};
+
+}
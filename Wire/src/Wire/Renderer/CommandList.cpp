@@ -21,6 +21,7 @@ namespace wire {
     {
         m_IsRecording = false;
         m_CurrentGraphicsPipeline = nullptr;
+        m_SkipPipelineCommands = false;
         m_Scopes.push_back(m_CurrentScope);
         m_CurrentScope = {};
     }
@@ -41,25 +42,42 @@ namespace wire {
 
     void CommandList::bindPipeline(const std::shared_ptr<GraphicsPipeline>& pipeline)
     {
-        CommandEntry entry;
-        entry.Type = CommandType::BindPipeline;
-        entry.Args = CommandEntry::BindPipelineArgs{ .IsGraphics = true, .Pipeline = pipeline };
+        std::shared_ptr<GraphicsPipeline> boundPipeline = pipeline;
+        if (!boundPipeline->isReady())
+            boundPipeline = boundPipeline->getFallback();
 
-        m_CurrentGraphicsPipeline = pipeline;
+        m_CurrentGraphicsPipeline = boundPipeline ? boundPipeline : pipeline;
         m_CurrentComputePipeline = nullptr;
 
+        // still compiling without a usable fallback, commands are dropped until the next bind
+        m_SkipPipelineCommands = !boundPipeline || !boundPipeline->isReady();
+        if (m_SkipPipelineCommands)
+            return;
+
+        CommandEntry entry;
+        entry.Type = CommandType::BindPipeline;
+        entry.Args = CommandEntry::BindPipelineArgs{ .IsGraphics = true, .Pipeline = boundPipeline };
+
         m_CurrentScope.Commands.push_back(entry);
     }
 
     void CommandList::bindPipeline(const std::shared_ptr<ComputePipeline>& pipeline)
     {
-        CommandEntry entry;
-        entry.Type = CommandType::BindPipeline;
-        entry.Args = CommandEntry::BindPipelineArgs{ .IsGraphics = false, .Pipeline = pipeline };
+        std::shared_ptr<ComputePipeline> boundPipeline = pipeline;
+        if (!boundPipeline->isReady())
+            boundPipeline = boundPipeline->getFallback();
 
-        m_CurrentComputePipeline = pipeline;
+        m_CurrentComputePipeline = boundPipeline ? boundPipeline : pipeline;
         m_CurrentGraphicsPipeline = nullptr;
 
+        m_SkipPipelineCommands = !boundPipeline || !boundPipeline->isReady();
+        if (m_SkipPipelineCommands)
+            return;
+
+        CommandEntry entry;
+        entry.Type = CommandType::BindPipeline;
+        entry.Args = CommandEntry::BindPipelineArgs{ .IsGraphics = false, .Pipeline = boundPipeline };
+
         m_CurrentScope.Commands.push_back(entry);
     }
 
@@ -68,6 +86,9 @@ namespace wire {
         WR_ASSERT(m_CurrentGraphicsPipeline || m_CurrentComputePipeline, "cannot push constants without binding a pipeline");
         WR_ASSERT(size <= 128, "push constant size must be <= 128");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry::PushConstantsArgs args{};
         
         if (m_CurrentComputePipeline)
@@ -97,6 +118,9 @@ namespace wire {
     {
         WR_ASSERT(m_CurrentGraphicsPipeline || m_CurrentComputePipeline, "cannot bind descriptor set without binding a pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::BindShaderResource;
 
@@ -112,6 +136,9 @@ namespace wire {
     {
         WR_ASSERT(m_CurrentGraphicsPipeline, "cannot set viewport without binding a pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::SetViewport;
         entry.Args = CommandEntry::SetViewportArgs{ .Pipeline = m_CurrentGraphicsPipeline, .Position = position, .Size = size, .MinDepth = minDepth, .MaxDepth = maxDepth };
@@ -123,6 +150,9 @@ namespace wire {
     {
         WR_ASSERT(m_CurrentGraphicsPipeline, "cannot set scissor without binding a pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::SetScissor;
         entry.Args = CommandEntry::SetScissorArgs{ .Pipeline = m_CurrentGraphicsPipeline, .Min = min, .Max = max };
@@ -134,6 +164,9 @@ namespace wire {
     {
         WR_ASSERT(m_CurrentGraphicsPipeline, "cannot set line width without binding a pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::SetLineWidth;
         entry.Args = CommandEntry::SetLineWidthArgs{ .Pipeline = m_CurrentGraphicsPipeline, .LineWidth = lineWidth };
@@ -159,24 +192,30 @@ namespace wire {
         m_CurrentScope.Commands.push_back(entry);
     }
 
-    void CommandList::draw(uint32_t vertexCount, uint32_t vertexOffset)
+    void CommandList::draw(uint32_t vertexCount, uint32_t vertexOffset, uint32_t instanceCount, uint32_t firstInstance)
     {
         WR_ASSERT(m_CurrentGraphicsPipeline, "cannot draw without binding graphics pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::Draw;
-        entry.Args = CommandEntry::DrawArgs{ .VertexCount = vertexCount, .VertexOffset = vertexOffset };
+        entry.Args = CommandEntry::DrawArgs{ .VertexCount = vertexCount, .VertexOffset = vertexOffset, .InstanceCount = instanceCount, .FirstInstance = firstInstance };
 
         m_CurrentScope.Commands.push_back(entry);
     }
 
-    void CommandList::drawIndexed(uint32_t indexCount, uint32_t vertexOffset, uint32_t indexOffset)
+    void CommandList::drawIndexed(uint32_t indexCount, uint32_t vertexOffset, uint32_t indexOffset, uint32_t instanceCount, uint32_t firstInstance)
     {
         WR_ASSERT(m_CurrentGraphicsPipeline, "cannot draw without binding graphics pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::DrawIndexed;
-        entry.Args = CommandEntry::DrawIndexedArgs{ .IndexCount = indexCount, .VertexOffset = vertexOffset, .IndexOffset = indexOffset };
+        entry.Args = CommandEntry::DrawIndexedArgs{ .IndexCount = indexCount, .VertexOffset = vertexOffset, .IndexOffset = indexOffset, .InstanceCount = instanceCount, .FirstInstance = firstInstance };
 
         m_CurrentScope.Commands.push_back(entry);
     }
@@ -185,6 +224,9 @@ namespace wire {
     {
         WR_ASSERT(m_CurrentComputePipeline, "cannot dispatch without binding compute pipeline");
 
+        if (m_SkipPipelineCommands)
+            return;
+
         CommandEntry entry;
         entry.Type = CommandType::Dispatch;
         entry.Args = CommandEntry::DispatchArgs{ .GroupCountX = groupCountX, .GroupCountY = groupCountY, .GroupCountZ = groupCountZ };
@@ -192,6 +234,20 @@ namespace wire {
         m_CurrentScope.Commands.push_back(entry);
     }
 
+    void CommandList::dispatchThreads(uint32_t threadCountX, uint32_t threadCountY, uint32_t threadCountZ)
+    {
+        WR_ASSERT(m_CurrentComputePipeline, "cannot dispatch without binding compute pipeline");
+
+        if (m_SkipPipelineCommands)
+            return;
+
+        CommandEntry entry;
+        entry.Type = CommandType::DispatchThreads;
+        entry.Args = CommandEntry::DispatchThreadsArgs{ .Pipeline = m_CurrentComputePipeline, .ThreadCountX = threadCountX, .ThreadCountY = threadCountY, .ThreadCountZ = threadCountZ };
+
+        m_CurrentScope.Commands.push_back(entry);
+    }
+
     void CommandList::clearImage(const std::shared_ptr<Framebuffer>& framebuffer, const glm::vec4& color, AttachmentLayout currentLayout, uint32_t baseMip, uint32_t numMips)
     {
         WR_ASSERT(m_CurrentScope.ScopeType == CommandScope::General, "cannot clear image inside a render pass");
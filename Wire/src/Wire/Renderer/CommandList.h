@@ -29,7 +29,7 @@ namespace wire {
         BindPipeline, PushConstants, BindShaderResource, SetViewport, SetScissor, SetLineWidth,
         BindVertexBuffers, BindIndexBuffer,
         ClearImage,
-        Draw, DrawIndexed, Dispatch,
+        Draw, DrawIndexed, Dispatch, DispatchThreads,
         CopyBuffer, BufferMemoryBarrier, ImageMemoryBarrier,
         NativeCommand
     };
@@ -142,6 +142,8 @@ namespace wire {
         {
             uint32_t VertexCount;
             uint32_t VertexOffset;
+            uint32_t InstanceCount;
+            uint32_t FirstInstance;
         };
 
         struct DrawIndexedArgs
@@ -149,6 +151,8 @@ namespace wire {
             uint32_t IndexCount;
             uint32_t VertexOffset;
             uint32_t IndexOffset;
+            uint32_t InstanceCount;
+            uint32_t FirstInstance;
         };
 
         struct DispatchArgs
@@ -158,6 +162,14 @@ namespace wire {
             uint32_t GroupCountZ;
         };
 
+        struct DispatchThreadsArgs
+        {
+            std::shared_ptr<ComputePipeline> Pipeline;
+            uint32_t ThreadCountX;
+            uint32_t ThreadCountY;
+            uint32_t ThreadCountZ;
+        };
+
         struct CopyBufferArgs
         {
             std::shared_ptr<Buffer> SrcBuffer;
@@ -207,6 +219,7 @@ namespace wire {
             DrawArgs,
             DrawIndexedArgs,
             DispatchArgs,
+            DispatchThreadsArgs,
             CopyBufferArgs,
             BufferMemoryBarrierArgs,
             ImageMemoryBarrierArgs,
@@ -250,10 +263,12 @@ namespace wire {
         void bindVertexBuffers(const std::vector<std::shared_ptr<Buffer>>& vertexBuffers);
         void bindIndexBuffer(const std::shared_ptr<Buffer>& indexBuffer);
 
-        void draw(uint32_t vertexCount, uint32_t vertexOffset = 0);
-        void drawIndexed(uint32_t indexCount, uint32_t vertexOffset = 0, uint32_t indexOffset = 0);
+        void draw(uint32_t vertexCount, uint32_t vertexOffset = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
+        void drawIndexed(uint32_t indexCount, uint32_t vertexOffset = 0, uint32_t indexOffset = 0, uint32_t instanceCount = 1, uint32_t firstInstance = 0);
 
         void dispatch(uint32_t groupCountX, uint32_t groupCountY, uint32_t groupCountZ);
+        // group counts come from the workgroup size of the bound pipeline, so they follow the autotuner's choice
+        void dispatchThreads(uint32_t threadCountX, uint32_t threadCountY = 1, uint32_t threadCountZ = 1);
 
         void clearImage(const std::shared_ptr<Framebuffer>& framebuffer, const glm::vec4& color, AttachmentLayout currentLayout, uint32_t baseMip = 0, uint32_t numMips = 1);
 
@@ -287,6 +302,7 @@ namespace wire {
 
         std::shared_ptr<GraphicsPipeline> m_CurrentGraphicsPipeline = nullptr;
         std::shared_ptr<ComputePipeline> m_CurrentComputePipeline = nullptr;
+        bool m_SkipPipelineCommands = false;
     };
 
 }
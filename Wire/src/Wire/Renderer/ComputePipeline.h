@@ -3,6 +3,7 @@
 #include "IResource.h"
 #include "GraphicsPipeline.h"
 
+#include <array>
 #include <string>
 
 namespace wire {
@@ -13,16 +14,50 @@ namespace wire {
         std::shared_ptr<ShaderResourceLayout> ResourceLayout;
     };
 
+    class ComputePipeline;
+
     struct ComputePipelineDesc
     {
         std::string ShaderPath;
+        uint32_t ShaderVariant = 0; // see ShaderCache::getVariantKey
         ComputeInputLayout Layout;
+        std::vector<SpecializationConstant> SpecializationConstants;
+        std::array<uint32_t, 3> WorkgroupSize = { 0, 0, 0 }; // 0 = keep the numthreads the shader was compiled with
+
+        // sizes to benchmark on this device, the fastest replaces WorkgroupSize and is remembered in the pipeline cache.
+        // only dispatches through CommandList::dispatchThreads are timed, the shader has to ignore threads past the end
+        std::vector<std::array<uint32_t, 3>> WorkgroupSizeCandidates;
+
+        // compile on a worker thread, the pipeline can be bound once isReady() returns true
+        bool CompileAsync = false;
+        // bound in place of the pipeline while it is compiling, must have a compatible layout
+        std::shared_ptr<ComputePipeline> Fallback;
     };
     
     class ComputePipeline : public IResource
     {
     public:
         virtual ~ComputePipeline() = default;
+
+        virtual bool isReady() const = 0;
+        virtual void wait() const = 0;
+
+        virtual std::shared_ptr<ComputePipeline> getFallback() const = 0;
+
+        // the desc layout, or the one reflected from the shader when the desc left it empty
+        virtual std::shared_ptr<ShaderResourceLayout> getResourceLayout() const = 0;
+        virtual std::array<uint32_t, 3> getWorkgroupSize() const = 0;
+
+        std::array<uint32_t, 3> getGroupCount(uint32_t threadCountX, uint32_t threadCountY = 1, uint32_t threadCountZ = 1) const
+        {
+            std::array<uint32_t, 3> workgroupSize = getWorkgroupSize();
+
+            return {
+                (threadCountX + workgroupSize[0] - 1) / workgroupSize[0],
+                (threadCountY + workgroupSize[1] - 1) / workgroupSize[1],
+                (threadCountZ + workgroupSize[2] - 1) / workgroupSize[2]
+            };
+        }
     };
 
 }
@@ -25,6 +25,28 @@ namespace wire {
     {
         ShaderCacheDesc ShaderCache;
         FontCacheDesc FontCache;
+        std::filesystem::path PipelineCachePath;
+    };
+
+    struct ObjectCacheStatistics
+    {
+        uint32_t Hits = 0;
+        uint32_t Misses = 0;
+        uint32_t Live = 0;
+    };
+
+    struct PipelineStatistics
+    {
+        uint32_t WarmPipelines = 0;      // served from the pipeline cache
+        uint32_t ColdPipelines = 0;      // compiled by the driver
+        uint32_t UntrackedPipelines = 0; // creation feedback unavailable
+        double TotalCreationTime = 0.0;  // milliseconds
+
+        // deduplication of identical descriptions
+        ObjectCacheStatistics ShaderModules;
+        ObjectCacheStatistics SetLayouts;
+        ObjectCacheStatistics PipelineLayouts;
+        ObjectCacheStatistics Pipelines;
     };
 
     class Device : public IResource
@@ -67,6 +89,7 @@ namespace wire {
         virtual std::shared_ptr<ComputePipeline> createComputePipeline(const ComputePipelineDesc& desc, std::string_view debugName = {}) = 0;
         virtual std::shared_ptr<Texture2D> createTexture2D(const std::filesystem::path& path, std::string_view debugName = {}) = 0;
         virtual std::shared_ptr<Texture2D> createTexture2D(uint32_t* data, uint32_t width, uint32_t height, std::string_view debugName = {}) = 0;
+        virtual std::shared_ptr<Texture2D> createTexture2D(const void* data, uint32_t width, uint32_t height, TextureFormat format, std::string_view debugName = {}) = 0;
         virtual std::shared_ptr<Sampler> createSampler(const SamplerDesc& desc, std::string_view debugName = {}) = 0;
         virtual std::shared_ptr<Font> createFont(const std::filesystem::path& path, std::string_view debugName = {}, uint32_t minChar = 0x0020, uint32_t maxChar = 0x00FF) = 0;
         virtual std::shared_ptr<Font> getFontFromCache(const std::filesystem::path& path) = 0;
@@ -77,6 +100,8 @@ namespace wire {
         virtual const FontCache& getFontCache() const = 0;
 
         virtual float getMaxAnisotropy() const = 0;
+        virtual bool supportsShaderFloat64() const = 0;
+        virtual PipelineStatistics getPipelineStatistics() const = 0;
         
         template<typename T>
         requires std::is_base_of_v<IResource, T>
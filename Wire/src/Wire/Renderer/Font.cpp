@@ -1,38 +1,203 @@
 #include "Font.h"
+#include "MSDFComputeGenerator.h"
 
-#include "MSDFData.h"
 #include "Wire/Core/Assert.h"
+#include "Wire/Core/ThreadPool.h"
+#include "Wire/Serialization/SHA-256.h"
 
+#include <chrono>
 #include <fstream>
+#include <unordered_map>
+
+#undef INFINITE
+#include <msdf-atlas-gen.h>
 
 namespace wire {
 
+    // what msdf_atlas::sdfGenerator, msdfGenerator and mtsdfGenerator do with scanlinePass once the distance field is there
+    template<int N>
+    static void FinishComputedGlyph(const msdfgen::BitmapRef<float, N>& bitmap, const msdf_atlas::GlyphGeometry& glyph, const msdf_atlas::GeneratorAttributes& attributes)
+    {
+        msdfgen::distanceSignCorrection(bitmap, glyph.getShape(), glyph.getBoxProjection(), MSDF_ATLAS_GLYPH_FILL_RULE);
+
+        if constexpr (N >= 3)
+        {
+            if (attributes.config.errorCorrection.mode != msdfgen::ErrorCorrectionConfig::DISABLED)
+            {
+                msdfgen::MSDFGeneratorConfig config = attributes.config;
+                config.errorCorrection.distanceCheckMode = msdfgen::ErrorCorrectionConfig::DO_NOT_CHECK_DISTANCE;
+                msdfgen::msdfErrorCorrection(bitmap, glyph.getShape(), glyph.getBoxProjection(), glyph.getBoxRange(), config);
+            }
+        }
+    }
+
     template<typename T, typename S, int N, msdf_atlas::GeneratorFunction<S, N> GenFunc>
-    static uint32_t* CreateAndCacheAtlas(const std::string& fontName, float fontSize, const std::vector<msdf_atlas::GlyphGeometry>& glyphs,
-        const msdf_atlas::FontGeometry& fontGeometry, uint32_t width, uint32_t height, size_t& outSize)
+    static uint8_t* CreateAndCacheAtlas(const std::string& fontName, float fontSize, const std::vector<msdf_atlas::GlyphGeometry>& glyphs,
+        const msdf_atlas::FontGeometry& fontGeometry, uint32_t width, uint32_t height, size_t& outSize, MSDFComputeGenerator* computeGenerator, bool& outComputeGenerated)
     {
+        static_assert(std::is_same_v<S, float>, "The compute generator writes float distance fields!");
+
         msdf_atlas::GeneratorAttributes attributes;
         attributes.config.overlapSupport = true;
         attributes.scanlinePass = true;
 
-        msdf_atlas::ImmediateAtlasGenerator<S, N, GenFunc, msdf_atlas::BitmapAtlasStorage<T, N>> generator(width, height);
-        generator.setAttributes(attributes);
-        generator.setThreadCount(8);
-        generator.generate(glyphs.data(), (int)glyphs.size());
+        // glyphs the compute shader left empty are generated below like the rest
+        std::vector<std::vector<float>> computedGlyphs;
+        bool useCompute = computeGenerator && computeGenerator->generate(glyphs, N, computedGlyphs);
+        bool validate = useCompute && computeGenerator->isValidating();
 
-        msdfgen::BitmapConstRef<T, N> bitmap = (msdfgen::BitmapConstRef<T, N>)generator.atlasStorage();
+        msdf_atlas::BitmapAtlasStorage<T, N> storage(width, height);
+        msdf_atlas::BitmapAtlasStorage<T, N> reference(validate ? width : 0, validate ? height : 0);
 
-        uint32_t* atlasData = new uint32_t[width * height * N];
-        std::memcpy(atlasData, reinterpret_cast<const void*>(bitmap.pixels), width * height * N);
-        outSize = (size_t)(width * height * N);
+        // same as ImmediateAtlasGenerator, but on the shared pool so several fonts can generate at once.
+        // every glyph owns a separate rect of the atlas, so the writes never overlap
+        ThreadPool::shared().parallelFor(static_cast<uint32_t>(glyphs.size()), [&](uint32_t i)
+        {
+            const msdf_atlas::GlyphGeometry& glyph = glyphs[i];
+            if (glyph.isWhitespace())
+                return;
+
+            int l, b, w, h;
+            glyph.getBoxRect(l, b, w, h);
+
+            std::vector<S> glyphBuffer(static_cast<size_t>(N * w * h));
+            msdfgen::BitmapRef<S, N> glyphBitmap(glyphBuffer.data(), w, h);
+
+            if (useCompute && computedGlyphs[i].size() == glyphBuffer.size())
+            {
+                std::memcpy(glyphBuffer.data(), computedGlyphs[i].data(), glyphBuffer.size() * sizeof(S));
+                FinishComputedGlyph<N>(glyphBitmap, glyph, attributes);
+
+                if (validate)
+                {
+                    std::vector<S> referenceBuffer(glyphBuffer.size());
+                    msdfgen::BitmapRef<S, N> referenceBitmap(referenceBuffer.data(), w, h);
+
+                    GenFunc(referenceBitmap, glyph, attributes);
+                    reference.put(l, b, msdfgen::BitmapConstRef<S, N>(referenceBitmap));
+                }
+            }
+            else
+            {
+                GenFunc(glyphBitmap, glyph, attributes);
+
+                if (validate)
+                    reference.put(l, b, msdfgen::BitmapConstRef<S, N>(glyphBitmap));
+            }
+
+            storage.put(l, b, msdfgen::BitmapConstRef<S, N>(glyphBitmap));
+        });
+
+        msdfgen::BitmapConstRef<T, N> bitmap = (msdfgen::BitmapConstRef<T, N>)storage;
+
+        // exactly the bytes of the bitmap, N channels of T per texel
+        outSize = static_cast<size_t>(width) * height * N * sizeof(T);
+
+        uint8_t* atlasData = new uint8_t[outSize];
+        std::memcpy(atlasData, reinterpret_cast<const void*>(bitmap.pixels), outSize);
+
+        outComputeGenerated = useCompute;
+
+        if (validate)
+        {
+            const uint8_t* referenceData = reinterpret_cast<const uint8_t*>(((msdfgen::BitmapConstRef<T, N>)reference).pixels);
+
+            size_t mismatches = 0;
+            for (size_t i = 0; i < outSize; i++)
+                mismatches += atlasData[i] != referenceData[i];
+
+            // the cache should not depend on where it was built, so the cpu atlas wins
+            if (mismatches > 0)
+            {
+                WR_WARN("Compute generated atlas of {} differs from the cpu in {} of {} bytes, keeping the cpu atlas", fontName, mismatches, outSize);
+                std::memcpy(atlasData, referenceData, outSize);
+                outComputeGenerated = false;
+            }
+            else
+                WR_INFO("Compute generated atlas of {} matches the cpu", fontName);
+        }
 
         return atlasData;
     }
 
-    NaiveFont NaiveFont::create(const std::filesystem::path& path, uint32_t minChar, uint32_t maxChar)
+    static double GetElapsedTime(std::chrono::high_resolution_clock::time_point start)
+    {
+        return std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+    }
+
+    static MSDFData CreateMSDFData(const std::vector<msdf_atlas::GlyphGeometry>& glyphs, const msdf_atlas::FontGeometry& fontGeometry)
+    {
+        MSDFData data;
+
+        std::unordered_map<int, uint32_t> codepoints;
+        for (const msdf_atlas::GlyphGeometry& glyph : glyphs)
+        {
+            GlyphMetrics& metrics = data.Glyphs.emplace_back();
+            metrics.Codepoint = glyph.getCodepoint();
+            metrics.Advance = glyph.getAdvance();
+            glyph.getQuadPlaneBounds(metrics.PlaneLeft, metrics.PlaneBottom, metrics.PlaneRight, metrics.PlaneTop);
+            glyph.getQuadAtlasBounds(metrics.AtlasLeft, metrics.AtlasBottom, metrics.AtlasRight, metrics.AtlasTop);
+
+            codepoints[glyph.getIndex()] = glyph.getCodepoint();
+        }
+
+        // msdf-atlas-gen keys kerning by glyph index, layout works in codepoints
+        for (const auto& [pair, advance] : fontGeometry.getKerning())
+        {
+            auto first = codepoints.find(pair.first);
+            auto second = codepoints.find(pair.second);
+            if (first == codepoints.end() || second == codepoints.end())
+                continue;
+
+            data.Kerning.push_back({ first->second, second->second, advance });
+        }
+
+        std::sort(data.Glyphs.begin(), data.Glyphs.end(), [](const GlyphMetrics& a, const GlyphMetrics& b) { return a.Codepoint < b.Codepoint; });
+        std::sort(data.Kerning.begin(), data.Kerning.end(), [](const KerningPair& a, const KerningPair& b)
+        {
+            return a.First != b.First ? a.First < b.First : a.Second < b.Second;
+        });
+
+        const msdfgen::FontMetrics& fontMetrics = fontGeometry.getMetrics();
+        data.Metrics.EmSize = fontMetrics.emSize;
+        data.Metrics.AscenderY = fontMetrics.ascenderY;
+        data.Metrics.DescenderY = fontMetrics.descenderY;
+        data.Metrics.LineHeight = fontMetrics.lineHeight;
+        data.Metrics.UnderlineY = fontMetrics.underlineY;
+        data.Metrics.UnderlineThickness = fontMetrics.underlineThickness;
+
+        return data;
+    }
+
+    uint32_t getChannelCount(FontAtlasFormat format)
+    {
+        switch (format)
+        {
+            case FontAtlasFormat::MTSDF: return 4;
+            case FontAtlasFormat::MSDF: return 3;
+            case FontAtlasFormat::SDF: return 1;
+        }
+
+        WR_ASSERT(false, "Unknown font atlas format!");
+        return 0;
+    }
+
+    NaiveFont NaiveFont::create(const std::filesystem::path& path, uint32_t minChar, uint32_t maxChar, const FontAtlasParams& params, FontGenerationTiming* outTiming, MSDFComputeGenerator* computeGenerator)
     {
         NaiveFont naiveFont;
 
+        FontGenerationTiming timing;
+        timing.Name = path.filename().string();
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::array<uint32_t, 8> fileHash;
+        if (!getFileHash(path, fileHash))
+        {
+            WR_ERROR("Failed to read font {}", path.string());
+            return {};
+        }
+
         msdfgen::FreetypeHandle* ft = msdfgen::initializeFreetype();
         WR_ASSERT(ft, "Failed to initialize freetype!");
 
@@ -41,7 +206,8 @@ namespace wire {
         msdfgen::FontHandle* font = msdfgen::loadFont(ft, fileString.c_str());
         if (!font)
         {
-            std::cerr << "Failed to load font " << path << std::endl;
+            WR_ERROR("Failed to load font {}", path.string());
+            msdfgen::deinitializeFreetype(ft);
             return {};
         }
 
@@ -66,11 +232,14 @@ namespace wire {
         msdf_atlas::FontGeometry geometry(&glyphs);
         int glyphsLoaded = geometry.loadCharset(font, fontScale, charset);
 
-        double emSize = 40.0;
+        timing.LoadTime = GetElapsedTime(start);
+        start = std::chrono::high_resolution_clock::now();
+
+        double emSize = params.EmSize;
 
         msdf_atlas::TightAtlasPacker atlasPacker;
-        atlasPacker.setPixelRange(2.0);
-        atlasPacker.setMiterLimit(1.0);
+        atlasPacker.setPixelRange(params.PixelRange);
+        atlasPacker.setMiterLimit(params.MiterLimit);
         atlasPacker.setPadding(0);
         atlasPacker.setScale(emSize);
         int remaining = atlasPacker.pack(glyphs.data(), (int)glyphs.size());
@@ -79,66 +248,83 @@ namespace wire {
         atlasPacker.getDimensions(width, height);
         emSize = atlasPacker.getScale();
 
+        timing.PackTime = GetElapsedTime(start);
+        start = std::chrono::high_resolution_clock::now();
+
 #define DEFAULT_ANGLE_THRESHOLD 3.0
 #define LCG_MULTIPLIER 6364136223846793005ull
 #define LCG_INCREMENT 1442695040888963407ull
-#define THREAD_COUNT 8
 
+        // every glyph gets its own seed, so the coloring does not depend on the order glyphs are processed in
         uint64_t coloringSeed = 0;
-        bool expensizeColoring = false;
-        if (expensizeColoring)
+        ThreadPool::shared().parallelFor(static_cast<uint32_t>(glyphs.size()), [&glyphs, coloringSeed](uint32_t i)
         {
-            msdf_atlas::Workload([&glyphs = glyphs, &coloringSeed](int i, int threadNo) -> bool
-            {
-                uint64_t glyphSeed = (LCG_MULTIPLIER * (coloringSeed ^ i) + LCG_INCREMENT) * !!coloringSeed;
-                glyphs[i].edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
-                return true;
-            }, (int)glyphs.size()).finish(THREAD_COUNT);
-        }
-        else
+            uint64_t glyphSeed = (LCG_MULTIPLIER * (coloringSeed ^ i) + LCG_INCREMENT) * !!coloringSeed;
+            glyphs[i].edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
+        });
+
+        timing.ColoringTime = GetElapsedTime(start);
+        start = std::chrono::high_resolution_clock::now();
+
+        switch (params.Format)
         {
-            uint64_t glyphSeed = coloringSeed;
-            for (msdf_atlas::GlyphGeometry& glyph : glyphs)
-            {
-                glyphSeed *= LCG_MULTIPLIER;
-                glyph.edgeColoring(msdfgen::edgeColoringInkTrap, DEFAULT_ANGLE_THRESHOLD, glyphSeed);
-            }
+            case FontAtlasFormat::MTSDF:
+                naiveFont.AtlasData = CreateAndCacheAtlas<uint8_t, float, 4, msdf_atlas::mtsdfGenerator>(
+                    timing.Name, (float)emSize, glyphs, geometry, (uint32_t)width, (uint32_t)height, naiveFont.AtlasSize, computeGenerator, timing.ComputeGenerated);
+                break;
+            case FontAtlasFormat::MSDF:
+                naiveFont.AtlasData = CreateAndCacheAtlas<uint8_t, float, 3, msdf_atlas::msdfGenerator>(
+                    timing.Name, (float)emSize, glyphs, geometry, (uint32_t)width, (uint32_t)height, naiveFont.AtlasSize, computeGenerator, timing.ComputeGenerated);
+                break;
+            case FontAtlasFormat::SDF:
+                naiveFont.AtlasData = CreateAndCacheAtlas<uint8_t, float, 1, msdf_atlas::sdfGenerator>(
+                    timing.Name, (float)emSize, glyphs, geometry, (uint32_t)width, (uint32_t)height, naiveFont.AtlasSize, computeGenerator, timing.ComputeGenerated);
+                break;
         }
 
-        naiveFont.AtlasData = CreateAndCacheAtlas<uint8_t, float, 4, msdf_atlas::mtsdfGenerator>(
-            "Font",
-            (float)emSize,
-            glyphs,
-            geometry,
-            (uint32_t)width,
-            (uint32_t)height,
-            naiveFont.AtlasSize
-        );
+        timing.GenerateTime = GetElapsedTime(start);
+
+        naiveFont.Data = CreateMSDFData(glyphs, geometry);
 
         naiveFont.Width = (uint32_t)width;
         naiveFont.Height = (uint32_t)height;
 
         naiveFont.Name = path.filename().string();
+        naiveFont.SourcePath = path.generic_string();
+        std::memcpy(naiveFont.SHA256, fileHash.data(), sizeof(uint32_t) * 8);
+        naiveFont.MinChar = minChar;
+        naiveFont.MaxChar = maxChar;
+        naiveFont.Params = params;
 
         msdfgen::destroyFont(font);
         msdfgen::deinitializeFreetype(ft);
 
+        if (outTiming)
+            *outTiming = std::move(timing);
+
+        return naiveFont;
+    }
+
+    bool NaiveFont::getFileHash(const std::filesystem::path& path, std::array<uint32_t, 8>& outHash)
+    {
         std::ifstream file(path, std::ios::binary | std::ios::ate);
+        if (!file.good())
+            return false;
 
         size_t size = file.tellg();
         file.seekg(0, std::ios::beg);
 
-        naiveFont.FontFileSize = size;
-        naiveFont.FontFileData = new uint8_t[size];
-        file.read(reinterpret_cast<char*>(naiveFont.FontFileData), size);
+        std::vector<uint8_t> data(size);
+        file.read(reinterpret_cast<char*>(data.data()), size);
 
-        return naiveFont;
+        outHash = generateSHA256(data);
+        return true;
     }
 
     void NaiveFont::release()
     {
-        delete[] FontFileData;
         delete[] AtlasData;
+        AtlasData = nullptr;
     }
 
 }
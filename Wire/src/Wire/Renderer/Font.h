@@ -2,14 +2,16 @@
 
 #include "IResource.h"
 #include "Texture2D.h"
+#include "MSDFData.h"
 
+#include <array>
 #include <string>
 #include <vector>
 #include <filesystem>
 
 namespace wire {
 
-    struct MSDFData;
+    class MSDFComputeGenerator;
 
     class Font : public IResource
     {
@@ -20,17 +22,54 @@ namespace wire {
         virtual const MSDFData& getMSDFData() const = 0;
     };
 
+    // fewer channels trade corner sharpness for memory, sdf is usually enough for small ui text
+    enum class FontAtlasFormat : uint32_t
+    {
+        MTSDF = 0, // msdf with a true sdf in alpha, rgba8 everywhere
+        MSDF = 1,  // 3 bytes per texel in the cache, uploaded as rgba8 since rgb8 is rarely sampleable
+        SDF = 2    // 1 byte per texel, uploaded as r8
+    };
+
+    uint32_t getChannelCount(FontAtlasFormat format);
+
+    // anything that changes the generated atlas, part of the font cache key
+    struct FontAtlasParams
+    {
+        double EmSize = 40.0;
+        double PixelRange = 2.0;
+        double MiterLimit = 1.0;
+        FontAtlasFormat Format = FontAtlasFormat::MTSDF;
+
+        bool operator==(const FontAtlasParams&) const = default;
+    };
+
+    // milliseconds spent in each step of building a font atlas
+    struct FontGenerationTiming
+    {
+        std::string Name;
+        double LoadTime = 0.0;     // reading the file and loading the glyph outlines
+        double ColoringTime = 0.0;
+        double PackTime = 0.0;
+        double GenerateTime = 0.0; // distance field rasterization
+        bool ComputeGenerated = false; // distance fields from MSDFComputeGenerator
+    };
+
     struct NaiveFont
     {
         std::string Name;
+        std::string SourcePath;
+        uint32_t SHA256[8];
         uint32_t MinChar = 0x0020, MaxChar = 0x00FF;
-        size_t FontFileSize;
-        uint8_t* FontFileData;
-        size_t AtlasSize;
-        uint32_t* AtlasData;
+        FontAtlasParams Params;
+        MSDFData Data;
+        size_t AtlasSize;                // Width * Height * getChannelCount(Params.Format)
+        uint8_t* AtlasData = nullptr;
         uint32_t Width, Height;
 
-        static NaiveFont create(const std::filesystem::path& path, uint32_t minChar = 0x0020, uint32_t maxChar = 0x00FF);
+        // computeGenerator may be null, the atlas is then generated on the cpu alone
+        static NaiveFont create(const std::filesystem::path& path, uint32_t minChar = 0x0020, uint32_t maxChar = 0x00FF, const FontAtlasParams& params = {},
+            FontGenerationTiming* outTiming = nullptr, MSDFComputeGenerator* computeGenerator = nullptr);
+        static bool getFileHash(const std::filesystem::path& path, std::array<uint32_t, 8>& outHash);
         void release();
     };
 
@@ -1,8 +1,13 @@
 #include "FontCache.h"
+#include "MSDFComputeGenerator.h"
 
 #include "Wire/Core/Assert.h"
+#include "Wire/Core/ThreadPool.h"
 #include "Wire/Serialization/Stream.h"
+#include "Wire/Serialization/Compression.h"
 
+#include <chrono>
+#include <memory>
 #include <string>
 #include <fstream>
 
@@ -51,12 +56,88 @@ namespace wire {
 		// ID data
 		const char AppID[4] = { 'W', 'I', 'R', 'E' };
 		const char TypeID[4] = { 'F', 'C', 'C', 'H' };
-		const uint32_t Version = HEADER_VER(1, 0, 0, 0);
+		const uint32_t Version = HEADER_VER(1, 3, 0, 0);
 
 		// cache data
 		size_t FontCount;
 	};
 
+	namespace Utils {
+
+		// the name and path are not part of the key, a renamed file with the same contents is reused
+		static bool IsFontUpToDate(const NaiveFont& font, const FontInfo& info, const std::array<uint32_t, 8>& fileHash)
+		{
+			return font.AtlasData
+				&& std::memcmp(font.SHA256, fileHash.data(), sizeof(uint32_t) * 8) == 0
+				&& font.MinChar == info.MinChar
+				&& font.MaxChar == info.MaxChar
+				&& font.Params == info.Params;
+		}
+
+		// distance fields change slowly from texel to texel, so the difference to the previous texel of the same
+		// channel is mostly a handful of small values that the compressor finds long repeats of
+		static void DeltaEncode(std::vector<uint8_t>& data, uint32_t channels)
+		{
+			for (size_t i = data.size(); i-- > channels;)
+				data[i] -= data[i - channels];
+		}
+
+		static void DeltaDecode(uint8_t* data, size_t size, uint32_t channels)
+		{
+			for (size_t i = channels; i < size; i++)
+				data[i] += data[i - channels];
+		}
+
+		static std::unique_ptr<MSDFComputeGenerator> CreateComputeGenerator(const FontCacheDesc& desc, Device* device)
+		{
+			if (!desc.ComputeGeneration || !device)
+				return nullptr;
+
+			auto generator = std::make_unique<MSDFComputeGenerator>(device, desc.ValidateComputeGeneration);
+			if (!generator->isSupported())
+			{
+				WR_WARN("Compute font generation needs shaderFloat64 and MSDFGenerate.compute.hlsl, generating fonts on the cpu");
+				return nullptr;
+			}
+
+			return generator;
+		}
+
+		// fonts are generated side by side on the shared pool, their glyphs are split across it as well
+		static void GenerateFonts(const std::vector<FontInfo>& infos, std::vector<NaiveFont>& outFonts, std::vector<FontGenerationTiming>& outTimings, MSDFComputeGenerator* computeGenerator)
+		{
+			auto start = std::chrono::high_resolution_clock::now();
+
+			outFonts.resize(infos.size());
+			std::vector<FontGenerationTiming> timings(infos.size());
+
+			ThreadPool::shared().parallelFor(static_cast<uint32_t>(infos.size()), [&infos, &outFonts, &timings, computeGenerator](uint32_t i)
+			{
+				const FontInfo& info = infos[i];
+				outFonts[i] = NaiveFont::create(info.FontTTFPath, info.MinChar, info.MaxChar, info.Params, &timings[i], computeGenerator);
+			});
+
+			double totalTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+			FontGenerationTiming sum;
+			size_t computeGenerated = 0;
+			for (const auto& timing : timings)
+			{
+				sum.LoadTime += timing.LoadTime;
+				sum.ColoringTime += timing.ColoringTime;
+				sum.PackTime += timing.PackTime;
+				sum.GenerateTime += timing.GenerateTime;
+				computeGenerated += timing.ComputeGenerated;
+			}
+
+			WR_INFO("Generated {} font atlas(es) in {:.1f} ms on {} threads, {} with compute (load {:.1f} ms, coloring {:.1f} ms, pack {:.1f} ms, generate {:.1f} ms)",
+				infos.size(), totalTime, ThreadPool::shared().getThreadCount() + 1, computeGenerated, sum.LoadTime, sum.ColoringTime, sum.PackTime, sum.GenerateTime);
+
+			outTimings.insert(outTimings.end(), std::make_move_iterator(timings.begin()), std::make_move_iterator(timings.end()));
+		}
+
+	}
+
 	static void WriteNaiveFont(StreamWriter& stream, const NaiveFont& naiveFont);
 
 	static void ReadNaiveFont(StreamReader& stream, NaiveFont& naiveFont);
@@ -102,6 +183,11 @@ namespace wire {
 		FontCacheHeader header;
 		stream.readRaw(header);
 
+		// older caches carry the ttf instead of the glyph metrics, they get rebuilt
+		cache.m_Version = header.Version;
+		if (header.Version != FontCacheHeader{}.Version)
+			return cache;
+
 		std::vector<NaiveFont>& naiveFonts = cache.m_Fonts;
 
 		stream.readArray<NaiveFont>(naiveFonts, ReadNaiveFont, header.FontCount);
@@ -109,50 +195,107 @@ namespace wire {
 		return cache;
 	}
 
-	FontCache FontCache::createFontCache(const FontCacheDesc& desc)
+	FontCache FontCache::createFontCache(const FontCacheDesc& desc, Device* device)
 	{
 		FontCache fontCache;
+		fontCache.m_Version = FontCacheHeader{}.Version;
 
-		for (const auto& info : desc.FontInfos)
-		{
-			NaiveFont font = NaiveFont::create(info.FontTTFPath);
-
-			fontCache.m_Fonts.push_back(font);
-		}
+		std::unique_ptr<MSDFComputeGenerator> computeGenerator = Utils::CreateComputeGenerator(desc, device);
+		Utils::GenerateFonts(desc.FontInfos, fontCache.m_Fonts, fontCache.m_GenerationTimings, computeGenerator.get());
 
 		return fontCache;
 	}
 
-	FontCache FontCache::createOrGetFontCache(const FontCacheDesc& desc)
+	FontCache FontCache::createOrGetFontCache(const FontCacheDesc& desc, Device* device)
 	{
-		if (!std::filesystem::exists(desc.CachePath))
-		{
-			FontCache cache = createFontCache(desc);
-			cache.outputToFile(desc.CachePath);
+		FontCache oldCache;
+		if (std::filesystem::exists(desc.CachePath))
+			oldCache = createFromFile(desc.CachePath);
 
-			return cache;
-		}
+		FontCache cache;
+		cache.m_Version = FontCacheHeader{}.Version;
 
-		FontCache oldCache = createFromFile(desc.CachePath);
+		std::vector<uint8_t> taken(oldCache.m_Fonts.size());
+		std::vector<FontInfo> toGenerate;
+		std::vector<size_t> generateSlots;
+		bool dirty = oldCache.m_Version != cache.m_Version;
 
-		if (oldCache.m_Fonts.size() != desc.FontInfos.size())
+		for (const auto& info : desc.FontInfos)
 		{
-			FontCache cache = createFontCache(desc);
-			cache.outputToFile(desc.CachePath);
+			std::string name = info.FontTTFPath.filename().string();
+			std::string sourcePath = info.FontTTFPath.generic_string();
+
+			std::array<uint32_t, 8> fileHash;
+			if (NaiveFont::getFileHash(info.FontTTFPath, fileHash))
+			{
+				size_t index = 0;
+				while (index < oldCache.m_Fonts.size() && (taken[index] || !Utils::IsFontUpToDate(oldCache.m_Fonts[index], info, fileHash)))
+					index++;
+
+				if (index < oldCache.m_Fonts.size())
+				{
+					NaiveFont& font = oldCache.m_Fonts[index];
+					taken[index] = true;
+
+					dirty |= font.Name != name || font.SourcePath != sourcePath;
+					font.Name = name;
+					font.SourcePath = sourcePath;
+
+					// the atlas now belongs to the new cache
+					cache.m_Fonts.push_back(std::move(font));
+					font.AtlasData = nullptr;
+					continue;
+				}
+			}
+
+			generateSlots.push_back(cache.m_Fonts.size());
+			toGenerate.push_back(info);
+			cache.m_Fonts.emplace_back();
+			dirty = true;
+		}
 
-			return cache;
+		if (!toGenerate.empty())
+		{
+			std::vector<NaiveFont> generated;
+			std::unique_ptr<MSDFComputeGenerator> computeGenerator = Utils::CreateComputeGenerator(desc, device);
+			Utils::GenerateFonts(toGenerate, generated, cache.m_GenerationTimings, computeGenerator.get());
+
+			for (size_t i = 0; i < generated.size(); i++)
+				cache.m_Fonts[generateSlots[i]] = std::move(generated[i]);
 		}
 
-		return oldCache;
+		// fonts that were removed or replaced
+		for (size_t i = 0; i < oldCache.m_Fonts.size(); i++)
+		{
+			if (!taken[i])
+				dirty = true;
+		}
+
+		oldCache.release();
+
+		if (dirty)
+			cache.outputToFile(desc.CachePath);
+
+		return cache;
 	}
 
 	void WriteNaiveFont(StreamWriter& stream, const NaiveFont& naiveFont)
 	{
-		MemoryBuffer fontMemory{ reinterpret_cast<void*>(naiveFont.AtlasData), naiveFont.AtlasSize };
-		MemoryBuffer fontFileMemory{ reinterpret_cast<void*>(naiveFont.FontFileData), naiveFont.FontFileSize };
+		std::vector<uint8_t> atlas(naiveFont.AtlasData, naiveFont.AtlasData + naiveFont.AtlasSize);
+		Utils::DeltaEncode(atlas, getChannelCount(naiveFont.Params.Format));
+
+		std::vector<uint8_t> compressed = compressLZ(atlas);
+		MemoryBuffer fontMemory{ compressed.data(), compressed.size() };
 
 		stream.writeString(naiveFont.Name);
-		stream.writeBuffer(fontFileMemory);
+		stream.writeString(naiveFont.SourcePath);
+		stream.writeRaw(naiveFont.SHA256);
+		stream.writeRaw<uint32_t>(naiveFont.MinChar);
+		stream.writeRaw<uint32_t>(naiveFont.MaxChar);
+		stream.writeRaw<FontAtlasParams>(naiveFont.Params);
+		stream.writeRaw<FontMetrics>(naiveFont.Data.Metrics);
+		stream.writeArray<GlyphMetrics>(naiveFont.Data.Glyphs);
+		stream.writeArray<KerningPair>(naiveFont.Data.Kerning);
 		stream.writeRaw<size_t>(naiveFont.AtlasSize);
 		stream.writeRaw<uint32_t>(naiveFont.Width);
 		stream.writeRaw<uint32_t>(naiveFont.Height);
@@ -162,21 +305,36 @@ namespace wire {
 	void ReadNaiveFont(StreamReader& stream, NaiveFont& naiveFont)
 	{
 		MemoryBuffer fontMemory;
-		MemoryBuffer fontFileMemory;
 
 		stream.readString(naiveFont.Name);
-		stream.readBuffer(fontFileMemory);
+		stream.readString(naiveFont.SourcePath);
+		stream.readRaw(naiveFont.SHA256);
+		stream.readRaw<uint32_t>(naiveFont.MinChar);
+		stream.readRaw<uint32_t>(naiveFont.MaxChar);
+		stream.readRaw<FontAtlasParams>(naiveFont.Params);
+		stream.readRaw<FontMetrics>(naiveFont.Data.Metrics);
+		stream.readArray<GlyphMetrics>(naiveFont.Data.Glyphs);
+		stream.readArray<KerningPair>(naiveFont.Data.Kerning);
 		stream.readRaw<size_t>(naiveFont.AtlasSize);
 		stream.readRaw<uint32_t>(naiveFont.Width);
 		stream.readRaw<uint32_t>(naiveFont.Height);
 		stream.readBuffer(fontMemory);
 
-		naiveFont.AtlasData = new uint32_t[fontMemory.Size / sizeof(uint32_t)];
-		std::memcpy(naiveFont.AtlasData, fontMemory.Data, fontMemory.Size);
+		naiveFont.AtlasData = new uint8_t[naiveFont.AtlasSize];
+
+		std::span<const uint8_t> compressed(fontMemory.as<const uint8_t>(), fontMemory.Size);
+		if (decompressLZ(compressed, naiveFont.AtlasData, naiveFont.AtlasSize))
+		{
+			Utils::DeltaDecode(naiveFont.AtlasData, naiveFont.AtlasSize, getChannelCount(naiveFont.Params.Format));
+		}
+		else
+		{
+			// left without an atlas, so createOrGetFontCache generates it again
+			WR_ERROR("Font cache entry for {} is corrupt", naiveFont.Name);
+			naiveFont.release();
+		}
 
-		naiveFont.FontFileData = new uint8_t[fontFileMemory.Size];
-		std::memcpy(naiveFont.FontFileData, fontFileMemory.Data, fontFileMemory.Size);
-		naiveFont.FontFileSize = fontFileMemory.Size;
+		fontMemory.release();
 	}
 
 }
@@ -6,15 +6,24 @@
 
 namespace wire {
 
+	class Device;
+
 	struct FontInfo
 	{
 		std::filesystem::path FontTTFPath;
+		uint32_t MinChar = 0x0020, MaxChar = 0x00FF;
+		FontAtlasParams Params;
 	};
 
 	struct FontCacheDesc
 	{
 		std::filesystem::path CachePath;
 		std::vector<FontInfo> FontInfos;
+
+		// generate the distance fields with MSDFComputeGenerator when the device supports it, on the cpu otherwise
+		bool ComputeGeneration = false;
+		// generate on the cpu as well and log the bytes that differ, the cpu atlas is kept when they do
+		bool ValidateComputeGeneration = false;
 	};
 
 	class FontCache
@@ -32,11 +41,17 @@ namespace wire {
 		std::vector<NaiveFont>::const_iterator begin() const { return m_Fonts.begin(); }
 		std::vector<NaiveFont>::const_iterator end() const { return m_Fonts.end(); }
 
+		// one entry per font generated while this cache was built, fonts reused from disk have none
+		const std::vector<FontGenerationTiming>& getGenerationTimings() const { return m_GenerationTimings; }
+
 		static FontCache createFromFile(const std::filesystem::path& path);
-		static FontCache createFontCache(const FontCacheDesc& desc);
-		static FontCache createOrGetFontCache(const FontCacheDesc& desc);
+		// the device is only used for compute generation and may be null
+		static FontCache createFontCache(const FontCacheDesc& desc, Device* device = nullptr);
+		static FontCache createOrGetFontCache(const FontCacheDesc& desc, Device* device = nullptr);
 	private:
+		uint32_t m_Version = 0;
 		std::vector<NaiveFont> m_Fonts;
+		std::vector<FontGenerationTiming> m_GenerationTimings;
 	};
 
 }
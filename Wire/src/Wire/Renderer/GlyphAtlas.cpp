@@ -0,0 +1,343 @@
+#include "GlyphAtlas.h"
+
+#include "Wire/Core/Assert.h"
+#include "Wire/Core/ThreadPool.h"
+
+#include <algorithm>
+
+#undef INFINITE
+#include <msdf-atlas-gen.h>
+
+namespace wire {
+
+    namespace Utils {
+
+        constexpr static double s_AngleThreshold = 3.0;
+
+        // the kerning cache only grows with the pairs that are actually drawn, but is dropped if it gets this big
+        constexpr static size_t s_MaxKerningPairs = 1 << 16;
+
+        // sdf pages are r8, msdf is widened to rgba8 like the baked atlas
+        static uint32_t GetPageTexelSize(FontAtlasFormat format)
+        {
+            return format == FontAtlasFormat::SDF ? 1 : 4;
+        }
+
+        static void ScaleFontMetrics(const msdfgen::FontMetrics& metrics, double scale, FontMetrics& outMetrics)
+        {
+            outMetrics.EmSize = metrics.emSize * scale;
+            outMetrics.AscenderY = metrics.ascenderY * scale;
+            outMetrics.DescenderY = metrics.descenderY * scale;
+            outMetrics.LineHeight = metrics.lineHeight * scale;
+            outMetrics.UnderlineY = metrics.underlineY * scale;
+            outMetrics.UnderlineThickness = metrics.underlineThickness * scale;
+        }
+
+    }
+
+    GlyphAtlas::GlyphAtlas(Device* device, const GlyphAtlasDesc& desc, std::string_view debugName)
+        : m_Device(device), m_Desc(desc), m_DebugName(debugName)
+    {
+        WR_ASSERT(desc.CellSize > 0 && desc.CellSize <= desc.PageSize, "Glyph atlas cells must fit in a page!");
+
+        m_CellsPerRow = desc.PageSize / desc.CellSize;
+        m_CellsPerPage = m_CellsPerRow * m_CellsPerRow;
+
+        m_Freetype = msdfgen::initializeFreetype();
+        WR_ASSERT(m_Freetype, "Failed to initialize freetype!");
+
+        std::string fileString = desc.FontTTFPath.string();
+
+        m_Font = msdfgen::loadFont(m_Freetype, fileString.c_str());
+        if (!m_Font)
+        {
+            WR_ERROR("Failed to load font {}", fileString);
+            return;
+        }
+
+        msdfgen::FontMetrics metrics{};
+        msdfgen::getFontMetrics(metrics, m_Font);
+        if (metrics.emSize <= 0)
+            metrics.emSize = MSDF_ATLAS_DEFAULT_EM_SIZE;
+
+        // the same em units as the baked atlas
+        m_GeometryScale = 1.0 / metrics.emSize;
+        Utils::ScaleFontMetrics(metrics, m_GeometryScale, m_Metrics);
+    }
+
+    GlyphAtlas::~GlyphAtlas()
+    {
+        // workers use the font handle
+        for (auto& task : m_Tasks)
+            task.wait();
+
+        if (m_Font)
+            msdfgen::destroyFont(m_Font);
+        if (m_Freetype)
+            msdfgen::deinitializeFreetype(m_Freetype);
+
+        for (const auto& page : m_Pages)
+            m_Device->drop(page);
+    }
+
+    const AtlasGlyph* GlyphAtlas::getGlyph(uint32_t codepoint)
+    {
+        if (!m_Font)
+            return nullptr;
+
+        auto [it, inserted] = m_Entries.try_emplace(codepoint);
+        Entry& entry = it->second;
+
+        if (inserted)
+        {
+            m_Tasks.push_back(ThreadPool::shared().submit([this, codepoint]() { rasterize(codepoint); }));
+            return nullptr;
+        }
+
+        if (!entry.Resident)
+            return nullptr;
+
+        entry.LastUsedFrame = m_Frame;
+        if (entry.Cell != UINT32_MAX)
+            m_LRU.splice(m_LRU.end(), m_LRU, entry.LRU);
+
+        return &entry.Glyph;
+    }
+
+    double GlyphAtlas::getKerning(uint32_t first, uint32_t second)
+    {
+        if (!m_Font)
+            return 0.0;
+
+        uint64_t key = (static_cast<uint64_t>(first) << 32) | second;
+
+        auto it = m_Kerning.find(key);
+        if (it != m_Kerning.end())
+            return it->second;
+
+        double kerning = 0.0;
+        {
+            std::lock_guard lock(m_FontMutex);
+            if (!msdfgen::getKerning(kerning, m_Font, first, second))
+                kerning = 0.0;
+        }
+
+        if (m_Kerning.size() >= Utils::s_MaxKerningPairs)
+            m_Kerning.clear();
+
+        kerning *= m_GeometryScale;
+        m_Kerning[key] = kerning;
+
+        return kerning;
+    }
+
+    void GlyphAtlas::update()
+    {
+        m_Frame++;
+
+        std::erase_if(m_Tasks, [](const std::future<void>& task) { return task.wait_for(std::chrono::seconds(0)) == std::future_status::ready; });
+
+        std::vector<RasterizedGlyph> finished;
+        {
+            std::lock_guard lock(m_Mutex);
+            finished = std::move(m_Finished);
+            m_Finished.clear();
+        }
+
+        std::vector<std::vector<TextureRegion>> regions;
+        std::vector<RasterizedGlyph> deferred;
+
+        for (auto& glyph : finished)
+        {
+            Entry& entry = m_Entries[glyph.Codepoint];
+
+            if (!glyph.Found)
+            {
+                entry.Missing = true;
+                continue;
+            }
+
+            entry.Glyph.Metrics = glyph.Metrics;
+
+            // whitespace has nothing to draw, so it never takes a cell
+            if (glyph.Pixels.empty())
+            {
+                entry.Resident = true;
+                continue;
+            }
+
+            uint32_t cell;
+            if (!allocateCell(cell))
+            {
+                // every cell was drawn last frame, try again on the next one
+                deferred.push_back(std::move(glyph));
+                continue;
+            }
+
+            uint32_t page = cell / m_CellsPerPage;
+            uint32_t index = cell % m_CellsPerPage;
+            uint32_t x = (index % m_CellsPerRow) * m_Desc.CellSize;
+            uint32_t y = (index / m_CellsPerRow) * m_Desc.CellSize;
+
+            GlyphMetrics& metrics = entry.Glyph.Metrics;
+            metrics.AtlasLeft += x;
+            metrics.AtlasRight += x;
+            metrics.AtlasBottom += y;
+            metrics.AtlasTop += y;
+
+            entry.Glyph.Page = page;
+            entry.Cell = cell;
+            entry.Resident = true;
+            entry.LastUsedFrame = m_Frame;
+            entry.LRU = m_LRU.insert(m_LRU.end(), glyph.Codepoint);
+
+            if (regions.size() <= page)
+                regions.resize(page + 1);
+
+            regions[page].push_back({ glyph.Pixels.data(), x, y, glyph.Width, glyph.Height });
+        }
+
+        for (size_t page = 0; page < regions.size(); page++)
+            m_Pages[page]->update(regions[page]);
+
+        if (!deferred.empty())
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Finished.insert(m_Finished.end(), std::make_move_iterator(deferred.begin()), std::make_move_iterator(deferred.end()));
+        }
+    }
+
+    void GlyphAtlas::rasterize(uint32_t codepoint)
+    {
+        RasterizedGlyph glyph;
+        glyph.Codepoint = codepoint;
+
+        msdf_atlas::GlyphGeometry geometry;
+        {
+            std::lock_guard lock(m_FontMutex);
+            glyph.Found = geometry.load(m_Font, m_GeometryScale, codepoint);
+        }
+
+        if (glyph.Found)
+        {
+            GlyphMetrics& metrics = glyph.Metrics;
+            metrics.Codepoint = codepoint;
+            metrics.Advance = geometry.getAdvance();
+
+            if (!geometry.isWhitespace())
+            {
+                geometry.edgeColoring(msdfgen::edgeColoringInkTrap, Utils::s_AngleThreshold, 0);
+
+                double scale = m_Desc.Params.EmSize;
+                geometry.wrapBox(scale, m_Desc.Params.PixelRange / scale, m_Desc.Params.MiterLimit);
+
+                int width, height;
+                geometry.getBoxSize(width, height);
+
+                while (width > (int)m_Desc.CellSize || height > (int)m_Desc.CellSize)
+                {
+                    scale *= std::min((double)m_Desc.CellSize / width, (double)m_Desc.CellSize / height) * 0.99;
+                    geometry.wrapBox(scale, m_Desc.Params.PixelRange / scale, m_Desc.Params.MiterLimit);
+                    geometry.getBoxSize(width, height);
+                }
+
+                // atlas bounds are relative to the cell until the glyph is placed
+                geometry.placeBox(0, 0);
+                geometry.getQuadPlaneBounds(metrics.PlaneLeft, metrics.PlaneBottom, metrics.PlaneRight, metrics.PlaneTop);
+                geometry.getQuadAtlasBounds(metrics.AtlasLeft, metrics.AtlasBottom, metrics.AtlasRight, metrics.AtlasTop);
+
+                msdf_atlas::GeneratorAttributes attributes;
+                attributes.config.overlapSupport = true;
+                attributes.scanlinePass = true;
+
+                uint32_t channels = getChannelCount(m_Desc.Params.Format);
+                std::vector<float> pixels(static_cast<size_t>(channels) * width * height);
+
+                switch (m_Desc.Params.Format)
+                {
+                    case FontAtlasFormat::MTSDF:
+                        msdf_atlas::mtsdfGenerator(msdfgen::BitmapRef<float, 4>(pixels.data(), width, height), geometry, attributes);
+                        break;
+                    case FontAtlasFormat::MSDF:
+                        msdf_atlas::msdfGenerator(msdfgen::BitmapRef<float, 3>(pixels.data(), width, height), geometry, attributes);
+                        break;
+                    case FontAtlasFormat::SDF:
+                        msdf_atlas::sdfGenerator(msdfgen::BitmapRef<float, 1>(pixels.data(), width, height), geometry, attributes);
+                        break;
+                }
+
+                // the whole cell is uploaded, so nothing of the glyph that used it before can bleed into this one
+                uint32_t texelSize = Utils::GetPageTexelSize(m_Desc.Params.Format);
+
+                glyph.Width = m_Desc.CellSize;
+                glyph.Height = m_Desc.CellSize;
+                glyph.Pixels.resize(static_cast<size_t>(texelSize) * m_Desc.CellSize * m_Desc.CellSize);
+
+                for (int row = 0; row < height; row++)
+                {
+                    const float* source = pixels.data() + static_cast<size_t>(channels) * width * row;
+                    uint8_t* destination = glyph.Pixels.data() + static_cast<size_t>(texelSize) * m_Desc.CellSize * row;
+
+                    for (int column = 0; column < width; column++)
+                    {
+                        // msdf pages are rgba8, the unused alpha is left opaque
+                        for (uint32_t channel = 0; channel < texelSize; channel++)
+                            destination[channel] = channel < channels ? msdfgen::pixelFloatToByte(source[channel]) : 255;
+
+                        source += channels;
+                        destination += texelSize;
+                    }
+                }
+            }
+        }
+
+        std::lock_guard lock(m_Mutex);
+        m_Finished.push_back(std::move(glyph));
+    }
+
+    bool GlyphAtlas::allocateCell(uint32_t& outCell)
+    {
+        if (m_FreeCells.empty() && m_Pages.size() < m_Desc.PageCount)
+            addPage();
+
+        if (!m_FreeCells.empty())
+        {
+            outCell = m_FreeCells.back();
+            m_FreeCells.pop_back();
+
+            return true;
+        }
+
+        if (m_LRU.empty())
+            return false;
+
+        // update() runs before this frame's text, so nothing carries m_Frame yet except the glyphs placed just now.
+        // what was drawn last frame is most likely drawn again, replacing it would thrash, so only older glyphs go
+        auto victim = m_Entries.find(m_LRU.front());
+        if (victim->second.LastUsedFrame + 1 >= m_Frame)
+            return false;
+
+        outCell = victim->second.Cell;
+
+        m_LRU.pop_front();
+        m_Entries.erase(victim);
+        m_EvictionCount++;
+
+        return true;
+    }
+
+    void GlyphAtlas::addPage()
+    {
+        uint32_t page = static_cast<uint32_t>(m_Pages.size());
+
+        TextureFormat format = m_Desc.Params.Format == FontAtlasFormat::SDF ? TextureFormat::R8 : TextureFormat::RGBA8;
+
+        std::vector<uint8_t> data(static_cast<size_t>(m_Desc.PageSize) * m_Desc.PageSize * Utils::GetPageTexelSize(m_Desc.Params.Format), 0);
+        m_Pages.push_back(m_Device->createTexture2D(data.data(), m_Desc.PageSize, m_Desc.PageSize, format, std::format("{} (page {})", m_DebugName, page)));
+
+        // handed out from the back, so the page fills from its first cell
+        for (uint32_t i = m_CellsPerPage; i > 0; i--)
+            m_FreeCells.push_back(page * m_CellsPerPage + i - 1);
+    }
+
+}
@@ -0,0 +1,119 @@
+#pragma once
+
+#include "Device.h"
+#include "Font.h"
+#include "MSDFData.h"
+
+#include <list>
+#include <mutex>
+#include <future>
+#include <memory>
+#include <vector>
+#include <filesystem>
+#include <unordered_map>
+
+namespace msdfgen {
+
+    class FreetypeHandle;
+    class FontHandle;
+
+}
+
+namespace wire {
+
+    struct GlyphAtlasDesc
+    {
+        std::filesystem::path FontTTFPath;
+        uint32_t PageSize = 1024; // width and height of every page
+        uint32_t PageCount = 2;   // pages are created as they are needed, this bounds the memory used
+        uint32_t CellSize = 48;   // glyphs that do not fit a cell at EmSize are rasterized smaller
+        FontAtlasParams Params;
+    };
+
+    struct AtlasGlyph
+    {
+        GlyphMetrics Metrics; // atlas bounds are in pixels of the page
+        uint32_t Page = 0;
+    };
+
+    // rasterizes glyphs the first time they are used instead of baking a whole charset up front.
+    // glyphs are kept in fixed size cells across a few pages, and the least recently used cells are reused once they are full
+    class GlyphAtlas
+    {
+    public:
+        GlyphAtlas(Device* device, const GlyphAtlasDesc& desc, std::string_view debugName = {});
+        ~GlyphAtlas();
+
+        GlyphAtlas(const GlyphAtlas&) = delete;
+        GlyphAtlas& operator=(const GlyphAtlas&) = delete;
+
+        // null until the glyph has been rasterized and uploaded, the first call queues it on the thread pool
+        const AtlasGlyph* getGlyph(uint32_t codepoint);
+        double getKerning(uint32_t first, uint32_t second);
+
+        // uploads the glyphs finished since the last call, once per frame before any text is recorded
+        void update();
+
+        bool isValid() const { return m_Font != nullptr; }
+        const FontMetrics& getMetrics() const { return m_Metrics; }
+        const std::vector<std::shared_ptr<Texture2D>>& getPages() const { return m_Pages; }
+
+        uint32_t getResidentGlyphCount() const { return static_cast<uint32_t>(m_LRU.size()); }
+        uint64_t getEvictionCount() const { return m_EvictionCount; }
+    private:
+        struct RasterizedGlyph
+        {
+            uint32_t Codepoint = 0;
+            bool Found = false;
+            GlyphMetrics Metrics{};
+
+            // a whole cell in the page format, empty for whitespace
+            std::vector<uint8_t> Pixels;
+            uint32_t Width = 0, Height = 0;
+        };
+
+        struct Entry
+        {
+            AtlasGlyph Glyph;
+            bool Resident = false;
+            bool Missing = false;
+
+            uint32_t Cell = UINT32_MAX;
+            uint64_t LastUsedFrame = 0;
+            std::list<uint32_t>::iterator LRU;
+        };
+
+        void rasterize(uint32_t codepoint);
+        bool allocateCell(uint32_t& outCell);
+        void addPage();
+    private:
+        Device* m_Device = nullptr;
+        GlyphAtlasDesc m_Desc;
+        std::string m_DebugName;
+
+        msdfgen::FreetypeHandle* m_Freetype = nullptr;
+        msdfgen::FontHandle* m_Font = nullptr;
+        std::mutex m_FontMutex; // freetype faces are not thread safe
+
+        double m_GeometryScale = 1.0;
+        FontMetrics m_Metrics{};
+
+        uint32_t m_CellsPerRow = 0;
+        uint32_t m_CellsPerPage = 0;
+
+        std::vector<std::shared_ptr<Texture2D>> m_Pages;
+        std::vector<uint32_t> m_FreeCells;
+
+        std::unordered_map<uint32_t, Entry> m_Entries;
+        std::list<uint32_t> m_LRU; // glyphs that own a cell, least recently used first
+        std::unordered_map<uint64_t, double> m_Kerning;
+
+        uint64_t m_Frame = 1;
+        uint64_t m_EvictionCount = 0;
+
+        std::mutex m_Mutex;
+        std::vector<RasterizedGlyph> m_Finished;
+        std::vector<std::future<void>> m_Tasks;
+    };
+
+}
@@ -19,6 +19,12 @@ namespace wire {
         LineStrip
     };
 
+    enum class VertexInputRate
+    {
+        Vertex = 0,
+        Instance
+    };
+
     enum class ShaderDataType
     {
         None = 0, Float, Float2, Float3, Float4, Mat3, Mat4, Int, Int2, Int3, Int4, UInt, UInt2, UInt3, UInt4, Bool
@@ -39,27 +45,53 @@ namespace wire {
         ShaderType Shader;
     };
 
+    // applies to every stage, ids a stage does not declare are ignored
+    struct SpecializationConstant
+    {
+        uint32_t ID;
+        uint32_t Value; // bit pattern of a bool, int, uint or float constant (std::bit_cast for floats)
+    };
+
     struct InputLayout
     {
         std::vector<InputElement> VertexBufferLayout;
         size_t Stride = 0;
+        // with Instance the buffer advances once per instance, the vertex shader builds its vertices from SV_VertexID
+        VertexInputRate InputRate = VertexInputRate::Vertex;
 
         std::vector<PushConstantInfo> PushConstantInfos;
         std::shared_ptr<ShaderResourceLayout> ResourceLayout;
     };
 
+    class GraphicsPipeline;
+
     struct GraphicsPipelineDesc
     {
         std::string ShaderPath;
+        uint32_t ShaderVariant = 0; // see ShaderCache::getVariantKey
         InputLayout Layout;
         PrimitiveTopology Topology;
         std::shared_ptr<RenderPass> RenderPass;
+        std::vector<SpecializationConstant> SpecializationConstants;
+
+        // compile on a worker thread, the pipeline can be bound once isReady() returns true
+        bool CompileAsync = false;
+        // bound in place of the pipeline while it is compiling, must have a compatible layout
+        std::shared_ptr<GraphicsPipeline> Fallback;
     };
 
     class GraphicsPipeline : public IResource
     {
     public:
         virtual ~GraphicsPipeline() = default;
+
+        virtual bool isReady() const = 0;
+        virtual void wait() const = 0;
+
+        virtual std::shared_ptr<GraphicsPipeline> getFallback() const = 0;
+
+        // the desc layout, or the one reflected from the shader when the desc left it empty
+        virtual std::shared_ptr<ShaderResourceLayout> getResourceLayout() const = 0;
     };
 
 }
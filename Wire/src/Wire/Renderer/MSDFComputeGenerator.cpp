@@ -0,0 +1,359 @@
+#include "MSDFComputeGenerator.h"
+
+#include "Wire/Core/Assert.h"
+
+#include <string>
+#include <algorithm>
+
+#undef INFINITE
+#include <msdf-atlas-gen.h>
+
+namespace wire {
+
+    namespace Utils {
+
+        constexpr static std::string_view s_ShaderPath = "shadercache://MSDFGenerate.compute.hlsl";
+
+        // MAX_CONTOURS in the shader, every thread keeps a distance per contour
+        constexpr static size_t s_MaxContours = 32;
+
+        // every contour keeps a selector per texel between the passes, glyphs are split into batches to bound them
+        constexpr static size_t s_MaxSelectorBytes = 64 * 1024 * 1024;
+
+        // the structured buffers of MSDFGenerate.compute.hlsl
+        struct GlyphData
+        {
+            uint32_t FirstContour;
+            uint32_t ContourCount;
+            uint32_t Width;
+            uint32_t Height;
+            uint32_t OutputOffset;    // in floats
+            uint32_t FirstCoordinate; // Width unprojected x coordinates, then Height y coordinates
+            uint32_t InverseY;
+            uint32_t FirstSelector; // relative to the batch
+            double InvRange;
+        };
+
+        struct ContourData
+        {
+            uint32_t FirstEdge;
+            uint32_t EdgeCount;
+            int32_t Winding;
+            uint32_t Glyph;
+        };
+
+        struct EdgeData
+        {
+            double P[8];
+            uint32_t Degree; // 1 = linear, 2 = quadratic, 3 = cubic
+            uint32_t Color;
+        };
+
+        // msdfgen's EdgeCache, the shader fills them in before the first texel of a glyph
+        struct EdgeCache
+        {
+            double PointX;
+            double PointY;
+            double AbsDistance;
+            double ADomainDistance;
+            double BDomainDistance;
+            double APseudoDistance;
+            double BPseudoDistance;
+            double Padding;
+        };
+
+        // Selector in the shader, three PseudoDistanceSelectorBase
+        struct ContourSelector
+        {
+            struct Channel
+            {
+                double MinTrueDistance;
+                double MinTrueDot;
+                double MinNegativePseudoDistance;
+                double MinPositivePseudoDistance;
+                int32_t NearEdge;
+                double NearEdgeParam;
+            };
+
+            Channel Channels[3];
+        };
+
+        static_assert(sizeof(GlyphData) == 40 && sizeof(ContourData) == 16 && sizeof(EdgeData) == 72 && sizeof(EdgeCache) == 64 && sizeof(ContourSelector) == 144, "Layouts must match the shader!");
+
+        // the push constants of MSDFGenerate.compute.hlsl, a batch of glyphs and their contours
+        struct Batch
+        {
+            uint32_t FirstGlyph = 0;
+            uint32_t GlyphCount = 0;
+            uint32_t FirstContour = 0;
+            uint32_t ContourCount = 0;
+        };
+
+
+        static bool GetEdgeData(const msdfgen::EdgeSegment* segment, EdgeData& outEdge)
+        {
+            const msdfgen::Point2* points = nullptr;
+
+            if (auto linear = dynamic_cast<const msdfgen::LinearSegment*>(segment))
+            {
+                points = linear->p;
+                outEdge.Degree = 1;
+            }
+            else if (auto quadratic = dynamic_cast<const msdfgen::QuadraticSegment*>(segment))
+            {
+                points = quadratic->p;
+                outEdge.Degree = 2;
+            }
+            else if (auto cubic = dynamic_cast<const msdfgen::CubicSegment*>(segment))
+            {
+                points = cubic->p;
+                outEdge.Degree = 3;
+            }
+            else
+                return false;
+
+            for (uint32_t i = 0; i <= outEdge.Degree; i++)
+            {
+                outEdge.P[i * 2] = points[i].x;
+                outEdge.P[i * 2 + 1] = points[i].y;
+            }
+
+            outEdge.Color = static_cast<uint32_t>(segment->color);
+            return true;
+        }
+
+        static size_t GetPipelineIndex(uint32_t channelCount)
+        {
+            switch (channelCount)
+            {
+                case 1: return 0;
+                case 3: return 1;
+                case 4: return 2;
+            }
+
+            WR_ASSERT(false, "Unsupported distance field channel count!");
+            return 0;
+        }
+
+    }
+
+    MSDFComputeGenerator::MSDFComputeGenerator(Device* device, bool validate)
+        : m_Device(device), m_Validate(validate)
+    {
+        // the cpu generator works in doubles, floats would move the edges by whole texels on large glyphs
+        m_Supported = device && device->supportsShaderFloat64() && device->getShaderCache().hasShader(Utils::s_ShaderPath);
+    }
+
+    MSDFComputeGenerator::~MSDFComputeGenerator()
+    {
+        for (const auto& pipeline : m_Pipelines)
+        {
+            if (pipeline)
+                m_Device->drop(pipeline);
+        }
+    }
+
+    bool MSDFComputeGenerator::generate(const std::vector<msdf_atlas::GlyphGeometry>& glyphs, uint32_t channelCount, std::vector<std::vector<float>>& outDistances)
+    {
+        if (!m_Supported)
+            return false;
+
+        outDistances.assign(glyphs.size(), {});
+
+        std::vector<Utils::GlyphData> glyphData;
+        std::vector<Utils::ContourData> contourData;
+        std::vector<Utils::EdgeData> edgeData;
+        std::vector<double> coordinates;
+        std::vector<size_t> glyphIndices; // the glyph each GlyphData came from
+
+        std::vector<Utils::Batch> batches;
+        std::vector<uint32_t> batchTexelCounts; // the most texels of a glyph in each batch
+        size_t batchSelectorCount = 0;
+        size_t maxSelectorCount = 1;
+
+        uint32_t outputSize = 0;
+
+        for (size_t i = 0; i < glyphs.size(); i++)
+        {
+            const msdf_atlas::GlyphGeometry& glyph = glyphs[i];
+            const msdfgen::Shape& shape = glyph.getShape();
+            if (glyph.isWhitespace() || shape.contours.size() > Utils::s_MaxContours)
+                continue;
+
+            int l, b, w, h;
+            glyph.getBoxRect(l, b, w, h);
+            if (w <= 0 || h <= 0)
+                continue;
+
+            size_t firstContour = contourData.size();
+            size_t firstEdge = edgeData.size();
+
+            bool supported = true;
+            for (const msdfgen::Contour& contour : shape.contours)
+            {
+                Utils::ContourData& data = contourData.emplace_back();
+                data.FirstEdge = static_cast<uint32_t>(edgeData.size());
+                data.EdgeCount = static_cast<uint32_t>(contour.edges.size());
+                data.Winding = contour.winding();
+                data.Glyph = static_cast<uint32_t>(glyphData.size());
+
+                for (const msdfgen::EdgeHolder& edge : contour.edges)
+                    supported &= Utils::GetEdgeData(edge, edgeData.emplace_back());
+            }
+
+            if (!supported)
+            {
+                contourData.resize(firstContour);
+                edgeData.resize(firstEdge);
+                continue;
+            }
+
+            uint32_t texelCount = static_cast<uint32_t>(w * h);
+            size_t selectorCount = static_cast<size_t>(texelCount) * shape.contours.size();
+
+            // a glyph too large for the limit still gets a batch of its own
+            if (batches.empty() || (batches.back().GlyphCount > 0 && (batchSelectorCount + selectorCount) * sizeof(Utils::ContourSelector) > Utils::s_MaxSelectorBytes))
+            {
+                Utils::Batch& batch = batches.emplace_back();
+                batch.FirstGlyph = static_cast<uint32_t>(glyphData.size());
+                batch.FirstContour = static_cast<uint32_t>(firstContour);
+
+                batchTexelCounts.push_back(0);
+                batchSelectorCount = 0;
+            }
+
+            Utils::GlyphData& data = glyphData.emplace_back();
+            data.FirstContour = static_cast<uint32_t>(firstContour);
+            data.ContourCount = static_cast<uint32_t>(shape.contours.size());
+            data.Width = static_cast<uint32_t>(w);
+            data.Height = static_cast<uint32_t>(h);
+            data.OutputOffset = outputSize;
+            data.FirstCoordinate = static_cast<uint32_t>(coordinates.size());
+            data.InverseY = shape.inverseYAxis;
+            data.FirstSelector = static_cast<uint32_t>(batchSelectorCount);
+            data.InvRange = 1 / glyph.getBoxRange();
+
+            // unprojected here with the same arithmetic as Projection::unproject
+            msdfgen::Projection projection = glyph.getBoxProjection();
+            for (int x = 0; x < w; x++)
+                coordinates.push_back(projection.unprojectX(x + .5));
+            for (int y = 0; y < h; y++)
+                coordinates.push_back(projection.unprojectY(y + .5));
+
+            outputSize += texelCount * channelCount;
+
+            Utils::Batch& batch = batches.back();
+            batch.GlyphCount++;
+            batch.ContourCount += data.ContourCount;
+
+            batchTexelCounts.back() = std::max(batchTexelCounts.back(), texelCount);
+            batchSelectorCount += selectorCount;
+            maxSelectorCount = std::max(maxSelectorCount, batchSelectorCount);
+
+            glyphIndices.push_back(i);
+        }
+
+        if (glyphData.empty())
+            return true;
+
+        // zero contour glyphs still write their texels, the buffers just need an element to bind
+        if (contourData.empty())
+            contourData.emplace_back();
+        if (edgeData.empty())
+            edgeData.emplace_back();
+
+        std::lock_guard lock(m_Mutex);
+
+        std::shared_ptr<ComputePipeline> contourPipeline = getPipeline(channelCount, 0);
+        std::shared_ptr<ComputePipeline> texelPipeline = getPipeline(channelCount, 1);
+        size_t outputBytes = static_cast<size_t>(outputSize) * sizeof(float);
+
+        std::shared_ptr<Buffer> glyphBuffer = m_Device->createBuffer(StorageBuffer, glyphData.size() * sizeof(Utils::GlyphData), glyphData.data(), "MSDFComputeGenerator::glyphBuffer");
+        std::shared_ptr<Buffer> contourBuffer = m_Device->createBuffer(StorageBuffer, contourData.size() * sizeof(Utils::ContourData), contourData.data(), "MSDFComputeGenerator::contourBuffer");
+        std::shared_ptr<Buffer> edgeBuffer = m_Device->createBuffer(StorageBuffer, edgeData.size() * sizeof(Utils::EdgeData), edgeData.data(), "MSDFComputeGenerator::edgeBuffer");
+        std::shared_ptr<Buffer> edgeCacheBuffer = m_Device->createBuffer(StorageBuffer, edgeData.size() * sizeof(Utils::EdgeCache), nullptr, "MSDFComputeGenerator::edgeCacheBuffer");
+        std::shared_ptr<Buffer> selectorBuffer = m_Device->createBuffer(StorageBuffer, maxSelectorCount * sizeof(Utils::ContourSelector), nullptr, "MSDFComputeGenerator::selectorBuffer");
+        std::shared_ptr<Buffer> coordinateBuffer = m_Device->createBuffer(StorageBuffer, coordinates.size() * sizeof(double), coordinates.data(), "MSDFComputeGenerator::coordinateBuffer");
+        std::shared_ptr<Buffer> outputBuffer = m_Device->createBuffer(StorageBuffer, outputBytes, nullptr, "MSDFComputeGenerator::outputBuffer");
+        std::shared_ptr<Buffer> readbackBuffer = m_Device->createBuffer(StagingBuffer, outputBytes, nullptr, "MSDFComputeGenerator::readbackBuffer");
+
+        // both passes are the same shader, so they share the reflected layout
+        std::shared_ptr<ShaderResource> resource = m_Device->createShaderResource(0, contourPipeline->getResourceLayout(), "MSDFComputeGenerator::resource");
+        resource->update(glyphBuffer, 0, 0);
+        resource->update(contourBuffer, 1, 0);
+        resource->update(edgeBuffer, 2, 0);
+        resource->update(coordinateBuffer, 3, 0);
+        resource->update(outputBuffer, 4, 0);
+        resource->update(edgeCacheBuffer, 5, 0);
+        resource->update(selectorBuffer, 6, 0);
+
+        CommandList commandList = m_Device->beginSingleTimeCommands();
+
+        // a thread per contour replays the cpu's texel order, then a thread per texel combines the contours.
+        // batches reuse the selector buffer, so every pass waits for the one before it
+        for (size_t i = 0; i < batches.size(); i++)
+        {
+            const Utils::Batch& batch = batches[i];
+
+            if (i > 0)
+                commandList.bufferMemoryBarrier(selectorBuffer, BarrierMask::ShaderRead, BarrierMask::ShaderWrite, PipelineStage::ComputeShader, PipelineStage::ComputeShader);
+
+            commandList.bindPipeline(contourPipeline);
+            commandList.pushConstants(ShaderType::Compute, batch);
+            commandList.bindShaderResource(0, resource);
+            commandList.dispatchThreads(std::max(batch.ContourCount, 1u));
+
+            commandList.bufferMemoryBarrier(selectorBuffer, BarrierMask::ShaderWrite, BarrierMask::ShaderRead, PipelineStage::ComputeShader, PipelineStage::ComputeShader);
+
+            commandList.bindPipeline(texelPipeline);
+            commandList.pushConstants(ShaderType::Compute, batch);
+            commandList.bindShaderResource(0, resource);
+            commandList.dispatchThreads(batchTexelCounts[i], batch.GlyphCount);
+        }
+
+        commandList.bufferMemoryBarrier(outputBuffer, BarrierMask::ShaderWrite, BarrierMask::TransferRead, PipelineStage::ComputeShader, PipelineStage::Transfer);
+        commandList.copyBuffer(outputBuffer, readbackBuffer, outputBytes);
+
+        m_Device->endSingleTimeCommands(commandList);
+
+        const float* output = static_cast<const float*>(readbackBuffer->map(outputBytes));
+        for (size_t i = 0; i < glyphData.size(); i++)
+        {
+            const Utils::GlyphData& data = glyphData[i];
+            const float* pixels = output + data.OutputOffset;
+
+            outDistances[glyphIndices[i]].assign(pixels, pixels + static_cast<size_t>(data.Width) * data.Height * channelCount);
+        }
+        readbackBuffer->unmap();
+
+        m_Device->drop(resource);
+        m_Device->drop(glyphBuffer);
+        m_Device->drop(contourBuffer);
+        m_Device->drop(edgeBuffer);
+        m_Device->drop(edgeCacheBuffer);
+        m_Device->drop(selectorBuffer);
+        m_Device->drop(coordinateBuffer);
+        m_Device->drop(outputBuffer);
+        m_Device->drop(readbackBuffer);
+
+        return true;
+    }
+
+    std::shared_ptr<ComputePipeline> MSDFComputeGenerator::getPipeline(uint32_t channelCount, uint32_t pass)
+    {
+        std::shared_ptr<ComputePipeline>& pipeline = m_Pipelines[Utils::GetPipelineIndex(channelCount) * 2 + pass];
+        if (pipeline)
+            return pipeline;
+
+        ComputePipelineDesc desc{};
+        desc.ShaderPath = std::string(Utils::s_ShaderPath);
+        desc.Layout.PushConstantInfos = {
+            { sizeof(Utils::Batch), 0, ShaderType::Compute }
+        };
+        desc.SpecializationConstants = { { 0, channelCount }, { 1, pass } };
+
+        pipeline = m_Device->createComputePipeline(desc, "MSDFComputeGenerator::m_Pipelines");
+        return pipeline;
+    }
+
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "Device.h"
+
+#include <mutex>
+#include <memory>
+#include <vector>
+
+namespace msdf_atlas {
+
+    class GlyphGeometry;
+
+}
+
+namespace wire {
+
+    // evaluates the distance fields of baked font atlases in a compute shader (MSDFGenerate.compute.hlsl).
+    // the shader is a double precision port of msdfgen's distance search, the scanline sign correction and
+    // error correction that follow it still run on the cpu, so the atlas comes out like the cpu generator's.
+    // the shader has not been compiled against a real driver yet, so it lives outside shaders/ (see Application)
+    class MSDFComputeGenerator
+    {
+    public:
+        // with validate every atlas is generated on the cpu as well, and the bytes that differ are reported
+        MSDFComputeGenerator(Device* device, bool validate = false);
+        ~MSDFComputeGenerator();
+
+        MSDFComputeGenerator(const MSDFComputeGenerator&) = delete;
+        MSDFComputeGenerator& operator=(const MSDFComputeGenerator&) = delete;
+
+        // needs shaderFloat64 and the shader in the shader cache
+        bool isSupported() const { return m_Supported; }
+        bool isValidating() const { return m_Validate; }
+
+        // the raw distance field of every glyph, channelCount floats per texel laid out like msdfgen::BitmapRef.
+        // glyphs left to the cpu (whitespace, too many contours) get no floats, false if the gpu could not be used at all
+        bool generate(const std::vector<msdf_atlas::GlyphGeometry>& glyphs, uint32_t channelCount, std::vector<std::vector<float>>& outDistances);
+    private:
+        // pass 0 walks the texels per contour, pass 1 combines the contours per texel
+        std::shared_ptr<ComputePipeline> getPipeline(uint32_t channelCount, uint32_t pass);
+    private:
+        Device* m_Device = nullptr;
+        bool m_Supported = false;
+        bool m_Validate = false;
+
+        // single time commands are not thread safe, and fonts are generated side by side
+        std::mutex m_Mutex;
+        std::shared_ptr<ComputePipeline> m_Pipelines[6]; // both passes of sdf, msdf and mtsdf
+    };
+
+}
@@ -1,16 +1,71 @@
 #pragma once
 
 #include <vector>
-
-#undef INFINITE
-#include <msdf-atlas-gen.h>
+#include <cstdint>
+#include <algorithm>
 
 namespace wire {
 
+	// everything text layout needs from a font, stored in the font cache so cached fonts never touch freetype
+	struct GlyphMetrics
+	{
+		uint32_t Codepoint;
+		double Advance;
+		double PlaneLeft, PlaneBottom, PlaneRight, PlaneTop; // in em units, relative to the baseline
+		double AtlasLeft, AtlasBottom, AtlasRight, AtlasTop; // in atlas pixels
+	};
+
+	struct KerningPair
+	{
+		uint32_t First, Second;
+		double Advance; // added to the advance of the first glyph
+	};
+
+	struct FontMetrics
+	{
+		double EmSize;
+		double AscenderY, DescenderY;
+		double LineHeight;
+		double UnderlineY, UnderlineThickness;
+	};
+
 	struct MSDFData
 	{
-		std::vector<msdf_atlas::GlyphGeometry> Glyphs;
-		msdf_atlas::FontGeometry FontGeometry;
+		std::vector<GlyphMetrics> Glyphs; // sorted by codepoint
+		std::vector<KerningPair> Kerning; // sorted by first, then second
+		FontMetrics Metrics{};
+
+		const GlyphMetrics* getGlyph(uint32_t codepoint) const
+		{
+			auto it = std::lower_bound(Glyphs.begin(), Glyphs.end(), codepoint, [](const GlyphMetrics& glyph, uint32_t c) { return glyph.Codepoint < c; });
+			if (it == Glyphs.end() || it->Codepoint != codepoint)
+				return nullptr;
+
+			return &*it;
+		}
+
+		double getKerning(uint32_t first, uint32_t second) const
+		{
+			auto it = std::lower_bound(Kerning.begin(), Kerning.end(), KerningPair{ first, second, 0.0 }, [](const KerningPair& a, const KerningPair& b)
+			{
+				return a.First != b.First ? a.First < b.First : a.Second < b.Second;
+			});
+
+			if (it == Kerning.end() || it->First != first || it->Second != second)
+				return 0.0;
+
+			return it->Advance;
+		}
+
+		// advance from the first glyph to the second with kerning applied
+		double getAdvance(uint32_t first, uint32_t second) const
+		{
+			const GlyphMetrics* glyph = getGlyph(first);
+			if (!glyph)
+				return 0.0;
+
+			return glyph->Advance + getKerning(first, second);
+		}
 	};
 
 }
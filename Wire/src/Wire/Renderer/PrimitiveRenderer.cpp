@@ -0,0 +1,376 @@
+#include "PrimitiveRenderer.h"
+
+#include "Instance.h"
+#include "Wire/Core/Assert.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace wire {
+
+    namespace Utils {
+
+        // quads are two triangles built from SV_VertexID, lines are a start and an end
+        constexpr static uint32_t s_QuadVertexCount = 6;
+        constexpr static uint32_t s_LineVertexCount = 2;
+
+        constexpr static size_t s_MaxInstanceStride = std::max({ sizeof(RectInstance), sizeof(RoundedRectInstance), sizeof(CircleInstance), sizeof(LineInstance) });
+
+        static std::shared_ptr<GraphicsPipeline> CreateInstancedPipeline(Device* device, const PrimitiveRendererDesc& desc, const std::string& shaderPath, const std::vector<InputElement>& elements, size_t stride, PrimitiveTopology topology, std::string_view debugName)
+        {
+            InputLayout layout{};
+            layout.VertexBufferLayout = elements;
+            layout.Stride = stride;
+            layout.InputRate = VertexInputRate::Instance;
+            layout.PushConstantInfos.push_back(
+                PushConstantInfo{
+                    .Size = sizeof(glm::mat4),
+                    .Offset = 0,
+                    .Shader = ShaderType::Vertex
+                }
+            );
+
+            // the resource layout is reflected from the shader
+            GraphicsPipelineDesc pipelineDesc{};
+            pipelineDesc.Layout = layout;
+            pipelineDesc.ShaderPath = shaderPath;
+            pipelineDesc.Topology = topology;
+            pipelineDesc.RenderPass = desc.RenderPass;
+
+            return device->createGraphicsPipeline(pipelineDesc, debugName);
+        }
+
+    }
+
+    PrimitiveRenderer::PrimitiveRenderer(Device* device, const PrimitiveRendererDesc& desc)
+        : m_Device(device), m_Desc(desc)
+    {
+        m_RectPipeline = Utils::CreateInstancedPipeline(m_Device, m_Desc, m_Desc.RectShaderPath, {
+            { "POSITION", ShaderDataType::Float3, sizeof(glm::vec3), offsetof(RectInstance, Position)     },
+            { "TEXCOORD", ShaderDataType::Float2, sizeof(glm::vec2), offsetof(RectInstance, Size)         },
+            { "COLOR",    ShaderDataType::Float4, sizeof(glm::vec4), offsetof(RectInstance, Color)        },
+            { "TEXCOORD", ShaderDataType::Float4, sizeof(glm::vec4), offsetof(RectInstance, TexCoord)     },
+            { "TEXCOORD", ShaderDataType::Int,    sizeof(int),       offsetof(RectInstance, TextureIndex) }
+        }, sizeof(RectInstance), PrimitiveTopology::TriangleList, "PrimitiveRenderer::m_RectPipeline");
+
+        m_RoundedRectPipeline = Utils::CreateInstancedPipeline(m_Device, m_Desc, m_Desc.RoundedRectShaderPath, {
+            { "POSITION", ShaderDataType::Float3, sizeof(glm::vec3), offsetof(RoundedRectInstance, Position)     },
+            { "TEXCOORD", ShaderDataType::Float2, sizeof(glm::vec2), offsetof(RoundedRectInstance, Size)         },
+            { "COLOR",    ShaderDataType::Float4, sizeof(glm::vec4), offsetof(RoundedRectInstance, Color)        },
+            { "TEXCOORD", ShaderDataType::Float,  sizeof(float),     offsetof(RoundedRectInstance, CornerRadius) },
+            { "TEXCOORD", ShaderDataType::UInt,   sizeof(uint32_t),  offsetof(RoundedRectInstance, CornerFlags)  },
+            { "TEXCOORD", ShaderDataType::Float,  sizeof(float),     offsetof(RoundedRectInstance, Fade)         }
+        }, sizeof(RoundedRectInstance), PrimitiveTopology::TriangleList, "PrimitiveRenderer::m_RoundedRectPipeline");
+
+        m_CirclePipeline = Utils::CreateInstancedPipeline(m_Device, m_Desc, m_Desc.CircleShaderPath, {
+            { "POSITION", ShaderDataType::Float3, sizeof(glm::vec3), offsetof(CircleInstance, Position)  },
+            { "TEXCOORD", ShaderDataType::Float,  sizeof(float),     offsetof(CircleInstance, Radius)    },
+            { "COLOR",    ShaderDataType::Float4, sizeof(glm::vec4), offsetof(CircleInstance, Color)     },
+            { "TEXCOORD", ShaderDataType::Float,  sizeof(float),     offsetof(CircleInstance, Thickness) },
+            { "TEXCOORD", ShaderDataType::Float,  sizeof(float),     offsetof(CircleInstance, Fade)      }
+        }, sizeof(CircleInstance), PrimitiveTopology::TriangleList, "PrimitiveRenderer::m_CirclePipeline");
+
+        m_LinePipeline = Utils::CreateInstancedPipeline(m_Device, m_Desc, m_Desc.LineShaderPath, {
+            { "POSITION", ShaderDataType::Float3, sizeof(glm::vec3), offsetof(LineInstance, Start) },
+            { "TEXCOORD", ShaderDataType::Float3, sizeof(glm::vec3), offsetof(LineInstance, End)   },
+            { "COLOR",    ShaderDataType::Float4, sizeof(glm::vec4), offsetof(LineInstance, Color) }
+        }, sizeof(LineInstance), PrimitiveTopology::LineList, "PrimitiveRenderer::m_LinePipeline");
+
+        SamplerDesc samplerDesc{};
+        samplerDesc.MinFilter = SamplerFilter::Linear;
+        samplerDesc.MagFilter = SamplerFilter::Linear;
+        samplerDesc.AddressModeU = AddressMode::ClampToEdge;
+        samplerDesc.AddressModeV = AddressMode::ClampToEdge;
+        samplerDesc.AddressModeW = AddressMode::ClampToEdge;
+        samplerDesc.EnableAnisotropy = false;
+        samplerDesc.MaxAnisotropy = 1.0f;
+        samplerDesc.BorderColor = BorderColor::FloatTransparentBlack;
+        samplerDesc.MipmapMode = MipmapMode::Linear;
+
+        m_Sampler = m_Device->createSampler(samplerDesc, "PrimitiveRenderer::m_Sampler");
+
+        // untextured rects sample this, so every rect goes through the same pipeline
+        uint32_t white = 0xFFFFFFFF;
+        m_WhiteTexture = m_Device->createTexture2D(&white, 1, 1, "PrimitiveRenderer::m_WhiteTexture");
+
+        // vertex buffers are host visible and coherent, so the mapping stays open
+        m_InstanceBuffer = m_Device->createBuffer(VertexBuffer, m_Desc.RingBufferSize, nullptr, "PrimitiveRenderer::m_InstanceBuffer");
+        m_Instances = reinterpret_cast<uint8_t*>(m_InstanceBuffer->map(m_Desc.RingBufferSize));
+
+        uint32_t framesInFlight = m_Device->getInstance().getNumFramesInFlight();
+        m_RingRegions.resize(framesInFlight);
+        m_FrameResources.resize(framesInFlight);
+    }
+
+    PrimitiveRenderer::~PrimitiveRenderer()
+    {
+        m_InstanceBuffer->unmap();
+
+        for (const auto& frame : m_FrameResources)
+        {
+            for (const auto& resource : frame.Resources)
+                m_Device->drop(resource);
+        }
+
+        m_Device->drop(m_InstanceBuffer);
+        m_Device->drop(m_WhiteTexture);
+        m_Device->drop(m_Sampler);
+        m_Device->drop(m_LinePipeline);
+        m_Device->drop(m_CirclePipeline);
+        m_Device->drop(m_RoundedRectPipeline);
+        m_Device->drop(m_RectPipeline);
+    }
+
+    void PrimitiveRenderer::begin(const glm::mat4& viewProjection)
+    {
+        m_ViewProjection = viewProjection;
+        m_Frame++;
+
+        m_Rects.clear();
+        m_RoundedRects.clear();
+        m_Circles.clear();
+        m_Lines.clear();
+
+        m_Textures.clear();
+        m_TextureIndices.clear();
+    }
+
+    void PrimitiveRenderer::drawRect(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color)
+    {
+        drawRect(position, size, m_WhiteTexture, color);
+    }
+
+    void PrimitiveRenderer::drawRect(const glm::vec3& position, const glm::vec2& size, const std::shared_ptr<Texture2D>& texture, const glm::vec4& color, const glm::vec4& texCoord)
+    {
+        uint32_t textureIndex = getTextureIndex(texture ? texture : m_WhiteTexture);
+
+        // TextureIndex is the slot within the batch, end fills it in once the batches are known
+        m_Rects.push_back(QueuedRect{ textureIndex, RectInstance{ position, size, color, texCoord, 0 } });
+    }
+
+    void PrimitiveRenderer::drawRoundedRect(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color, float cornerRadius, uint32_t corners, float fade)
+    {
+        m_RoundedRects.push_back(RoundedRectInstance{ position, size, color, cornerRadius, corners, fade });
+    }
+
+    void PrimitiveRenderer::drawCircle(const glm::vec3& position, float radius, const glm::vec4& color, float thickness, float fade)
+    {
+        m_Circles.push_back(CircleInstance{ position, radius, color, thickness, fade });
+    }
+
+    void PrimitiveRenderer::drawLine(const glm::vec3& start, const glm::vec3& end, const glm::vec4& color)
+    {
+        m_Lines.push_back(LineInstance{ start, end, color });
+    }
+
+    void PrimitiveRenderer::end(CommandList& commandList)
+    {
+        m_BatchCount = 0;
+        m_InstanceCount = 0;
+
+        uint32_t frameIndex = m_Device->getFrameIndex();
+
+        size_t queuedCount = m_Rects.size() + m_RoundedRects.size() + m_Circles.size() + m_Lines.size();
+        if (queuedCount == 0)
+        {
+            m_RingRegions[frameIndex] = RingRegion{};
+            return;
+        }
+
+        // stable, rects that share a texture keep the order they were drawn in
+        std::stable_sort(m_Rects.begin(), m_Rects.end(), [](const QueuedRect& lhs, const QueuedRect& rhs)
+        {
+            return lhs.Texture < rhs.Texture;
+        });
+
+        // each of the four sections can need up to a stride of padding to start on a multiple of it
+        size_t size = m_Rects.size() * sizeof(RectInstance)
+            + m_RoundedRects.size() * sizeof(RoundedRectInstance)
+            + m_Circles.size() * sizeof(CircleInstance)
+            + m_Lines.size() * sizeof(LineInstance)
+            + 4 * Utils::s_MaxInstanceStride;
+
+        size_t offset = 0;
+        size_t available = allocateRing(frameIndex, size, offset);
+        size_t cursor = offset;
+        size_t end = offset + available;
+
+        uint32_t firstInstance = 0;
+        uint32_t count = 0;
+
+        commandList.bindVertexBuffers({ m_InstanceBuffer });
+
+        if (!m_Rects.empty())
+        {
+            commandList.bindPipeline(m_RectPipeline);
+            commandList.pushConstants(ShaderType::Vertex, m_ViewProjection);
+
+            // every batch covers s_MaxTextures textures, and the sort made their rects contiguous
+            size_t rect = 0;
+            for (uint32_t batch = 0; rect < m_Rects.size(); batch++)
+            {
+                size_t firstTexture = static_cast<size_t>(batch) * s_MaxTextures;
+                size_t textureCount = std::min<size_t>(s_MaxTextures, m_Textures.size() - firstTexture);
+
+                size_t batchEnd = rect;
+                while (batchEnd < m_Rects.size() && m_Rects[batchEnd].Texture < firstTexture + textureCount)
+                    batchEnd++;
+
+                count = reserveInstances(sizeof(RectInstance), batchEnd - rect, cursor, end, firstInstance);
+
+                RectInstance* instances = reinterpret_cast<RectInstance*>(m_Instances) + firstInstance;
+                for (uint32_t i = 0; i < count; i++)
+                {
+                    const QueuedRect& queued = m_Rects[rect + i];
+
+                    instances[i] = queued.Instance;
+                    instances[i].TextureIndex = static_cast<int>(queued.Texture - firstTexture);
+                }
+
+                if (count != 0)
+                {
+                    commandList.bindShaderResource(0, getBatchResource(frameIndex, batch, firstTexture, textureCount));
+                    commandList.draw(Utils::s_QuadVertexCount, 0, count, firstInstance);
+
+                    m_BatchCount++;
+                    m_InstanceCount += count;
+                }
+
+                rect = batchEnd;
+            }
+        }
+
+        auto drawSection = [&](const std::shared_ptr<GraphicsPipeline>& pipeline, const void* instances, size_t stride, size_t instanceCount, uint32_t vertexCount)
+        {
+            if (instanceCount == 0)
+                return;
+
+            count = reserveInstances(stride, instanceCount, cursor, end, firstInstance);
+            if (count == 0)
+                return;
+
+            std::memcpy(m_Instances + static_cast<size_t>(firstInstance) * stride, instances, static_cast<size_t>(count) * stride);
+
+            commandList.bindPipeline(pipeline);
+            commandList.pushConstants(ShaderType::Vertex, m_ViewProjection);
+            if (pipeline == m_LinePipeline)
+                commandList.setLineWidth(m_Desc.LineWidth);
+
+            commandList.draw(vertexCount, 0, count, firstInstance);
+
+            m_BatchCount++;
+            m_InstanceCount += count;
+        };
+
+        drawSection(m_RoundedRectPipeline, m_RoundedRects.data(), sizeof(RoundedRectInstance), m_RoundedRects.size(), Utils::s_QuadVertexCount);
+        drawSection(m_CirclePipeline, m_Circles.data(), sizeof(CircleInstance), m_Circles.size(), Utils::s_QuadVertexCount);
+        drawSection(m_LinePipeline, m_Lines.data(), sizeof(LineInstance), m_Lines.size(), Utils::s_LineVertexCount);
+
+        // the region stays reserved until this frame index comes around again
+        if (cursor != offset)
+        {
+            m_RingRegions[frameIndex] = RingRegion{ offset, cursor - offset, m_Frame };
+            m_RingHead = cursor;
+        }
+
+        if (m_InstanceCount != queuedCount)
+            WR_WARN("PrimitiveRenderer ran out of ring buffer space this frame ({} bytes), {} primitives were dropped", m_Desc.RingBufferSize, queuedCount - m_InstanceCount);
+    }
+
+    uint32_t PrimitiveRenderer::getTextureIndex(const std::shared_ptr<Texture2D>& texture)
+    {
+        auto [it, inserted] = m_TextureIndices.try_emplace(texture.get(), static_cast<uint32_t>(m_Textures.size()));
+        if (inserted)
+            m_Textures.push_back(texture);
+
+        return it->second;
+    }
+
+    size_t PrimitiveRenderer::allocateRing(uint32_t frameIndex, size_t size, size_t& outOffset)
+    {
+        // this frame's previous submission has finished, so its region is free again
+        m_RingRegions[frameIndex] = RingRegion{};
+
+        // frames finish in order, everything from the oldest region still in flight up to the head is live
+        const RingRegion* oldest = nullptr;
+        for (const RingRegion& region : m_RingRegions)
+        {
+            if (region.Size != 0 && (!oldest || region.Frame < oldest->Frame))
+                oldest = &region;
+        }
+
+        size_t capacity = m_Desc.RingBufferSize;
+
+        if (!oldest)
+        {
+            m_RingHead = 0;
+            outOffset = 0;
+            return capacity;
+        }
+
+        size_t tail = oldest->Offset;
+
+        // the live data has wrapped, the free space is the gap between the head and the oldest region
+        if (m_RingHead <= tail)
+        {
+            outOffset = m_RingHead;
+            return tail - m_RingHead;
+        }
+
+        // otherwise it is after the head and before the tail, wrap when the end is too small and the start is bigger
+        if (capacity - m_RingHead >= size || capacity - m_RingHead >= tail)
+        {
+            outOffset = m_RingHead;
+            return capacity - m_RingHead;
+        }
+
+        outOffset = 0;
+        return tail;
+    }
+
+    uint32_t PrimitiveRenderer::reserveInstances(size_t stride, size_t count, size_t& cursor, size_t end, uint32_t& outFirstInstance)
+    {
+        size_t first = (cursor + stride - 1) / stride;
+        if (first * stride >= end)
+            return 0;
+
+        size_t fitting = std::min(count, (end - first * stride) / stride);
+
+        outFirstInstance = static_cast<uint32_t>(first);
+        cursor = (first + fitting) * stride;
+
+        return static_cast<uint32_t>(fitting);
+    }
+
+    std::shared_ptr<ShaderResource> PrimitiveRenderer::getBatchResource(uint32_t frameIndex, uint32_t batch, size_t firstTexture, size_t textureCount)
+    {
+        FrameResources& frame = m_FrameResources[frameIndex];
+
+        if (frame.Resources.size() <= batch)
+        {
+            std::shared_ptr<ShaderResource> resource = m_Device->createShaderResource(0, m_RectPipeline->getResourceLayout(), "PrimitiveRenderer batch resource");
+            resource->update(m_Sampler, 1, 0);
+
+            frame.Resources.push_back(resource);
+            frame.BoundTextures.emplace_back();
+        }
+
+        // this frame's previous submission has finished, so its descriptors can be rewritten.
+        // every element of the array has to be valid, the unused slots repeat the first texture
+        const std::shared_ptr<ShaderResource>& resource = frame.Resources[batch];
+        auto& boundTextures = frame.BoundTextures[batch];
+
+        for (uint32_t slot = 0; slot < s_MaxTextures; slot++)
+        {
+            const std::shared_ptr<Texture2D>& texture = m_Textures[firstTexture + (slot < textureCount ? slot : 0)];
+            if (boundTextures[slot] == texture)
+                continue;
+
+            resource->update(texture, 0, slot);
+            boundTextures[slot] = texture;
+        }
+
+        return resource;
+    }
+
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+#include "Device.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <unordered_map>
+
+namespace wire {
+
+    // the per instance inputs of the UI shaders, positions are the center of the primitive
+    struct RectInstance
+    {
+        glm::vec3 Position;
+        glm::vec2 Size;
+        glm::vec4 Color;
+        glm::vec4 TexCoord; // left, bottom, right, top
+        int TextureIndex;
+    };
+
+    struct RoundedRectInstance
+    {
+        glm::vec3 Position;
+        glm::vec2 Size;
+        glm::vec4 Color;
+        float CornerRadius;
+        uint32_t CornerFlags;
+        float Fade;
+    };
+
+    struct CircleInstance
+    {
+        glm::vec3 Position;
+        float Radius;
+        glm::vec4 Color;
+        float Thickness; // 1 is a filled circle
+        float Fade;
+    };
+
+    struct LineInstance
+    {
+        glm::vec3 Start;
+        glm::vec3 End;
+        glm::vec4 Color;
+    };
+
+    struct PrimitiveRendererDesc
+    {
+        std::shared_ptr<RenderPass> RenderPass;
+        std::string RectShaderPath = "shadercache://UIRect.hlsl";
+        std::string RoundedRectShaderPath = "shadercache://UIRoundedRect.hlsl";
+        std::string CircleShaderPath = "shadercache://UICircle.hlsl";
+        std::string LineShaderPath = "shadercache://UILine.hlsl";
+
+        // instance data of every frame in flight, a busy frame can take most of it while the others are light
+        size_t RingBufferSize = 4 * 1024 * 1024;
+        float LineWidth = 1.0f; // anything but 1 needs the wideLines feature
+    };
+
+    // batches rects, rounded rects, circles and lines for the UI shaders as instances in a persistently mapped ring buffer.
+    // primitives are grouped by type and then texture, one instanced draw per batch, so only primitives of the same type keep
+    // their submission order. the types are drawn as rects, rounded rects, circles then lines, layer across them with depth
+    class PrimitiveRenderer
+    {
+    public:
+        constexpr static uint32_t s_MaxTextures = 32; // size of r_Textures in UIRect.hlsl
+
+        enum Corner : uint32_t
+        {
+            TopLeft     = 1 << 0,
+            TopRight    = 1 << 1,
+            BottomLeft  = 1 << 2,
+            BottomRight = 1 << 3,
+            AllCorners  = TopLeft | TopRight | BottomLeft | BottomRight
+        };
+
+        PrimitiveRenderer(Device* device, const PrimitiveRendererDesc& desc);
+        ~PrimitiveRenderer();
+
+        PrimitiveRenderer(const PrimitiveRenderer&) = delete;
+        PrimitiveRenderer& operator=(const PrimitiveRenderer&) = delete;
+
+        // once per frame, the ring space of a frame is reclaimed when its frame index comes around again
+        void begin(const glm::mat4& viewProjection);
+
+        void drawRect(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color);
+        // texCoord is left, bottom, right, top
+        void drawRect(const glm::vec3& position, const glm::vec2& size, const std::shared_ptr<Texture2D>& texture, const glm::vec4& color = glm::vec4(1.0f), const glm::vec4& texCoord = glm::vec4(0.0f, 1.0f, 1.0f, 0.0f));
+        // fade is the width of the anti aliased edge in the units of size
+        void drawRoundedRect(const glm::vec3& position, const glm::vec2& size, const glm::vec4& color, float cornerRadius, uint32_t corners = AllCorners, float fade = 1.0f);
+        // thickness and fade are fractions of the radius
+        void drawCircle(const glm::vec3& position, float radius, const glm::vec4& color, float thickness = 1.0f, float fade = 0.005f);
+        void drawLine(const glm::vec3& start, const glm::vec3& end, const glm::vec4& color);
+
+        // records the draws into a command list inside a render pass compatible with the desc
+        void end(CommandList& commandList);
+
+        uint32_t getBatchCount() const { return m_BatchCount; }
+        uint32_t getInstanceCount() const { return m_InstanceCount; }
+    private:
+        struct QueuedRect
+        {
+            uint32_t Texture; // index into m_Textures
+            RectInstance Instance;
+        };
+
+        // the part of the ring a frame in flight is still reading
+        struct RingRegion
+        {
+            size_t Offset = 0;
+            size_t Size = 0;
+            uint64_t Frame = 0;
+        };
+
+        struct FrameResources
+        {
+            std::vector<std::shared_ptr<ShaderResource>> Resources; // one per batch of textures
+            std::vector<std::array<std::shared_ptr<Texture2D>, s_MaxTextures>> BoundTextures;
+        };
+
+        uint32_t getTextureIndex(const std::shared_ptr<Texture2D>& texture);
+        size_t allocateRing(uint32_t frameIndex, size_t size, size_t& outOffset);
+        // aligns cursor to stride and claims as many of count instances as fit before end, outFirstInstance is the first one's index
+        uint32_t reserveInstances(size_t stride, size_t count, size_t& cursor, size_t end, uint32_t& outFirstInstance);
+        std::shared_ptr<ShaderResource> getBatchResource(uint32_t frameIndex, uint32_t batch, size_t firstTexture, size_t textureCount);
+    private:
+        Device* m_Device = nullptr;
+        PrimitiveRendererDesc m_Desc;
+
+        std::shared_ptr<GraphicsPipeline> m_RectPipeline;
+        std::shared_ptr<GraphicsPipeline> m_RoundedRectPipeline;
+        std::shared_ptr<GraphicsPipeline> m_CirclePipeline;
+        std::shared_ptr<GraphicsPipeline> m_LinePipeline;
+        std::shared_ptr<Sampler> m_Sampler;
+        std::shared_ptr<Texture2D> m_WhiteTexture;
+
+        // mapped for the lifetime of the renderer, every batch starts on a multiple of its stride so it is reached with firstInstance
+        std::shared_ptr<Buffer> m_InstanceBuffer;
+        uint8_t* m_Instances = nullptr;
+        size_t m_RingHead = 0;
+        std::vector<RingRegion> m_RingRegions; // one per frame in flight
+
+        std::vector<FrameResources> m_FrameResources;
+
+        std::vector<QueuedRect> m_Rects;
+        std::vector<RoundedRectInstance> m_RoundedRects;
+        std::vector<CircleInstance> m_Circles;
+        std::vector<LineInstance> m_Lines;
+
+        // in order of first use this frame, so textures keep their batch and slot while the scene does not change
+        std::vector<std::shared_ptr<Texture2D>> m_Textures;
+        std::unordered_map<const Texture2D*, uint32_t> m_TextureIndices;
+
+        glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+        uint64_t m_Frame = 0;
+        uint32_t m_BatchCount = 0;
+        uint32_t m_InstanceCount = 0;
+    };
+
+}
@@ -4,15 +4,19 @@
 #include "ShaderCompiler.h"
 #include "Wire/Core/Assert.h"
 #include "Wire/Serialization/Stream.h"
+#include "Wire/Serialization/MappedFile.h"
 #include "Wire/Serialization/SHA-256.h"
 
 #include <string>
 #include <vector>
+#include <cstring>
 #include <fstream>
+#include <istream>
 #include <sstream>
 #include <algorithm>
 #include <filesystem>
 #include <unordered_map>
+#include <unordered_set>
 
 namespace wire {
 
@@ -26,32 +30,237 @@ namespace wire {
         // ID data
         const char AppID[4] = { 'W', 'I', 'R', 'E' };    // WIRE
         const char TypeID[4] = { 'S', 'C', 'C', 'H' };   // SCCH  (shader cache)
-        const uint32_t Version = HEADER_VER(1, 0, 3, 0); // 1.0.3.0
+        const uint32_t Version = HEADER_VER(1, 7, 0, 0); // 1.7.0.0
 
         // cache data
         size_t GroupCount;
+        uint64_t TableOffset = 0; // one entry per group: record range, name, config and variant key
+
+        size_t BlobCount;
+        uint64_t BlobTableOffset = 0; // one entry per unique bytecode: range and SHA-256
     };
 
-    ShaderCache::ShaderCache(const std::vector<ShaderGroup>& groups)
-        : m_Version(ShaderCacheHeader{}.Version), m_Groups(groups)
+    // file layout: header, blobs (4 byte aligned), group records, table of contents, blob table
+
+    constexpr uint32_t NoBlob = static_cast<uint32_t>(-1);
+
+    using BlobMap = std::unordered_map<std::string, std::shared_ptr<const ShaderBlob>>;
+
+    namespace Utils {
+
+        static std::string GetBlobKey(const ShaderBlob& blob)
+        {
+            return std::string(reinterpret_cast<const char*>(blob.SHA256.data()), sizeof(uint32_t) * 8);
+        }
+
+        // objects with equal bytecode end up sharing one blob
+        static void InternBlobs(std::vector<ShaderObject>& objects, BlobMap& blobs)
+        {
+            for (auto& object : objects)
+            {
+                if (!object.Blob)
+                    continue;
+
+                auto [it, inserted] = blobs.try_emplace(GetBlobKey(*object.Blob), object.Blob);
+                object.Blob = it->second;
+            }
+        }
+
+    }
+
+    std::shared_ptr<const ShaderBlob> ShaderBlob::create(std::vector<uint8_t>&& bytecode)
     {
+        auto blob = std::make_shared<ShaderBlob>();
+        blob->SHA256 = generateSHA256(bytecode);
+        blob->Storage = std::move(bytecode);
+        blob->Data = blob->Storage;
+
+        return blob;
     }
 
-    static void WriteGroup(StreamWriter& stream, const ShaderGroup& group);
-    static void WriteObject(StreamWriter& stream, const ShaderObject& object);
-    static void ReadGroup(StreamReader& stream, ShaderGroup& group);
-    static void ReadObject(StreamReader& stream, ShaderObject& object);
+    ShaderCache::ShaderCache()
+        : m_Configuration(ShaderCompiler::getConfiguration({}))
+    {
+    }
 
-    void ShaderCache::outputToFile(const std::filesystem::path& path)
+    ShaderCache::ShaderCache(const std::vector<ShaderGroup>& groups, std::optional<ShaderConfiguration> configuration)
+        : m_Version(ShaderCacheHeader{}.Version), m_Configuration(configuration.value_or(ShaderCompiler::getConfiguration({}))), m_Groups(groups), m_Slots(m_Groups.size())
+    {
+        BlobMap blobs;
+        for (auto& group : m_Groups)
+            Utils::InternBlobs(group.Objects, blobs);
+
+        rebuildIndex();
+    }
+
+    ShaderCache::ShaderCache(std::vector<ShaderGroup>&& groups, std::optional<ShaderConfiguration> configuration)
+        : m_Version(ShaderCacheHeader{}.Version), m_Configuration(configuration.value_or(ShaderCompiler::getConfiguration({}))), m_Groups(std::move(groups)), m_Slots(m_Groups.size())
     {
-        /*for (const auto& group : m_Groups)
+        BlobMap blobs;
+        for (auto& group : m_Groups)
+            Utils::InternBlobs(group.Objects, blobs);
+
+        rebuildIndex();
+    }
+
+    ShaderCache::ShaderCache(ShaderCache&& other) noexcept = default;
+    ShaderCache::~ShaderCache() = default;
+
+    ShaderCache& ShaderCache::operator=(ShaderCache&& other) noexcept = default;
+
+    namespace Utils {
+
+        static std::string GetGroupKey(const std::string& sourcePath, ShaderConfiguration config, uint32_t variantKey)
         {
-            if (group.Objects.size() != m_Groups[0].Objects.size())
+            return sourcePath + (config == ShaderConfiguration::Debug ? "|debug|" : "|release|") + std::to_string(variantKey);
+        }
+
+        static bool VariantsMatch(const ShaderGroup& group, const ShaderInfo& info)
+        {
+            auto axisEqual = [](const ShaderVariantAxis& lhs, const ShaderVariantAxis& rhs)
+            {
+                return lhs.Macro == rhs.Macro && lhs.Values == rhs.Values;
+            };
+
+            auto defineEqual = [](const ShaderMacro& lhs, const ShaderMacro& rhs)
+            {
+                return lhs.Name == rhs.Name && lhs.Value == rhs.Value;
+            };
+
+            std::vector<ShaderMacro> defines = ShaderCompiler::getVariantDefines(info.VariantAxes, group.VariantKey);
+
+            return std::equal(group.VariantAxes.begin(), group.VariantAxes.end(), info.VariantAxes.begin(), info.VariantAxes.end(), axisEqual)
+                && std::equal(group.Defines.begin(), group.Defines.end(), defines.begin(), defines.end(), defineEqual);
+        }
+
+        static const ShaderObject* FindObject(const ShaderGroup& group, ShaderType type)
+        {
+            for (const auto& object : group.Objects)
             {
-                WR_ASSERT(false, "Each group in a shader cache must have the same number of objects");
-                return;
+                if (object.API == RendererAPI::Vulkan && object.Type == type)
+                    return &object;
             }
-        }*/
+
+            return nullptr;
+        }
+
+        static bool EntryPointsMatch(const ShaderGroup& group, const ShaderInfo& info)
+        {
+            if (info.IsGraphics)
+            {
+                const ShaderObject* vertex = FindObject(group, ShaderType::Vertex);
+                const ShaderObject* pixel = FindObject(group, ShaderType::Pixel);
+
+                return vertex && pixel && vertex->EntryPoint == info.VertexOrComputeEntryPoint && pixel->EntryPoint == info.PixelEntryPoint;
+            }
+
+            const ShaderObject* compute = FindObject(group, ShaderType::Compute);
+            return compute && compute->EntryPoint == info.VertexOrComputeEntryPoint;
+        }
+
+        static void SetObjectIndices(const ShaderGroup& group, std::array<std::array<int32_t, ShaderTypeCount>, RendererAPICount>& objectIndices)
+        {
+            for (auto& indices : objectIndices)
+                indices.fill(-1);
+
+            for (int32_t i = 0; i < static_cast<int32_t>(group.Objects.size()); i++)
+            {
+                const ShaderObject& object = group.Objects[i];
+                objectIndices[static_cast<size_t>(object.API)][static_cast<size_t>(object.Type)] = i;
+            }
+        }
+
+        static void AlignStream(std::ostream& stream, size_t alignment)
+        {
+            constexpr char padding[8] = {};
+
+            size_t position = static_cast<size_t>(stream.tellp());
+            size_t aligned = (position + alignment - 1) / alignment * alignment;
+            stream.write(padding, aligned - position);
+        }
+
+        static bool IsGroupUpToDate(ShaderGroup& group, const ShaderInfo& info, uint64_t optionsHash, bool& outStatChanged)
+        {
+            outStatChanged = false;
+
+            if (group.OptionsHash != optionsHash || group.Name != info.Path.filename().string() || !EntryPointsMatch(group, info) || !VariantsMatch(group, info))
+                return false;
+
+            // a failed compile is kept so wire-shaderc can report it, but an include it could not resolve is not a
+            // recorded dependency, so nothing else would notice when the fix lands
+            if (std::any_of(group.Objects.begin(), group.Objects.end(), [](const ShaderObject& object) { return object.getBytecode().empty(); }))
+                return false;
+
+            ShaderSourceStat stat;
+            if (!ShaderCompiler::getSourceStat(info.Path, stat))
+                return false;
+
+            if (stat.WriteTime != group.SourceWriteTime || stat.Size != group.SourceSize)
+            {
+                // touched but possibly unchanged, fall back to the content hash
+                std::array<uint32_t, 8> shaderHash;
+                if (!ShaderCompiler::getSourceHash(info.Path, shaderHash) || std::memcmp(group.SHA256, shaderHash.data(), sizeof(uint32_t) * 8) != 0)
+                    return false;
+
+                group.SourceWriteTime = stat.WriteTime;
+                group.SourceSize = stat.Size;
+                outStatChanged = true;
+            }
+
+            std::vector<ShaderDependency> dependencies = group.Dependencies;
+            bool dependencyStatChanged = false;
+
+            for (auto& dependency : dependencies)
+            {
+                ShaderSourceStat dependencyStat;
+                if (!ShaderCompiler::getSourceStat(dependency.Path, dependencyStat))
+                    return false;
+
+                if (dependencyStat.WriteTime == dependency.WriteTime && dependencyStat.Size == dependency.Size)
+                    continue;
+
+                std::array<uint32_t, 8> dependencyHash;
+                if (!ShaderCompiler::getSourceHash(dependency.Path, dependencyHash))
+                    return false;
+
+                std::memcpy(dependency.SHA256, dependencyHash.data(), sizeof(uint32_t) * 8);
+                dependency.WriteTime = dependencyStat.WriteTime;
+                dependency.Size = dependencyStat.Size;
+                dependencyStatChanged = true;
+            }
+
+            if (dependencyStatChanged)
+            {
+                std::array<uint32_t, 8> combinedHash = ShaderCompiler::combineDependencyHashes(group.SHA256, dependencies);
+                if (std::memcmp(group.DependencyHash, combinedHash.data(), sizeof(uint32_t) * 8) != 0)
+                    return false;
+
+                group.Dependencies = std::move(dependencies);
+                outStatChanged = true;
+            }
+
+            return true;
+        }
+
+    }
+
+    static void WriteGroup(StreamWriter& stream, const ShaderGroup& group, const std::unordered_map<const ShaderBlob*, uint32_t>& blobIndices);
+    static void WriteDependency(StreamWriter& stream, const ShaderDependency& dependency);
+    static void WriteVariantAxis(StreamWriter& stream, const ShaderVariantAxis& axis);
+    static void WriteMacro(StreamWriter& stream, const ShaderMacro& macro);
+    static void WriteObject(StreamWriter& stream, const ShaderObject& object, uint32_t blobIndex);
+    static void WriteReflection(StreamWriter& stream, const ShaderReflection& reflection);
+    static void ReadGroup(StreamReader& stream, ShaderGroup& group, const std::vector<std::shared_ptr<const ShaderBlob>>& blobs);
+    static void ReadDependency(StreamReader& stream, ShaderDependency& dependency);
+    static void ReadVariantAxis(StreamReader& stream, ShaderVariantAxis& axis);
+    static void ReadMacro(StreamReader& stream, ShaderMacro& macro);
+    static bool ReadObject(StreamReader& stream, ShaderObject& object, const std::vector<std::shared_ptr<const ShaderBlob>>& blobs);
+    static void ReadReflection(StreamReader& stream, ShaderReflection& reflection);
+
+    void ShaderCache::outputToFile(const std::filesystem::path& path)
+    {
+        // the path may be the file that is mapped, which can't be overwritten while it is
+        releaseFile();
 
         ShaderCacheHeader header{};
         header.GroupCount = m_Groups.size();
@@ -66,329 +275,728 @@ namespace wire {
 
         stream.writeRaw(header);
 
-        /*for (const auto& group : m_Groups)
+        // each unique bytecode is written once, objects refer to it by index
+        std::unordered_map<std::string, uint32_t> blobKeys;
+        std::unordered_map<const ShaderBlob*, uint32_t> blobIndices;
+        std::vector<const ShaderBlob*> blobs;
+
+        for (const auto& group : m_Groups)
+        {
+            for (const auto& object : group.Objects)
+            {
+                if (!object.Blob || blobIndices.contains(object.Blob.get()))
+                    continue;
+
+                auto [it, inserted] = blobKeys.try_emplace(Utils::GetBlobKey(*object.Blob), static_cast<uint32_t>(blobs.size()));
+                if (inserted)
+                    blobs.push_back(object.Blob.get());
+
+                blobIndices[object.Blob.get()] = it->second;
+            }
+        }
+
+        // aligned so the bytecode can be handed to vkCreateShaderModule straight from the mapping
+        std::vector<std::pair<uint64_t, uint64_t>> blobRanges;
+        for (const ShaderBlob* blob : blobs)
+        {
+            Utils::AlignStream(file, sizeof(uint32_t));
+            blobRanges.emplace_back(static_cast<uint64_t>(file.tellp()), static_cast<uint64_t>(blob->Data.size()));
+
+            file.write(reinterpret_cast<const char*>(blob->Data.data()), blob->Data.size());
+        }
+
+        std::vector<GroupSlot> slots(m_Groups.size());
+        for (size_t i = 0; i < m_Groups.size(); i++)
+        {
+            slots[i].Offset = static_cast<uint64_t>(file.tellp());
+            WriteGroup(stream, m_Groups[i], blobIndices);
+            slots[i].Size = static_cast<uint64_t>(file.tellp()) - slots[i].Offset;
+        }
+
+        header.TableOffset = static_cast<uint64_t>(file.tellp());
+        for (size_t i = 0; i < m_Groups.size(); i++)
+        {
+            const ShaderGroup& group = m_Groups[i];
+
+            stream.writeRaw(slots[i].Offset);
+            stream.writeRaw(slots[i].Size);
+            stream.writeRaw((uint32_t)group.Config);
+            stream.writeRaw(group.VariantKey);
+            stream.writeString(group.Name);
+            stream.writeString(group.SourcePath);
+        }
+
+        header.BlobCount = blobs.size();
+        header.BlobTableOffset = static_cast<uint64_t>(file.tellp());
+        for (size_t i = 0; i < blobs.size(); i++)
         {
-            stream.writeRaw<size_t>(group.Objects.size());
-        }*/
+            stream.writeRaw(blobRanges[i].first);
+            stream.writeRaw(blobRanges[i].second);
+            stream.writeRaw(blobs[i]->SHA256);
+        }
 
-        stream.writeArray<ShaderGroup>(m_Groups, WriteGroup, false);
+        file.seekp(0);
+        stream.writeRaw(header);
 
         file.close();
     }
 
-    ShaderResult ShaderCache::getShaderFromURL(const std::filesystem::path& path, RendererAPI api, bool isGraphics)
+    ShaderResult ShaderCache::getShaderFromURL(std::string_view url, RendererAPI api, bool isGraphics, uint32_t variant) const
     {
-        std::string pathStr = path.string();
-        WR_ASSERT(pathStr.contains("shadercache://"), "Invalid shadercache path! (must begin with shadercache://)");
+        constexpr std::string_view prefix = "shadercache://";
+        WR_ASSERT(url.starts_with(prefix), "Invalid shadercache path! (must begin with shadercache://)");
 
-        std::string name = pathStr.substr(14);
+        ShaderResult result{};
+        result.IsGraphics = isGraphics;
 
-        ShaderResult result;
+        // held for the whole lookup, groups can be replaced while the app runs (see replaceGroups)
+        std::lock_guard lock(*m_Mutex);
 
-        for (const auto& group : m_Groups)
+        auto it = m_Index.find(url.substr(prefix.size()));
+        if (it == m_Index.end())
         {
-            if (group.Name == name)
+            WR_ASSERT(false, "Shader {} not found in shader cache", url);
+            return result;
+        }
+
+        if (variant >= it->second.size() || it->second[variant].GroupIndex < 0)
+        {
+            WR_ASSERT(false, "Variant {} of shader {} was not compiled into the shader cache", variant, url);
+            return result;
+        }
+
+        size_t groupIndex = static_cast<size_t>(it->second[variant].GroupIndex);
+        loadGroup(groupIndex);
+
+        const ShaderGroup& group = m_Groups[groupIndex];
+        const auto& objectIndices = m_Slots[groupIndex].ObjectIndices[static_cast<size_t>(api)];
+
+        auto makeView = [&group, &objectIndices](ShaderType type) -> ShaderObjectView
+        {
+            int32_t index = objectIndices[static_cast<size_t>(type)];
+            if (index < 0)
+                return ShaderObjectView{ .Type = type };
+
+            const ShaderObject& object = group.Objects[index];
+            return ShaderObjectView{
+                .API = object.API,
+                .Type = object.Type,
+                .EntryPoint = object.EntryPoint,
+                .Bytecode = object.getBytecode(),
+                .Reflection = &object.Reflection,
+                .SHA256 = object.Blob ? &object.Blob->SHA256 : nullptr
+            };
+        };
+
+        if (isGraphics)
+        {
+            result.VertexOrCompute = makeView(ShaderType::Vertex);
+            result.Pixel = makeView(ShaderType::Pixel);
+        }
+        else
+        {
+            result.VertexOrCompute = makeView(ShaderType::Compute);
+        }
+
+        return result;
+    }
+
+    bool ShaderCache::hasShader(std::string_view url) const
+    {
+        constexpr std::string_view prefix = "shadercache://";
+        if (!url.starts_with(prefix))
+            return false;
+
+        std::lock_guard lock(*m_Mutex);
+        return m_Index.find(url.substr(prefix.size())) != m_Index.end();
+    }
+
+    uint32_t ShaderCache::getVariantKey(std::string_view url, const std::vector<ShaderMacro>& values) const
+    {
+        constexpr std::string_view prefix = "shadercache://";
+        WR_ASSERT(url.starts_with(prefix), "Invalid shadercache path! (must begin with shadercache://)");
+
+        std::lock_guard lock(*m_Mutex);
+
+        auto it = m_Index.find(url.substr(prefix.size()));
+        if (it == m_Index.end())
+        {
+            WR_ASSERT(false, "Shader {} not found in shader cache", url);
+            return 0;
+        }
+
+        // every variant of a shader stores the same axes
+        auto entry = std::find_if(it->second.begin(), it->second.end(), [](const IndexEntry& entry) { return entry.GroupIndex >= 0; });
+        size_t groupIndex = static_cast<size_t>(entry->GroupIndex);
+        loadGroup(groupIndex);
+
+        const std::vector<ShaderVariantAxis>& axes = m_Groups[groupIndex].VariantAxes;
+
+        uint32_t key = 0;
+        uint32_t stride = 1;
+
+        for (const auto& axis : axes)
+        {
+            uint32_t radix = axis.Values.empty() ? 2 : static_cast<uint32_t>(axis.Values.size());
+            uint32_t valueIndex = 0;
+
+            auto value = std::find_if(values.begin(), values.end(), [&axis](const ShaderMacro& macro) { return macro.Name == axis.Macro; });
+            if (value != values.end())
             {
-                for (const auto& object : group.Objects)
+                if (axis.Values.empty())
                 {
-                    if (object.API == api)
-                    {
-                        if (isGraphics)
-                        {
-                            result.IsGraphics = true;
-                            if (object.Type == ShaderType::Vertex)
-                                result.VertexOrCompute = object;
-                            if (object.Type == ShaderType::Pixel)
-                                result.Pixel = object;
-                        }
-                        else
-                        {
-                            result.IsGraphics = false;
-                            if (object.Type == ShaderType::Compute)
-                                result.VertexOrCompute = object;
-                        }
-                    }
+                    valueIndex = value->Value != "0" ? 1 : 0;
+                }
+                else
+                {
+                    auto valueIt = std::find(axis.Values.begin(), axis.Values.end(), value->Value);
+                    WR_ASSERT_OR_WARN(valueIt != axis.Values.end(), "{} is not a value of {} in shader {}", value->Value, axis.Macro, url);
+
+                    if (valueIt != axis.Values.end())
+                        valueIndex = static_cast<uint32_t>(valueIt - axis.Values.begin());
                 }
             }
+
+            key += valueIndex * stride;
+            stride *= radix;
         }
 
-        return result;
+        return key;
     }
 
-    ShaderCache ShaderCache::createFromFile(const std::filesystem::path& path)
+    void ShaderCache::rebuildIndex()
     {
-        ShaderCache cache;
+        m_Index.clear();
+        m_Index.reserve(m_Groups.size());
 
-        std::ifstream file(path, std::ios::binary);
-        StreamReader stream(file);
+        for (uint32_t i = 0; i < m_Groups.size(); i++)
+        {
+            const ShaderGroup& group = m_Groups[i];
+            if (group.Config != m_Configuration)
+                continue;
 
-        ShaderCacheHeader header;
-        stream.readRaw(header);
+            std::vector<IndexEntry>& variants = m_Index[group.Name];
+            if (variants.size() <= group.VariantKey)
+                variants.resize(group.VariantKey + 1);
 
-        cache.m_Version = header.Version;
+            variants[group.VariantKey].GroupIndex = static_cast<int32_t>(i);
 
-        std::vector<ShaderGroup>& groups = cache.m_Groups;
-        groups.resize(header.GroupCount);
+            if (m_Slots[i].Loaded)
+                Utils::SetObjectIndices(group, m_Slots[i].ObjectIndices);
+        }
+    }
 
-        stream.readArray<ShaderGroup>(groups, ReadGroup, header.GroupCount);
+    void ShaderCache::replaceGroups(std::vector<ShaderGroup>&& groups)
+    {
+        std::lock_guard lock(*m_Mutex);
 
-        file.close();
+        std::unordered_map<std::string, size_t> groupIndices;
+        BlobMap blobs;
 
-        return cache;
+        for (size_t i = 0; i < m_Groups.size(); i++)
+        {
+            groupIndices[Utils::GetGroupKey(m_Groups[i].SourcePath, m_Groups[i].Config, m_Groups[i].VariantKey)] = i;
+
+            if (m_Slots[i].Loaded)
+                Utils::InternBlobs(m_Groups[i].Objects, blobs);
+        }
+
+        for (auto& group : groups)
+        {
+            Utils::InternBlobs(group.Objects, blobs);
+
+            auto it = groupIndices.find(Utils::GetGroupKey(group.SourcePath, group.Config, group.VariantKey));
+            if (it == groupIndices.end())
+            {
+                m_Groups.push_back(std::move(group));
+                m_Slots.emplace_back();
+                continue;
+            }
+
+            // views handed out earlier point into the old objects, so they are kept alive
+            m_RetiredObjects.push_back(std::move(m_Groups[it->second].Objects));
+
+            m_Groups[it->second] = std::move(group);
+            m_Slots[it->second] = GroupSlot{};
+        }
+
+        rebuildIndex();
     }
 
-    static ShaderCacheHeader getHeader(const std::filesystem::path& path)
+    std::vector<std::string> ShaderCache::getDependencyPaths(std::string_view sourcePath) const
     {
-        std::ifstream file(path, std::ios::binary);
-        StreamReader stream(file);
+        std::lock_guard lock(*m_Mutex);
 
-        ShaderCacheHeader header;
-        stream.readRaw(header);
+        std::vector<std::string> paths;
+        for (size_t i = 0; i < m_Groups.size(); i++)
+        {
+            if (m_Groups[i].SourcePath != sourcePath)
+                continue;
 
-        file.close();
+            loadGroup(i);
+
+            for (const auto& dependency : m_Groups[i].Dependencies)
+            {
+                if (std::find(paths.begin(), paths.end(), dependency.Path) == paths.end())
+                    paths.push_back(dependency.Path);
+            }
+        }
 
-        return header;
+        return paths;
     }
 
-    ShaderCache ShaderCache::createOrGetShaderCache(const ShaderCacheDesc& desc)
+    const std::vector<ShaderGroup>& ShaderCache::getGroups() const
+    {
+        std::lock_guard lock(*m_Mutex);
+        loadAllGroups();
+
+        return m_Groups;
+    }
+
+    void ShaderCache::loadGroup(size_t index) const
     {
-        if (!std::filesystem::exists(desc.CachePath))
+        GroupSlot& slot = m_Slots[index];
+        if (slot.Loaded)
+            return;
+
+        slot.Loaded = true;
+
+        std::span<const uint8_t> file = m_File->getData();
+        ShaderGroup& group = m_Groups[index];
+
+        if (slot.Offset > file.size() || slot.Size > file.size() - slot.Offset)
         {
-            std::vector<std::filesystem::path> graphicsPaths;
-            std::vector<std::filesystem::path> computePaths;
-            std::vector<std::string> vertexEntryPoints;
-            std::vector<std::string> pixelEntryPoints;
-            std::vector<std::string> computeEntryPoints;
+            WR_ERROR("Shader cache entry {} is out of range, the file is corrupt", group.Name);
+            Utils::SetObjectIndices(group, slot.ObjectIndices);
+            return;
+        }
+
+        MemoryStreamBuffer buffer(file.subspan(slot.Offset, slot.Size));
+        std::istream record(&buffer);
+        StreamReader stream(record);
+
+        ReadGroup(stream, group, m_FileBlobs);
+
+        Utils::SetObjectIndices(group, slot.ObjectIndices);
+    }
+
+    void ShaderCache::loadAllGroups() const
+    {
+        for (size_t i = 0; i < m_Groups.size(); i++)
+            loadGroup(i);
+    }
 
-            for (const auto& shaderInfo : desc.ShaderInfos)
+    void ShaderCache::releaseFile()
+    {
+        std::lock_guard lock(*m_Mutex);
+        loadAllGroups();
+
+        // copy each mapped blob out once, objects that shared it keep sharing the copy
+        std::unordered_map<const ShaderBlob*, std::shared_ptr<const ShaderBlob>> copies;
+        for (auto& group : m_Groups)
+        {
+            for (auto& object : group.Objects)
             {
-                if (shaderInfo.IsGraphics)
-                {
-                    graphicsPaths.push_back(shaderInfo.Path);
+                if (!object.Blob || !object.Blob->File)
+                    continue;
 
-                    vertexEntryPoints.push_back(shaderInfo.VertexOrComputeEntryPoint);
-                    pixelEntryPoints.push_back(shaderInfo.PixelEntryPoint);
-                }
-                else
+                std::shared_ptr<const ShaderBlob>& copy = copies[object.Blob.get()];
+                if (!copy)
                 {
-                    computePaths.push_back(shaderInfo.Path);
-                    computeEntryPoints.push_back(shaderInfo.VertexOrComputeEntryPoint);
+                    auto blob = std::make_shared<ShaderBlob>();
+                    blob->SHA256 = object.Blob->SHA256;
+                    blob->Storage.assign(object.Blob->Data.begin(), object.Blob->Data.end());
+                    blob->Data = blob->Storage;
+
+                    copy = std::move(blob);
                 }
+
+                object.Blob = copy;
             }
+        }
 
-            if (graphicsPaths.empty() && computePaths.empty())
-                return {};
+        // nothing is compiling from the cache while it is written
+        m_RetiredObjects.clear();
+        m_FileBlobs.clear();
+        m_File.reset();
+    }
 
-            ShaderCache graphicsCache = ShaderCompiler::createShaderCacheHLSL(graphicsPaths, vertexEntryPoints, pixelEntryPoints);
-            ShaderCache computeCache = ShaderCompiler::createShaderCacheHLSL(computePaths, computeEntryPoints);
+    ShaderCache ShaderCache::createFromFile(const std::filesystem::path& path)
+    {
+        ShaderCache cache;
 
-            ShaderCache cache = combineShaderCaches(graphicsCache, computeCache);
-            cache.outputToFile(desc.CachePath);
+        // only the header and the table of contents are read here, groups are decoded on first lookup
+        auto file = std::make_shared<MappedFile>(path);
+        if (!file->isValid() || file->getData().size() < sizeof(ShaderCacheHeader))
+            return cache;
+
+        std::span<const uint8_t> data = file->getData();
 
+        ShaderCacheHeader header;
+        std::memcpy(&header, data.data(), sizeof(ShaderCacheHeader));
+
+        if (header.Version != ShaderCacheHeader{}.Version || header.TableOffset > data.size() || header.BlobTableOffset > data.size())
+        {
+            cache.m_Version = header.Version;
             return cache;
         }
 
-        ShaderCacheHeader oldCacheHeader = getHeader(desc.CachePath);
-        ShaderCacheHeader currentHeader{};
+        MemoryStreamBuffer buffer(data.subspan(header.TableOffset));
+        std::istream table(&buffer);
+        StreamReader stream(table);
 
-        if (oldCacheHeader.GroupCount != desc.ShaderInfos.size() || oldCacheHeader.Version != currentHeader.Version)
-        {
-            std::vector<std::filesystem::path> graphicsPaths;
-            std::vector<std::filesystem::path> computePaths;
-            std::vector<std::string> vertexEntryPoints;
-            std::vector<std::string> pixelEntryPoints;
-            std::vector<std::string> computeEntryPoints;
+        cache.m_Groups.resize(header.GroupCount);
+        cache.m_Slots.resize(header.GroupCount);
 
-            for (const auto& shaderInfo : desc.ShaderInfos)
-            {
-                if (shaderInfo.IsGraphics)
-                {
-                    graphicsPaths.push_back(shaderInfo.Path);
+        for (size_t i = 0; i < header.GroupCount; i++)
+        {
+            ShaderGroup& group = cache.m_Groups[i];
+            GroupSlot& slot = cache.m_Slots[i];
 
-                    vertexEntryPoints.push_back(shaderInfo.VertexOrComputeEntryPoint);
-                    pixelEntryPoints.push_back(shaderInfo.PixelEntryPoint);
-                }
-                else
-                {
-                    computePaths.push_back(shaderInfo.Path);
-                    computeEntryPoints.push_back(shaderInfo.VertexOrComputeEntryPoint);
-                }
-            }
+            stream.readRaw(slot.Offset);
+            stream.readRaw(slot.Size);
 
-            if (graphicsPaths.empty() && computePaths.empty())
-                return {};
-            
-            ShaderCache graphicsCache = ShaderCompiler::createShaderCacheHLSL(graphicsPaths, vertexEntryPoints, pixelEntryPoints);
-            ShaderCache computeCache = ShaderCompiler::createShaderCacheHLSL(computePaths, computeEntryPoints);
+            uint32_t config;
+            stream.readRaw(config);
+            group.Config = (ShaderConfiguration)config;
 
-            ShaderCache cache = combineShaderCaches(graphicsCache, computeCache);
-            cache.outputToFile(desc.CachePath);
+            stream.readRaw(group.VariantKey);
+            stream.readString(group.Name);
+            stream.readString(group.SourcePath);
 
-            return cache;
+            slot.Loaded = false;
         }
 
-        ShaderCache oldCache = createFromFile(desc.CachePath);
+        MemoryStreamBuffer blobBuffer(data.subspan(header.BlobTableOffset));
+        std::istream blobTable(&blobBuffer);
+        StreamReader blobStream(blobTable);
+
+        // the blob table is small, only the bytecode itself stays on disk until it is used
+        cache.m_FileBlobs.reserve(header.BlobCount);
+        for (size_t i = 0; i < header.BlobCount; i++)
+        {
+            uint64_t offset;
+            uint64_t size;
+            blobStream.readRaw(offset);
+            blobStream.readRaw(size);
 
-        std::vector<uint32_t> toRecreate;
-        std::vector<uint32_t> toRemove;
+            auto blob = std::make_shared<ShaderBlob>();
+            blobStream.readRaw(blob->SHA256);
+            blob->File = file;
 
-        for (uint32_t i = 0; i < desc.ShaderInfos.size(); i++)
+            if (offset <= data.size() && size <= data.size() - offset)
+                blob->Data = data.subspan(offset, size);
+            else
+                WR_ERROR("Shader cache {} has a blob that is out of range", path.string());
+
+            cache.m_FileBlobs.push_back(std::move(blob));
+        }
+
+        if (!table || !blobTable)
         {
-            const auto& shaderInfo = desc.ShaderInfos[i];
-            std::string shaderName = shaderInfo.Path.filename().string();
+            WR_ERROR("Shader cache {} has a truncated table of contents", path.string());
+            return ShaderCache();
+        }
 
-            uint32_t cacheIndex = -1;
-            for (uint32_t j = 0; j < oldCache.m_Groups.size(); j++)
-            {
-                if (oldCache.m_Groups[j].Name == shaderName)
-                {
-                    cacheIndex = j;
-                    break;
-                }
-            }
-            if (cacheIndex == -1) // shader was not in cache
+        cache.m_Version = header.Version;
+        cache.m_File = std::move(file);
+        cache.rebuildIndex();
+
+        return cache;
+    }
+
+    ShaderCache ShaderCache::createOrGetShaderCache(const ShaderCacheDesc& desc)
+    {
+        ShaderConfiguration currentConfig = ShaderCompiler::getConfiguration(desc.CompileOptions);
+
+        if (desc.LoadOnly)
+        {
+            ShaderCache cache = createFromFile(desc.CachePath);
+            if (cache.m_Version != ShaderCacheHeader{}.Version)
             {
-                toRecreate.push_back(i);
-                continue;
+                WR_ERROR("Prebuilt shader cache {} is missing or was built by a different version of wire", desc.CachePath.string());
+                return ShaderCache();
             }
 
-            constexpr ShaderConfiguration currentConfig =
-#ifdef WR_DEBUG
-                ShaderConfiguration::Debug;
-#else
-                ShaderConfiguration::Release;
-#endif
-            if (oldCache.m_Groups[cacheIndex].Config != currentConfig)
+            if (cache.m_Configuration != currentConfig)
             {
-                toRecreate.push_back(i);
-                toRemove.push_back(cacheIndex);
-                continue;
+                cache.m_Configuration = currentConfig;
+                cache.rebuildIndex();
             }
 
-            std::ifstream file(shaderInfo.Path);
-            std::stringstream ss;
-            ss << file.rdbuf();
-            file.close();
+            if (cache.m_Index.empty())
+                WR_ERROR("Prebuilt shader cache {} has no shaders for this configuration", desc.CachePath.string());
 
-            std::string shaderSource = ss.str();
-            std::array<uint32_t, 8> shaderHash = generateSHA256(shaderSource);
-
-            if (std::memcmp(oldCache.m_Groups[cacheIndex].SHA256, shaderHash.data(), sizeof(uint32_t) * 8) != 0)
-            {
-                toRecreate.push_back(i);
-                toRemove.push_back(cacheIndex);
-                continue;
-            }
+            return cache;
         }
 
-        // sort in descending order
-        std::sort(toRemove.rbegin(), toRemove.rend());
+        // every group is checked against its sources, so decode them all up front. the bytecode
+        // stays in the mapping and is only copied out if the cache has to be written again
+        ShaderCache oldCache = createFromFile(desc.CachePath);
+        if (oldCache.m_Version == ShaderCacheHeader{}.Version)
+        {
+            std::lock_guard lock(*oldCache.m_Mutex);
+            oldCache.loadAllGroups();
+        }
+        else
+        {
+            oldCache = ShaderCache();
+        }
 
-        for (uint32_t i : toRemove)
+        std::unordered_map<std::string, size_t> oldGroupIndices;
+        for (size_t i = 0; i < oldCache.m_Groups.size(); i++)
         {
-            if (i >= 0 && i < oldCache.m_Groups.size())
-                oldCache.m_Groups.erase(oldCache.m_Groups.begin() + i);
+            const ShaderGroup& group = oldCache.m_Groups[i];
+            oldGroupIndices[Utils::GetGroupKey(group.SourcePath, group.Config, group.VariantKey)] = i;
         }
 
-        std::vector<std::filesystem::path> graphicsPaths;
-        std::vector<std::filesystem::path> computePaths;
-        std::vector<std::string> vertexEntryPoints;
-        std::vector<std::string> pixelEntryPoints;
-        std::vector<std::string> computeEntryPoints;
+        ShaderOptimizationOptions optimization = ShaderCompiler::getOptimizationOptions(currentConfig, desc.CompileOptions);
+
+        std::vector<ShaderGroup> groups;
+        std::vector<uint8_t> taken(oldCache.m_Groups.size());
+        std::unordered_set<std::string> livePaths;
 
-        for (uint32_t i : toRecreate)
+        std::vector<ShaderInfo> toRecreate;
+        std::vector<size_t> recreateSlots;
+
+        bool dirty = false;
+
+        for (const auto& shaderInfo : desc.ShaderInfos)
         {
-            if (desc.ShaderInfos[i].IsGraphics)
+            std::string sourcePath = shaderInfo.Path.generic_string();
+            livePaths.insert(sourcePath);
+
+            // switching front ends changes the hash, so the shader is rebuilt
+            uint64_t optionsHash = ShaderCompiler::getOptionsHash(currentConfig, optimization, desc.CompileOptions.IncludeDirectories, shaderInfo.Frontend);
+
+            // only the variants that are out of date get compiled again
+            ShaderInfo staleInfo = shaderInfo;
+            staleInfo.Variants.clear();
+
+            for (uint32_t variantKey : ShaderCompiler::getRequestedVariants(shaderInfo))
             {
-                graphicsPaths.push_back(desc.ShaderInfos[i].Path);
+                auto it = oldGroupIndices.find(Utils::GetGroupKey(sourcePath, currentConfig, variantKey));
+                if (it != oldGroupIndices.end() && !taken[it->second])
+                {
+                    ShaderGroup& group = oldCache.m_Groups[it->second];
+
+                    bool statChanged = false;
+                    if (Utils::IsGroupUpToDate(group, shaderInfo, optionsHash, statChanged))
+                    {
+                        dirty |= statChanged;
+                        taken[it->second] = true;
 
-                vertexEntryPoints.push_back(desc.ShaderInfos[i].VertexOrComputeEntryPoint);
-                pixelEntryPoints.push_back(desc.ShaderInfos[i].PixelEntryPoint);
+                        groups.push_back(std::move(group));
+                        continue;
+                    }
+                }
+
+                recreateSlots.push_back(groups.size());
+                staleInfo.Variants.push_back(variantKey);
+                groups.emplace_back();
+            }
+
+            if (!staleInfo.Variants.empty())
+                toRecreate.push_back(std::move(staleInfo));
+        }
+
+        // keep the other configuration's variants of shaders that still exist
+        for (size_t i = 0; i < oldCache.m_Groups.size(); i++)
+        {
+            if (taken[i])
+                continue;
+
+            ShaderGroup& group = oldCache.m_Groups[i];
+            if (group.Config != currentConfig && livePaths.contains(group.SourcePath))
+            {
+                taken[i] = true;
+                groups.push_back(std::move(group));
             }
             else
             {
-                computePaths.push_back(desc.ShaderInfos[i].Path);
-                computeEntryPoints.push_back(desc.ShaderInfos[i].VertexOrComputeEntryPoint);
+                dirty = true;
             }
         }
 
-        if (graphicsPaths.empty() && computePaths.empty())
-            return oldCache;
+        if (!toRecreate.empty())
+        {
+            ShaderCache newCache = ShaderCompiler::createShaderCacheHLSL(toRecreate, desc.CompileOptions);
+
+            for (size_t i = 0; i < recreateSlots.size(); i++)
+                groups[recreateSlots[i]] = std::move(newCache.m_Groups[i]);
+
+            dirty = true;
+        }
 
-        ShaderCache newGraphicsCache = ShaderCompiler::createShaderCacheHLSL(graphicsPaths, vertexEntryPoints, pixelEntryPoints);
-        ShaderCache newComputeCache = ShaderCompiler::createShaderCacheHLSL(computePaths, computeEntryPoints);
+        // groups taken from the old cache still point into its mapping
+        ShaderCache result(std::move(groups), currentConfig);
+        result.m_File = oldCache.m_File;
 
-        ShaderCache newCache = combineShaderCaches(newGraphicsCache, newComputeCache);
+        // leftover groups would keep the file mapped while it is written
+        oldCache = ShaderCache();
 
-        ShaderCache result = combineShaderCaches(oldCache, newCache);
-        result.outputToFile(desc.CachePath);
+        if (dirty)
+            result.outputToFile(desc.CachePath);
 
         return result;
     }
 
-    ShaderCache ShaderCache::combineShaderCaches(const ShaderCache& lhs, const ShaderCache& rhs)
+    ShaderCache ShaderCache::combineShaderCaches(ShaderCache&& lhs, ShaderCache&& rhs)
     {
-        std::unordered_map<std::string, ShaderGroup> mergedMap;
+        // groups keep the order they first appear in, so the output is deterministic
+        std::unordered_map<std::string, size_t> groupIndices;
+        std::vector<ShaderGroup> result;
+        ShaderConfiguration configuration = lhs.m_Configuration;
 
-        auto insertOrMerge = [&mergedMap](const std::vector<ShaderGroup>& groups)
+        // blobs keep their mappings alive, so groups are moved over as they are
+        auto insertOrMerge = [&groupIndices, &result](ShaderCache& cache)
         {
-            for (const auto& group : groups)
             {
-                auto it = mergedMap.find(group.Name);
-                if (it != mergedMap.end())
+                std::lock_guard lock(*cache.m_Mutex);
+                cache.loadAllGroups();
+            }
+
+            for (auto& group : cache.m_Groups)
+            {
+                std::string key = Utils::GetGroupKey(group.SourcePath, group.Config, group.VariantKey);
+
+                auto it = groupIndices.find(key);
+                if (it != groupIndices.end())
                 {
                     // Merge ShaderObjects if group name already exists
-                    it->second.Objects.insert(it->second.Objects.end(), group.Objects.begin(), group.Objects.end());
+                    std::vector<ShaderObject>& objects = result[it->second].Objects;
+                    objects.insert(objects.end(), std::make_move_iterator(group.Objects.begin()), std::make_move_iterator(group.Objects.end()));
                 }
                 else
                 {
-                    mergedMap[group.Name] = group;
+                    groupIndices[key] = result.size();
+                    result.push_back(std::move(group));
                 }
             }
-        };
 
-        insertOrMerge(lhs.m_Groups);
-        insertOrMerge(rhs.m_Groups);
+            cache = ShaderCache();
+        };
 
-        std::vector<ShaderGroup> result;
-        result.reserve(mergedMap.size());
-        for (auto& pair : mergedMap)
-        {
-            result.push_back(std::move(pair.second));
-        }
+        insertOrMerge(lhs);
+        insertOrMerge(rhs);
 
-        return result;
+        return ShaderCache(std::move(result), configuration);
     }
 
-    void WriteGroup(StreamWriter& stream, const ShaderGroup& group)
+    void WriteGroup(StreamWriter& stream, const ShaderGroup& group, const std::unordered_map<const ShaderBlob*, uint32_t>& blobIndices)
     {
         stream.writeString(group.Name);
+        stream.writeString(group.SourcePath);
         stream.writeRaw(group.SHA256);
         stream.writeRaw((uint32_t)group.Config);
-        stream.writeArray<ShaderObject>(group.Objects, WriteObject, true);
+        stream.writeRaw(group.OptionsHash);
+        stream.writeRaw(group.SourceWriteTime);
+        stream.writeRaw(group.SourceSize);
+        stream.writeArray<ShaderDependency>(group.Dependencies, WriteDependency, true);
+        stream.writeRaw(group.DependencyHash);
+        stream.writeRaw(group.VariantKey);
+        stream.writeArray<ShaderVariantAxis>(group.VariantAxes, WriteVariantAxis, true);
+        stream.writeArray<ShaderMacro>(group.Defines, WriteMacro, true);
+
+        stream.writeRaw<size_t>(group.Objects.size());
+        for (const auto& object : group.Objects)
+            WriteObject(stream, object, object.Blob ? blobIndices.at(object.Blob.get()) : NoBlob);
     }
 
-    void WriteObject(StreamWriter& stream, const ShaderObject& object)
+    void WriteDependency(StreamWriter& stream, const ShaderDependency& dependency)
+    {
+        stream.writeString(dependency.Path);
+        stream.writeRaw(dependency.SHA256);
+        stream.writeRaw(dependency.WriteTime);
+        stream.writeRaw(dependency.Size);
+    }
+
+    void WriteVariantAxis(StreamWriter& stream, const ShaderVariantAxis& axis)
+    {
+        stream.writeString(axis.Macro);
+        stream.writeArray<std::string>(axis.Values, [](StreamWriter& stream, const std::string& value) { stream.writeString(value); }, true);
+    }
+
+    void WriteMacro(StreamWriter& stream, const ShaderMacro& macro)
+    {
+        stream.writeString(macro.Name);
+        stream.writeString(macro.Value);
+    }
+
+    void WriteObject(StreamWriter& stream, const ShaderObject& object, uint32_t blobIndex)
     {
         stream.writeRaw((uint32_t)object.API);
         stream.writeRaw((uint32_t)object.Type);
         stream.writeString(object.EntryPoint);
-        stream.writeArray(object.Bytecode);
+        stream.writeRaw(blobIndex);
+        WriteReflection(stream, object.Reflection);
+    }
+
+    void WriteReflection(StreamWriter& stream, const ShaderReflection& reflection)
+    {
+        stream.writeArray<ShaderReflectedResource>(reflection.Resources, [](StreamWriter& stream, const ShaderReflectedResource& resource)
+        {
+            stream.writeRaw(resource.Set);
+            stream.writeRaw(resource.Binding);
+            stream.writeRaw((uint32_t)resource.Type);
+            stream.writeRaw(resource.ArrayCount);
+        }, true);
+
+        stream.writeRaw(reflection.PushConstantOffset);
+        stream.writeRaw(reflection.PushConstantSize);
+        stream.writeRaw(reflection.WorkgroupSize);
+        stream.writeArray(reflection.SpecializationConstants);
     }
 
-    void ReadGroup(StreamReader& stream, ShaderGroup& group)
+    void ReadGroup(StreamReader& stream, ShaderGroup& group, const std::vector<std::shared_ptr<const ShaderBlob>>& blobs)
     {
         stream.readString(group.Name);
+        stream.readString(group.SourcePath);
         stream.readRaw(group.SHA256);
 
         uint32_t config;
         stream.readRaw(config);
         group.Config = (ShaderConfiguration)config;
 
-        stream.readArray<ShaderObject>(group.Objects, ReadObject);
+        stream.readRaw(group.OptionsHash);
+        stream.readRaw(group.SourceWriteTime);
+        stream.readRaw(group.SourceSize);
+
+        stream.readArray<ShaderDependency>(group.Dependencies, ReadDependency);
+        stream.readRaw(group.DependencyHash);
+
+        stream.readRaw(group.VariantKey);
+        stream.readArray<ShaderVariantAxis>(group.VariantAxes, ReadVariantAxis);
+        stream.readArray<ShaderMacro>(group.Defines, ReadMacro);
+
+        stream.readArray<ShaderObject>(group.Objects, [&group, &blobs](StreamReader& stream, ShaderObject& object)
+        {
+            if (!ReadObject(stream, object, blobs))
+                WR_ERROR("Shader {} refers to a blob that is not in the cache file", group.Name);
+        });
     }
 
-    void ReadObject(StreamReader& stream, ShaderObject& object)
+    void ReadDependency(StreamReader& stream, ShaderDependency& dependency)
+    {
+        stream.readString(dependency.Path);
+        stream.readRaw(dependency.SHA256);
+        stream.readRaw(dependency.WriteTime);
+        stream.readRaw(dependency.Size);
+    }
+
+    void ReadVariantAxis(StreamReader& stream, ShaderVariantAxis& axis)
+    {
+        stream.readString(axis.Macro);
+        stream.readArray<std::string>(axis.Values, [](StreamReader& stream, std::string& value) { stream.readString(value); });
+    }
+
+    void ReadMacro(StreamReader& stream, ShaderMacro& macro)
+    {
+        stream.readString(macro.Name);
+        stream.readString(macro.Value);
+    }
+
+    bool ReadObject(StreamReader& stream, ShaderObject& object, const std::vector<std::shared_ptr<const ShaderBlob>>& blobs)
     {
         uint32_t api;
         stream.readRaw(api);
@@ -399,7 +1007,39 @@ namespace wire {
         object.Type = (ShaderType)type;
 
         stream.readString(object.EntryPoint);
-        stream.readArray(object.Bytecode);
+
+        uint32_t blobIndex;
+        stream.readRaw(blobIndex);
+
+        ReadReflection(stream, object.Reflection);
+
+        if (blobIndex == NoBlob)
+            return true;
+        if (blobIndex >= blobs.size())
+            return false;
+
+        object.Blob = blobs[blobIndex];
+        return true;
+    }
+
+    void ReadReflection(StreamReader& stream, ShaderReflection& reflection)
+    {
+        stream.readArray<ShaderReflectedResource>(reflection.Resources, [](StreamReader& stream, ShaderReflectedResource& resource)
+        {
+            stream.readRaw(resource.Set);
+            stream.readRaw(resource.Binding);
+
+            uint32_t type;
+            stream.readRaw(type);
+            resource.Type = (ShaderResourceType)type;
+
+            stream.readRaw(resource.ArrayCount);
+        });
+
+        stream.readRaw(reflection.PushConstantOffset);
+        stream.readRaw(reflection.PushConstantSize);
+        stream.readRaw(reflection.WorkgroupSize);
+        stream.readArray(reflection.SpecializationConstants);
     }
 
 }
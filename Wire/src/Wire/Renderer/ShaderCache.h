@@ -1,8 +1,15 @@
 #pragma once
 
+#include <span>
+#include <array>
+#include <mutex>
+#include <memory>
 #include <vector>
 #include <string>
+#include <optional>
+#include <string_view>
 #include <filesystem>
+#include <unordered_map>
 
 namespace wire {
     
@@ -18,25 +25,122 @@ namespace wire {
         Compute
     };
 
+    constexpr size_t RendererAPICount = 1;
+    constexpr size_t ShaderTypeCount = 3;
+
     enum class ShaderConfiguration
     {
         Debug = 0,
         Release
     };
 
+    // hlsl front end that produces the spir-v. dxc supports shader model 6 features glslang lacks,
+    // such as wave intrinsics and 16-bit types
+    enum class ShaderFrontend
+    {
+        Shaderc = 0,
+        DXC
+    };
+
+    enum class ShaderResourceType
+    {
+        UniformBuffer = 0,
+        CombinedImageSampler,
+        SampledImage,
+        Sampler,
+        StorageBuffer,
+        StorageImage
+    };
+
+    struct ShaderReflectedResource
+    {
+        uint32_t Set;
+        uint32_t Binding;
+        ShaderResourceType Type;
+        uint32_t ArrayCount;
+    };
+
+    // resource interface of a single entry point, extracted from the bytecode at compile time
+    struct ShaderReflection
+    {
+        std::vector<ShaderReflectedResource> Resources;
+
+        uint32_t PushConstantOffset = 0;
+        uint32_t PushConstantSize = 0; // 0 = no push constants
+
+        uint32_t WorkgroupSize[3] = { 1, 1, 1 };
+
+        std::vector<uint32_t> SpecializationConstants; // constant ids
+    };
+
+    class MappedFile;
+
+    // bytecode shared by every object with the same content, stored once per cache file
+    struct ShaderBlob
+    {
+        std::array<uint32_t, 8> SHA256;
+        std::span<const uint8_t> Data;
+
+        std::vector<uint8_t> Storage;           // owns Data, empty when Data points into a mapped cache file
+        std::shared_ptr<const MappedFile> File; // keeps that mapping alive
+
+        static std::shared_ptr<const ShaderBlob> create(std::vector<uint8_t>&& bytecode);
+    };
+
     struct ShaderObject
     {
         RendererAPI API;
         ShaderType Type;
         std::string EntryPoint;
-        std::vector<uint8_t> Bytecode;
+        std::shared_ptr<const ShaderBlob> Blob; // nullptr when compilation failed
+        ShaderReflection Reflection;
+
+        std::span<const uint8_t> getBytecode() const { return Blob ? Blob->Data : std::span<const uint8_t>(); }
+    };
+
+    struct ShaderMacro
+    {
+        std::string Name;
+        std::string Value;
+    };
+
+    // one macro the shader is compiled with, every value produces its own variant.
+    // an axis without values is a toggle: index 0 leaves the macro undefined, index 1 defines it as 1
+    struct ShaderVariantAxis
+    {
+        std::string Macro;
+        std::vector<std::string> Values;
+    };
+
+    struct ShaderDependency
+    {
+        std::string Path;
+        uint32_t SHA256[8];
+        int64_t WriteTime = 0;
+        uint64_t Size = 0;
     };
 
     struct ShaderGroup
     {
         std::string Name;
+        std::string SourcePath;
         uint32_t SHA256[8];
         ShaderConfiguration Config;
+        uint64_t OptionsHash = 0;
+
+        // used to skip hashing sources that have not been touched
+        int64_t SourceWriteTime = 0;
+        uint64_t SourceSize = 0;
+
+        // every file pulled in through #include, and a hash over the source and all of them
+        std::vector<ShaderDependency> Dependencies;
+        uint32_t DependencyHash[8];
+
+        // mixed radix index into the axes, the first axis changes fastest
+        uint32_t VariantKey = 0;
+        std::vector<ShaderVariantAxis> VariantAxes;
+        std::vector<ShaderMacro> Defines;
+
         std::vector<ShaderObject> Objects;
     };
 
@@ -46,39 +150,147 @@ namespace wire {
         bool IsGraphics;
         std::string VertexOrComputeEntryPoint;
         std::string PixelEntryPoint;
+
+        std::vector<ShaderVariantAxis> VariantAxes;
+        std::vector<uint32_t> Variants; // keys to compile, empty = every permutation
+
+        ShaderFrontend Frontend = ShaderFrontend::Shaderc;
+    };
+
+    enum class ShaderOptimizationPreset
+    {
+        None = 0,
+        Size,
+        Performance
+    };
+
+    // spirv-opt passes run on the bytecode before it is stored in the cache
+    struct ShaderOptimizationOptions
+    {
+        ShaderOptimizationPreset Preset = ShaderOptimizationPreset::None;
+        bool InlineFunctions = false;
+        bool EliminateDeadCode = false;
+        bool StripDebugInfo = false;
+    };
+
+    struct ShaderCompileOptions
+    {
+        bool Parallel = true;
+        uint32_t ThreadCount = 0; // 0 = one per hardware thread
+
+        std::vector<std::filesystem::path> IncludeDirectories;
+
+        // empty = the configuration wire was built with
+        std::optional<ShaderConfiguration> Configuration;
+
+        // empty = keep debug info in debug, strip it and optimize for performance in release
+        std::optional<ShaderOptimizationOptions> Optimization;
     };
 
     struct ShaderCacheDesc
     {
         std::filesystem::path CachePath;
         std::vector<ShaderInfo> ShaderInfos;
+        ShaderCompileOptions CompileOptions;
+
+        // only load a prebuilt cache (see wire-shaderc), sources are never checked or compiled
+        bool LoadOnly = false;
+
+        // recompile shaders when their sources change and rebuild the pipelines using them, ignored with LoadOnly
+        bool HotReload = false;
+    };
+
+    // non-owning, only valid while the ShaderCache it came from is alive and unmodified
+    struct ShaderObjectView
+    {
+        RendererAPI API;
+        ShaderType Type;
+        std::string_view EntryPoint;
+        std::span<const uint8_t> Bytecode;
+        const ShaderReflection* Reflection = nullptr;
+        const std::array<uint32_t, 8>* SHA256 = nullptr; // of Bytecode, nullptr when compilation failed
     };
 
     struct ShaderResult
     {
         bool IsGraphics;
-        ShaderObject VertexOrCompute;
-        ShaderObject Pixel;
+        ShaderObjectView VertexOrCompute;
+        ShaderObjectView Pixel;
     };
 
     class ShaderCache
     {
     public:
-        ShaderCache() = default;
-        ShaderCache(const std::vector<ShaderGroup>& groups);
+        ShaderCache();
+        // lookups only see groups of configuration, the build's own when it is not given
+        ShaderCache(const std::vector<ShaderGroup>& groups, std::optional<ShaderConfiguration> configuration = {});
+        ShaderCache(std::vector<ShaderGroup>&& groups, std::optional<ShaderConfiguration> configuration = {});
+        ShaderCache(ShaderCache&& other) noexcept;
+        ~ShaderCache();
+
+        ShaderCache& operator=(ShaderCache&& other) noexcept;
 
         void outputToFile(const std::filesystem::path& path);
 
-        ShaderResult getShaderFromURL(const std::filesystem::path& path, RendererAPI api, bool isGraphics);
+        ShaderResult getShaderFromURL(std::string_view url, RendererAPI api, bool isGraphics, uint32_t variant = 0) const;
+        // for optional shaders, the lookups above assert when the url is missing
+        bool hasShader(std::string_view url) const;
+
+        // resolve once and keep the key, lookups by key are constant time
+        uint32_t getVariantKey(std::string_view url, const std::vector<ShaderMacro>& values) const;
 
-        const std::vector<ShaderGroup>& getGroups() const { return m_Groups; }
+        // decodes every group that has not been looked up yet
+        const std::vector<ShaderGroup>& getGroups() const;
+
+        // swaps in recompiled groups while the cache is in use, views of the old ones stay valid
+        void replaceGroups(std::vector<ShaderGroup>&& groups);
+        std::vector<std::string> getDependencyPaths(std::string_view sourcePath) const;
 
         static ShaderCache createFromFile(const std::filesystem::path& path);
         static ShaderCache createOrGetShaderCache(const ShaderCacheDesc& desc);
-        static ShaderCache combineShaderCaches(const ShaderCache& lhs, const ShaderCache& rhs);
+        static ShaderCache combineShaderCaches(ShaderCache&& lhs, ShaderCache&& rhs);
     private:
-        uint32_t m_Version;
-        std::vector<ShaderGroup> m_Groups;
+        void rebuildIndex();
+
+        // callers hold m_Mutex
+        void loadGroup(size_t index) const;
+        void loadAllGroups() const;
+        void releaseFile();
+    private:
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view string) const { return std::hash<std::string_view>{}(string); }
+        };
+
+        struct IndexEntry
+        {
+            int32_t GroupIndex = -1;
+        };
+
+        // where a group lives in the mapped file, groups are decoded on first lookup
+        struct GroupSlot
+        {
+            uint64_t Offset = 0;
+            uint64_t Size = 0;
+            bool Loaded = true;
+
+            std::array<std::array<int32_t, ShaderTypeCount>, RendererAPICount> ObjectIndices;
+        };
+
+        uint32_t m_Version = 0;
+        ShaderConfiguration m_Configuration; // of the groups in m_Index
+        mutable std::vector<ShaderGroup> m_Groups;
+        mutable std::vector<GroupSlot> m_Slots;
+        std::vector<std::vector<ShaderObject>> m_RetiredObjects;
+
+        std::shared_ptr<MappedFile> m_File;
+        std::vector<std::shared_ptr<const ShaderBlob>> m_FileBlobs; // blob table of m_File
+        mutable std::unique_ptr<std::mutex> m_Mutex = std::make_unique<std::mutex>();
+
+        // shader name -> groups of the current configuration, indexed by variant key
+        std::unordered_map<std::string, std::vector<IndexEntry>, StringHash, std::equal_to<>> m_Index;
     };
 
 }
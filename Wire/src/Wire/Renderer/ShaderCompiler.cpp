@@ -2,12 +2,19 @@
 
 #include "Device.h"
 #include "Wire/Core/Assert.h"
+#include "Wire/Core/ThreadPool.h"
 #include "Wire/Serialization/SHA-256.h"
 
 #include <shaderc/shaderc.hpp>
+#include <dxc/dxcapi.h>
 #include <spirv_cross/spirv_cross.hpp>
 #include <spirv_cross/spirv_hlsl.hpp>
+#include <spirv-tools/optimizer.hpp>
 
+#include <chrono>
+#include <algorithm>
+#include <functional>
+#include <unordered_map>
 #include <string>
 #include <fstream>
 #include <sstream>
@@ -34,69 +41,607 @@ namespace wire {
             return shaderc_shader_kind(0);
         }
 
-    }
+        static const char* ShaderTypeToString(ShaderType type)
+        {
+            switch (type)
+            {
+            case ShaderType::Vertex:
+                return "vertex";
+            case ShaderType::Pixel:
+                return "pixel";
+            case ShaderType::Compute:
+                return "compute";
+            default:
+                break;
+            }
 
-    ShaderCompilationResult ShaderCompiler::compileHLSLToSpirv(const std::filesystem::path& path, ShaderType type, const std::string& entryPoint)
-    {
-        ShaderCompilationResult comp;
+            return "unknown";
+        }
 
-        std::ifstream file(path);
-        std::stringstream ss;
-        ss << file.rdbuf();
-        file.close();
+        static const wchar_t* GetDXCProfile(ShaderType type)
+        {
+            switch (type)
+            {
+            case ShaderType::Vertex:
+                return L"vs_6_6";
+            case ShaderType::Pixel:
+                return L"ps_6_6";
+            case ShaderType::Compute:
+                return L"cs_6_6";
+            default:
+                break;
+            }
+
+            WR_ASSERT(false, "Unkown shader type");
+            return L"";
+        }
 
-        if (!file.good())
+        static std::wstring WidenASCII(std::string_view string)
         {
-            return ShaderCompilationResult{
-                .Success = false,
-                .ErrorMessage = "Failed to open file " + path.string()
-            };
+            return std::wstring(string.begin(), string.end());
         }
 
-        std::string shader = ss.str();
+        static bool ReadShaderSource(const std::filesystem::path& path, std::string& outSource)
+        {
+            std::ifstream file(path);
+            if (!file.good())
+                return false;
 
-        shaderc::Compiler compiler;
-        shaderc::CompileOptions options;
+            std::stringstream ss;
+            ss << file.rdbuf();
+            outSource = ss.str();
 
-        options.SetSourceLanguage(shaderc_source_language_hlsl);
-        options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
-        options.AddMacroDefinition("SPIRV");
+            return true;
+        }
 
-        constexpr bool debug =
+        static constexpr ShaderConfiguration GetCurrentConfiguration()
+        {
 #ifdef WR_DEBUG
-            true;
+            return ShaderConfiguration::Debug;
 #else
-            false;
+            return ShaderConfiguration::Release;
 #endif
+        }
 
-        if constexpr (debug)
+        // GetCompileOptionsDescription must change whenever this does, it feeds the cache key
+        static void SetCompileOptions(shaderc::CompileOptions& options, ShaderConfiguration config)
         {
-            options.SetGenerateDebugInfo();
+            options.SetSourceLanguage(shaderc_source_language_hlsl);
+            options.SetTargetEnvironment(shaderc_target_env_vulkan, shaderc_env_version_vulkan_1_2);
+            options.AddMacroDefinition("SPIRV");
+
+            // optimization is left to the spirv-opt stage so its passes can be configured
             options.SetOptimizationLevel(shaderc_optimization_level_zero);
+
+            if (config == ShaderConfiguration::Debug)
+                options.SetGenerateDebugInfo();
         }
-        else
-            options.SetOptimizationLevel(shaderc_optimization_level_performance);
 
-        shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(shader, Utils::ConvertShaderType(type), path.string().c_str(), entryPoint.c_str(), options);
+        // GetCompileOptionsDescription must change whenever this does, it feeds the cache key
+        static std::vector<std::wstring> GetDXCArguments(const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, ShaderConfiguration config, const ShaderCompileOptions& compileOptions, const std::vector<ShaderMacro>& defines)
+        {
+            std::vector<std::wstring> arguments = {
+                path.wstring(),
+                L"-E", WidenASCII(entryPoint),
+                L"-T", GetDXCProfile(type),
+                L"-spirv",
+                L"-fspv-target-env=vulkan1.2",
+                L"-enable-16bit-types",
+                L"-D", L"SPIRV",
+                // optimization is left to the spirv-opt stage, as with shaderc
+                L"-O0"
+            };
+
+            if (config == ShaderConfiguration::Debug)
+                arguments.push_back(L"-Zi");
+
+            for (const auto& directory : compileOptions.IncludeDirectories)
+            {
+                arguments.push_back(L"-I");
+                arguments.push_back(directory.wstring());
+            }
+
+            for (const auto& define : defines)
+            {
+                arguments.push_back(L"-D");
+                // an empty value defines the macro as empty, matching shaderc
+                arguments.push_back(WidenASCII(define.Name + "=" + define.Value));
+            }
+
+            return arguments;
+        }
+
+        static std::string GetCompileOptionsDescription(ShaderConfiguration config, const ShaderOptimizationOptions& optimization, const std::vector<std::filesystem::path>& includeDirectories, ShaderFrontend frontend)
+        {
+            // shaderc keeps its original description so existing caches stay valid
+            std::string description = frontend == ShaderFrontend::DXC ? "dxc;hlsl;vulkan1.2;sm6_6;16bit;SPIRV;O0;" : "hlsl;vulkan1.2;SPIRV;O0;";
+
+            if (config == ShaderConfiguration::Debug)
+                description += "g;";
+
+            switch (optimization.Preset)
+            {
+            case ShaderOptimizationPreset::Size:
+                description += "opt-size;";
+                break;
+            case ShaderOptimizationPreset::Performance:
+                description += "opt-perf;";
+                break;
+            default:
+                break;
+            }
+
+            if (optimization.InlineFunctions)
+                description += "inline;";
+            if (optimization.EliminateDeadCode)
+                description += "dce;";
+            if (optimization.StripDebugInfo)
+                description += "strip;";
+
+            // in search order, a different directory can resolve an include to a different file
+            for (const auto& directory : includeDirectories)
+                description += "I" + directory.generic_string() + ";";
+
+            return description;
+        }
+
+        static void ReflectSpirv(const std::vector<uint8_t>& bytecode, ShaderType type, ShaderReflection& outReflection)
+        {
+            spirv_cross::Compiler compiler(reinterpret_cast<const uint32_t*>(bytecode.data()), bytecode.size() / sizeof(uint32_t));
+            spirv_cross::ShaderResources resources = compiler.get_shader_resources();
+
+            auto addResources = [&](const auto& list, ShaderResourceType resourceType)
+            {
+                for (const spirv_cross::Resource& resource : list)
+                {
+                    const spirv_cross::SPIRType& spirType = compiler.get_type(resource.type_id);
+
+                    // runtime sized arrays report 0, a single descriptor is the only safe default
+                    uint32_t arrayCount = 1;
+                    for (uint32_t size : spirType.array)
+                        arrayCount *= std::max(size, 1u);
+
+                    outReflection.Resources.push_back(ShaderReflectedResource{
+                        .Set = compiler.get_decoration(resource.id, spv::DecorationDescriptorSet),
+                        .Binding = compiler.get_decoration(resource.id, spv::DecorationBinding),
+                        .Type = resourceType,
+                        .ArrayCount = arrayCount
+                    });
+                }
+            };
+
+            addResources(resources.uniform_buffers, ShaderResourceType::UniformBuffer);
+            addResources(resources.sampled_images, ShaderResourceType::CombinedImageSampler);
+            addResources(resources.separate_images, ShaderResourceType::SampledImage);
+            addResources(resources.separate_samplers, ShaderResourceType::Sampler);
+            addResources(resources.storage_buffers, ShaderResourceType::StorageBuffer);
+            addResources(resources.storage_images, ShaderResourceType::StorageImage);
+
+            std::sort(outReflection.Resources.begin(), outReflection.Resources.end(), [](const ShaderReflectedResource& lhs, const ShaderReflectedResource& rhs)
+            {
+                return lhs.Set != rhs.Set ? lhs.Set < rhs.Set : lhs.Binding < rhs.Binding;
+            });
+
+            if (!resources.push_constant_buffers.empty())
+            {
+                const spirv_cross::Resource& pushConstants = resources.push_constant_buffers[0];
+                const spirv_cross::SPIRType& blockType = compiler.get_type(pushConstants.base_type_id);
+
+                size_t begin = compiler.get_declared_struct_size(blockType);
+                for (const auto& range : compiler.get_active_buffer_ranges(pushConstants.id))
+                    begin = std::min(begin, range.offset);
+
+                outReflection.PushConstantOffset = static_cast<uint32_t>(begin);
+                outReflection.PushConstantSize = static_cast<uint32_t>(compiler.get_declared_struct_size(blockType) - begin);
+            }
+
+            for (const spirv_cross::SpecializationConstant& constant : compiler.get_specialization_constants())
+                outReflection.SpecializationConstants.push_back(constant.constant_id);
+
+            if (type == ShaderType::Compute)
+            {
+                for (uint32_t i = 0; i < 3; i++)
+                    outReflection.WorkgroupSize[i] = compiler.get_execution_mode_argument(spv::ExecutionModeLocalSize, i);
+            }
+        }
+
+        class ShaderIncluder : public shaderc::CompileOptions::IncluderInterface
+        {
+        public:
+            ShaderIncluder(const std::vector<std::filesystem::path>& includeDirectories, std::vector<std::filesystem::path>& dependencies)
+                : m_IncludeDirectories(includeDirectories), m_Dependencies(dependencies)
+            {
+            }
+
+            virtual shaderc_include_result* GetInclude(const char* requestedSource, shaderc_include_type type, const char* requestingSource, size_t includeDepth) override
+            {
+                IncludeData* data = new IncludeData();
+
+                std::filesystem::path resolved = resolve(requestedSource, type, requestingSource);
+                if (!resolved.empty() && ReadShaderSource(resolved, data->Content))
+                {
+                    data->SourceName = resolved.generic_string();
+
+                    if (std::find(m_Dependencies.begin(), m_Dependencies.end(), resolved) == m_Dependencies.end())
+                        m_Dependencies.push_back(resolved);
+                }
+                else
+                {
+                    // an empty source name tells shaderc the include failed, the content is the error
+                    data->Content = std::string("failed to resolve include \"") + requestedSource + "\"";
+                }
+
+                data->Result.source_name = data->SourceName.c_str();
+                data->Result.source_name_length = data->SourceName.size();
+                data->Result.content = data->Content.c_str();
+                data->Result.content_length = data->Content.size();
+                data->Result.user_data = data;
+
+                return &data->Result;
+            }
+
+            virtual void ReleaseInclude(shaderc_include_result* data) override
+            {
+                delete static_cast<IncludeData*>(data->user_data);
+            }
+        private:
+            std::filesystem::path resolve(const char* requestedSource, shaderc_include_type type, const char* requestingSource) const
+            {
+                std::filesystem::path relative = std::filesystem::path(requestingSource).parent_path() / requestedSource;
+
+                if (type == shaderc_include_type_relative && std::filesystem::exists(relative))
+                    return relative.lexically_normal();
 
-        if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+                for (const auto& directory : m_IncludeDirectories)
+                {
+                    std::filesystem::path candidate = directory / requestedSource;
+                    if (std::filesystem::exists(candidate))
+                        return candidate.lexically_normal();
+                }
+
+                if (std::filesystem::exists(relative))
+                    return relative.lexically_normal();
+
+                return {};
+            }
+        private:
+            struct IncludeData
+            {
+                std::string SourceName;
+                std::string Content;
+                shaderc_include_result Result;
+            };
+
+            const std::vector<std::filesystem::path>& m_IncludeDirectories;
+            std::vector<std::filesystem::path>& m_Dependencies;
+        };
+
+        static shaderc::Compiler& GetThreadCompiler()
+        {
+            // compilers are not shared between threads, each worker keeps its own
+            thread_local shaderc::Compiler compiler;
+            return compiler;
+        }
+
+        template<typename T>
+        class DxcRef
+        {
+        public:
+            DxcRef() = default;
+            ~DxcRef() { reset(); }
+
+            DxcRef(const DxcRef&) = delete;
+            DxcRef& operator=(const DxcRef&) = delete;
+
+            T* get() const { return m_Pointer; }
+            T* operator->() const { return m_Pointer; }
+            explicit operator bool() const { return m_Pointer != nullptr; }
+
+            void reset()
+            {
+                if (m_Pointer)
+                    m_Pointer->Release();
+
+                m_Pointer = nullptr;
+            }
+
+            T** put()
+            {
+                reset();
+                return &m_Pointer;
+            }
+        private:
+            T* m_Pointer = nullptr;
+        };
+
+        struct DXCContext
+        {
+            DxcRef<IDxcUtils> Utilities;
+            DxcRef<IDxcCompiler3> Compiler;
+            DxcRef<IDxcIncludeHandler> IncludeHandler;
+        };
+
+        static DXCContext* GetThreadDXCContext()
+        {
+            // like shaderc, dxc compilers are not thread safe
+            thread_local DXCContext context;
+            thread_local bool initialized = false;
+
+            if (!initialized)
+            {
+                initialized = true;
+
+                if (FAILED(DxcCreateInstance(CLSID_DxcUtils, IID_PPV_ARGS(context.Utilities.put())))
+                    || FAILED(DxcCreateInstance(CLSID_DxcCompiler, IID_PPV_ARGS(context.Compiler.put())))
+                    || FAILED(context.Utilities->CreateDefaultIncludeHandler(context.IncludeHandler.put())))
+                {
+                    context.Compiler.reset();
+                }
+            }
+
+            return context.Compiler ? &context : nullptr;
+        }
+
+        // dxc walks the include directories itself and asks for each candidate path, only the ones that load are dependencies
+        class DXCShaderIncluder : public IDxcIncludeHandler
+        {
+        public:
+            DXCShaderIncluder(IDxcIncludeHandler* defaultHandler, std::vector<std::filesystem::path>& dependencies)
+                : m_DefaultHandler(defaultHandler), m_Dependencies(dependencies)
+            {
+            }
+
+            virtual HRESULT STDMETHODCALLTYPE LoadSource(LPCWSTR filename, IDxcBlob** includeSource) override
+            {
+                HRESULT result = m_DefaultHandler->LoadSource(filename, includeSource);
+
+                if (SUCCEEDED(result))
+                {
+                    std::filesystem::path resolved = std::filesystem::path(filename).lexically_normal();
+
+                    if (std::find(m_Dependencies.begin(), m_Dependencies.end(), resolved) == m_Dependencies.end())
+                        m_Dependencies.push_back(resolved);
+                }
+
+                return result;
+            }
+
+            // only lives for a single Compile call on the stack, so it is not reference counted
+            virtual HRESULT STDMETHODCALLTYPE QueryInterface(REFIID riid, void** object) override { return m_DefaultHandler->QueryInterface(riid, object); }
+            virtual ULONG STDMETHODCALLTYPE AddRef() override { return 1; }
+            virtual ULONG STDMETHODCALLTYPE Release() override { return 1; }
+        private:
+            IDxcIncludeHandler* m_DefaultHandler;
+            std::vector<std::filesystem::path>& m_Dependencies;
+        };
+
+        static bool CompileWithShaderc(const std::string& source, const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, ShaderConfiguration config, const ShaderCompileOptions& compileOptions, const std::vector<ShaderMacro>& defines, ShaderCompilationResult& comp)
+        {
+            shaderc::Compiler& compiler = GetThreadCompiler();
+            shaderc::CompileOptions options;
+
+            SetCompileOptions(options, config);
+            options.SetIncluder(std::make_unique<ShaderIncluder>(compileOptions.IncludeDirectories, comp.Dependencies));
+
+            for (const auto& define : defines)
+                options.AddMacroDefinition(define.Name, define.Value);
+
+            shaderc::SpvCompilationResult result = compiler.CompileGlslToSpv(source, ConvertShaderType(type), path.string().c_str(), entryPoint.c_str(), options);
+
+            if (result.GetCompilationStatus() != shaderc_compilation_status_success)
+            {
+                comp.ErrorMessage = result.GetErrorMessage();
+                return false;
+            }
+
+            const uint8_t* begin = reinterpret_cast<const uint8_t*>(result.cbegin());
+            const uint8_t* end = reinterpret_cast<const uint8_t*>(result.cend());
+
+            comp.Bytecode = { begin, end };
+            return true;
+        }
+
+        static bool CompileWithDXC(const std::string& source, const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, ShaderConfiguration config, const ShaderCompileOptions& compileOptions, const std::vector<ShaderMacro>& defines, ShaderCompilationResult& comp)
+        {
+            DXCContext* context = GetThreadDXCContext();
+            if (!context)
+            {
+                comp.ErrorMessage = "Failed to create the DXC compiler, is dxcompiler installed?";
+                return false;
+            }
+
+            std::vector<std::wstring> arguments = GetDXCArguments(path, type, entryPoint, config, compileOptions, defines);
+
+            std::vector<LPCWSTR> argumentPointers;
+            argumentPointers.reserve(arguments.size());
+            for (const auto& argument : arguments)
+                argumentPointers.push_back(argument.c_str());
+
+            DxcBuffer buffer{
+                .Ptr = source.data(),
+                .Size = source.size(),
+                .Encoding = DXC_CP_UTF8
+            };
+
+            DXCShaderIncluder includer(context->IncludeHandler.get(), comp.Dependencies);
+
+            DxcRef<IDxcResult> result;
+            HRESULT status = context->Compiler->Compile(&buffer, argumentPointers.data(), static_cast<UINT32>(argumentPointers.size()), &includer, IID_PPV_ARGS(result.put()));
+
+            if (SUCCEEDED(status))
+                result->GetStatus(&status);
+
+            if (FAILED(status))
+            {
+                DxcRef<IDxcBlobUtf8> errors;
+                if (result && SUCCEEDED(result->GetOutput(DXC_OUT_ERRORS, IID_PPV_ARGS(errors.put()), nullptr)) && errors && errors->GetStringLength() > 0)
+                    comp.ErrorMessage = std::string(errors->GetStringPointer(), errors->GetStringLength());
+                else
+                    comp.ErrorMessage = "DXC failed to compile " + path.string();
+
+                return false;
+            }
+
+            DxcRef<IDxcBlob> object;
+            if (FAILED(result->GetOutput(DXC_OUT_OBJECT, IID_PPV_ARGS(object.put()), nullptr)) || !object)
+            {
+                comp.ErrorMessage = "DXC produced no bytecode for " + path.string();
+                return false;
+            }
+
+            const uint8_t* begin = static_cast<const uint8_t*>(object->GetBufferPointer());
+            comp.Bytecode = { begin, begin + object->GetBufferSize() };
+
+            return true;
+        }
+
+    }
+
+    ShaderCompilationResult ShaderCompiler::compileHLSLToSpirv(const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, ShaderFrontend frontend)
+    {
+        std::string shader;
+        if (!Utils::ReadShaderSource(path, shader))
         {
+            return ShaderCompilationResult{
+                .Success = false,
+                .ErrorMessage = "Failed to open file " + path.string()
+            };
+        }
+
+        return compileHLSLSourceToSpirv(shader, path, type, entryPoint, {}, {}, frontend);
+    }
+
+    ShaderCompilationResult ShaderCompiler::compileHLSLSourceToSpirv(const std::string& source, const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, const ShaderCompileOptions& compileOptions, const std::vector<ShaderMacro>& defines, ShaderFrontend frontend)
+    {
+        ShaderCompilationResult comp;
+
+        ShaderConfiguration config = getConfiguration(compileOptions);
+        ShaderOptimizationOptions optimization = getOptimizationOptions(config, compileOptions);
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        bool compiled = frontend == ShaderFrontend::DXC
+            ? Utils::CompileWithDXC(source, path, type, entryPoint, config, compileOptions, defines, comp)
+            : Utils::CompileWithShaderc(source, path, type, entryPoint, config, compileOptions, defines, comp);
+
+        if (!compiled)
+        {
+            comp.CompileTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
             comp.Success = false;
-            comp.ErrorMessage = result.GetErrorMessage();
 
             return comp;
         }
 
-        const uint8_t* begin = reinterpret_cast<const uint8_t*>(result.cbegin());
-        const uint8_t* end = reinterpret_cast<const uint8_t*>(result.cend());
-
-        comp.Bytecode = { begin, end };
         comp.EntryPoint = entryPoint;
         comp.Success = true;
-        
+
+        std::string optimizationError;
+        if (!optimizeSpirv(comp.Bytecode, optimization, &comp.OptimizationSteps, &optimizationError))
+            WR_WARN("Failed to optimize {} shader {}, keeping unoptimized bytecode\n{}", Utils::ShaderTypeToString(type), path.filename().string(), optimizationError);
+
+        comp.CompileTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        // reflect the final bytecode, dead code elimination can drop unused resources
+        Utils::ReflectSpirv(comp.Bytecode, type, comp.Reflection);
+
         return comp;
     }
 
+    bool ShaderCompiler::optimizeSpirv(std::vector<uint8_t>& bytecode, const ShaderOptimizationOptions& optimization, std::vector<ShaderOptimizationStep>* outSteps, std::string* outError)
+    {
+        using PassRegistration = std::function<void(spvtools::Optimizer&)>;
+
+        std::vector<std::pair<const char*, PassRegistration>> steps;
+
+        if (optimization.InlineFunctions)
+        {
+            steps.emplace_back("inline", [](spvtools::Optimizer& optimizer)
+            {
+                optimizer.RegisterPass(spvtools::CreateMergeReturnPass());
+                optimizer.RegisterPass(spvtools::CreateInlineExhaustivePass());
+                optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+            });
+        }
+
+        if (optimization.EliminateDeadCode)
+        {
+            steps.emplace_back("dce", [](spvtools::Optimizer& optimizer)
+            {
+                optimizer.RegisterPass(spvtools::CreateDeadBranchElimPass());
+                optimizer.RegisterPass(spvtools::CreateAggressiveDCEPass());
+                optimizer.RegisterPass(spvtools::CreateCFGCleanupPass());
+                optimizer.RegisterPass(spvtools::CreateEliminateDeadFunctionsPass());
+                optimizer.RegisterPass(spvtools::CreateEliminateDeadConstantPass());
+            });
+        }
+
+        if (optimization.Preset == ShaderOptimizationPreset::Size)
+            steps.emplace_back("size", [](spvtools::Optimizer& optimizer) { optimizer.RegisterSizePasses(); });
+        else if (optimization.Preset == ShaderOptimizationPreset::Performance)
+            steps.emplace_back("performance", [](spvtools::Optimizer& optimizer) { optimizer.RegisterPerformancePasses(); });
+
+        // stripped last, the other passes keep names intact
+        if (optimization.StripDebugInfo)
+        {
+            steps.emplace_back("strip", [](spvtools::Optimizer& optimizer)
+            {
+                optimizer.RegisterPass(spvtools::CreateStripDebugInfoPass());
+                optimizer.RegisterPass(spvtools::CreateStripNonSemanticInfoPass());
+            });
+        }
+
+        if (steps.empty())
+            return true;
+
+        std::vector<uint32_t> words(bytecode.size() / sizeof(uint32_t));
+        std::memcpy(words.data(), bytecode.data(), words.size() * sizeof(uint32_t));
+
+        std::string errors;
+
+        for (const auto& [name, registerPasses] : steps)
+        {
+            auto start = std::chrono::high_resolution_clock::now();
+
+            spvtools::Optimizer optimizer(SPV_ENV_VULKAN_1_2);
+            optimizer.SetMessageConsumer([&errors](spv_message_level_t level, const char*, const spv_position_t&, const char* message)
+            {
+                if (level <= SPV_MSG_ERROR)
+                {
+                    errors += message;
+                    errors += '\n';
+                }
+            });
+
+            registerPasses(optimizer);
+
+            std::vector<uint32_t> optimized;
+            if (!optimizer.Run(words.data(), words.size(), &optimized))
+            {
+                if (outError)
+                    *outError = std::string(name) + ": " + errors;
+
+                return false;
+            }
+
+            if (outSteps)
+            {
+                outSteps->push_back(ShaderOptimizationStep{
+                    .Name = name,
+                    .SizeBefore = words.size() * sizeof(uint32_t),
+                    .SizeAfter = optimized.size() * sizeof(uint32_t),
+                    .Time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count()
+                });
+            }
+
+            words = std::move(optimized);
+        }
+
+        bytecode.resize(words.size() * sizeof(uint32_t));
+        std::memcpy(bytecode.data(), words.data(), bytecode.size());
+
+        return true;
+    }
+
     ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::filesystem::path& path, const std::string& vertexEntryPoint, const std::string& pixelEntryPoint)
     {
         return createShaderCacheHLSL(path, vertexEntryPoint, pixelEntryPoint, { RendererAPI::Vulkan });
@@ -116,132 +661,450 @@ namespace wire {
     {
         WR_ASSERT(paths.size() == vertexEntryPoints.size() && paths.size() == pixelEntryPoints.size(), "ShaderCache must have same number of vertex and pixel shaders!");
 
-        std::vector<ShaderGroup> groups;
+        std::vector<ShaderInfo> shaderInfos;
+        shaderInfos.reserve(paths.size());
 
         for (uint32_t i = 0; i < paths.size(); i++)
         {
-            std::filesystem::path path = paths[i];
-            std::string vertexEntryPoint = vertexEntryPoints[i];
-            std::string pixelEntryPoint = pixelEntryPoints[i];
+            shaderInfos.push_back(ShaderInfo{
+                .Path = paths[i],
+                .IsGraphics = true,
+                .VertexOrComputeEntryPoint = vertexEntryPoints[i],
+                .PixelEntryPoint = pixelEntryPoints[i]
+            });
+        }
 
-            std::ifstream file(path);
-            std::stringstream ss;
-            ss << file.rdbuf();
+        return createShaderCacheHLSL(shaderInfos, ShaderCompileOptions{}, apis);
+    }
 
-            std::string fileString = ss.str();
-            file.close();
+    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::filesystem::path& path, const std::string& computeEntryPoint)
+    {
+        return createShaderCacheHLSL(path, computeEntryPoint, { RendererAPI::Vulkan });
+    }
 
-            std::array<uint32_t, 8> sha256 = generateSHA256(fileString);
+    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::filesystem::path& path, const std::string& computeEntryPoint, const std::vector<RendererAPI>& apis)
+    {
+        return createShaderCacheHLSL(std::vector<std::filesystem::path>{ path }, std::vector<std::string>{ computeEntryPoint }, apis);
+    }
 
-            constexpr ShaderConfiguration currentConfig =
-#ifdef WR_DEBUG
-                ShaderConfiguration::Debug;
-#else
-                ShaderConfiguration::Release;
-#endif
+    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& computeEntryPoints)
+    {
+        return createShaderCacheHLSL(paths, computeEntryPoints, { RendererAPI::Vulkan });
+    }
+
+    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& computeEntryPoints, const std::vector<RendererAPI>& apis)
+    {
+        WR_ASSERT(paths.size() == computeEntryPoints.size(), "must have same number of paths as compute entry points");
+
+        std::vector<ShaderInfo> shaderInfos;
+        shaderInfos.reserve(paths.size());
+
+        for (uint32_t i = 0; i < paths.size(); i++)
+        {
+            shaderInfos.push_back(ShaderInfo{
+                .Path = paths[i],
+                .IsGraphics = false,
+                .VertexOrComputeEntryPoint = computeEntryPoints[i]
+            });
+        }
+
+        return createShaderCacheHLSL(shaderInfos, ShaderCompileOptions{}, apis);
+    }
+
+    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::vector<ShaderInfo>& shaderInfos, const ShaderCompileOptions& options, const std::vector<RendererAPI>& apis, std::vector<ShaderCompilationTiming>* outTimings)
+    {
+        struct CompileJob
+        {
+            uint32_t GroupIndex;
+            uint32_t InfoIndex;
+            ShaderType Type;
+            const std::string* EntryPoint;
+
+            ShaderCompilationResult Result;
+        };
+
+        ShaderConfiguration currentConfig = getConfiguration(options);
+        ShaderOptimizationOptions optimization = getOptimizationOptions(currentConfig, options);
+
+        bool compileVulkan = std::find(apis.begin(), apis.end(), RendererAPI::Vulkan) != apis.end();
+
+        // every variant of a shader shares the source and its hashes, only the defines differ
+        std::vector<ShaderGroup> sourceGroups(shaderInfos.size());
+        std::vector<std::string> sources(shaderInfos.size());
+        std::vector<uint8_t> sourceValid(shaderInfos.size());
+
+        std::vector<ShaderGroup> groups;
+        std::vector<uint32_t> groupInfoIndices;
+        std::vector<CompileJob> jobs;
+
+        for (uint32_t i = 0; i < shaderInfos.size(); i++)
+        {
+            const ShaderInfo& info = shaderInfos[i];
+
+            for (uint32_t variantKey : getRequestedVariants(info))
+            {
+                uint32_t groupIndex = static_cast<uint32_t>(groups.size());
+
+                ShaderGroup& group = groups.emplace_back();
+                group.VariantKey = variantKey;
+                group.VariantAxes = info.VariantAxes;
+                group.Defines = getVariantDefines(info.VariantAxes, variantKey);
+                groupInfoIndices.push_back(i);
+
+                if (!compileVulkan)
+                    continue;
+
+                if (info.IsGraphics)
+                {
+                    jobs.push_back(CompileJob{ .GroupIndex = groupIndex, .InfoIndex = i, .Type = ShaderType::Vertex, .EntryPoint = &info.VertexOrComputeEntryPoint });
+                    jobs.push_back(CompileJob{ .GroupIndex = groupIndex, .InfoIndex = i, .Type = ShaderType::Pixel, .EntryPoint = &info.PixelEntryPoint });
+                }
+                else
+                {
+                    jobs.push_back(CompileJob{ .GroupIndex = groupIndex, .InfoIndex = i, .Type = ShaderType::Compute, .EntryPoint = &info.VertexOrComputeEntryPoint });
+                }
+            }
+        }
+
+        auto readSource = [&](uint32_t i)
+        {
+            const ShaderInfo& info = shaderInfos[i];
+            ShaderGroup& group = sourceGroups[i];
+
+            ShaderSourceStat stat;
+            getSourceStat(info.Path, stat);
+
+            sourceValid[i] = Utils::ReadShaderSource(info.Path, sources[i]);
+
+            std::array<uint32_t, 8> sha256 = generateSHA256(sources[i]);
 
-            ShaderGroup group;
-            group.Name = path.filename().string();
+            group.Name = info.Path.filename().string();
+            group.SourcePath = info.Path.generic_string();
             group.Config = currentConfig;
+            group.OptionsHash = getOptionsHash(currentConfig, optimization, options.IncludeDirectories, info.Frontend);
+            group.SourceWriteTime = stat.WriteTime;
+            group.SourceSize = stat.Size;
 
             std::memcpy(group.SHA256, sha256.data(), sizeof(uint32_t) * 8);
+        };
+
+        auto compileJob = [&](uint32_t i)
+        {
+            CompileJob& job = jobs[i];
+            const ShaderInfo& info = shaderInfos[job.InfoIndex];
+
+            if (!sourceValid[job.InfoIndex])
+            {
+                job.Result.Success = false;
+                job.Result.ErrorMessage = "Failed to open file " + info.Path.string();
+                return;
+            }
+
+            job.Result = compileHLSLSourceToSpirv(sources[job.InfoIndex], info.Path, job.Type, *job.EntryPoint, options, groups[job.GroupIndex].Defines, info.Frontend);
+        };
+
+        auto start = std::chrono::high_resolution_clock::now();
+        uint32_t threadCount = 1;
+
+        if (!options.Parallel || options.ThreadCount == 1)
+        {
+            for (uint32_t i = 0; i < shaderInfos.size(); i++)
+                readSource(i);
+            for (uint32_t i = 0; i < jobs.size(); i++)
+                compileJob(i);
+        }
+        else if (options.ThreadCount == 0)
+        {
+            ThreadPool& pool = ThreadPool::shared();
+            threadCount = pool.getThreadCount() + 1;
+
+            pool.parallelFor(static_cast<uint32_t>(shaderInfos.size()), readSource);
+            pool.parallelFor(static_cast<uint32_t>(jobs.size()), compileJob);
+        }
+        else
+        {
+            // the calling thread takes part in parallelFor, so one less worker is needed
+            ThreadPool pool(options.ThreadCount - 1);
+            threadCount = options.ThreadCount;
+
+            pool.parallelFor(static_cast<uint32_t>(shaderInfos.size()), readSource);
+            pool.parallelFor(static_cast<uint32_t>(jobs.size()), compileJob);
+        }
+
+        double totalTime = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+
+        for (uint32_t i = 0; i < groups.size(); i++)
+        {
+            const ShaderGroup& source = sourceGroups[groupInfoIndices[i]];
+            ShaderGroup& group = groups[i];
+
+            group.Name = source.Name;
+            group.SourcePath = source.SourcePath;
+            group.Config = source.Config;
+            group.OptionsHash = source.OptionsHash;
+            group.SourceWriteTime = source.SourceWriteTime;
+            group.SourceSize = source.SourceSize;
+
+            std::memcpy(group.SHA256, source.SHA256, sizeof(uint32_t) * 8);
+        }
+
+        if (outTimings)
+            outTimings->reserve(outTimings->size() + jobs.size());
+
+        size_t unoptimizedSize = 0;
+        size_t optimizedSize = 0;
+
+        for (auto& job : jobs)
+        {
+            ShaderGroup& group = groups[job.GroupIndex];
+
+            WR_ASSERT_OR_ERROR(job.Result.Success, "failed to compile Vulkan {} shader {} (variant {})\nerror message:\n{}", Utils::ShaderTypeToString(job.Type), group.Name, group.VariantKey, job.Result.ErrorMessage);
+            WR_INFO("Compiled {} shader {} (variant {}) in {:.2f} ms", Utils::ShaderTypeToString(job.Type), group.Name, group.VariantKey, job.Result.CompileTime);
+
+            if (outTimings)
+            {
+                outTimings->push_back(ShaderCompilationTiming{
+                    .Name = group.Name,
+                    .Type = job.Type,
+                    .CompileTime = job.Result.CompileTime,
+                    .OptimizationSteps = job.Result.OptimizationSteps
+                });
+            }
+
+            optimizedSize += job.Result.Bytecode.size();
+            unoptimizedSize += job.Result.OptimizationSteps.empty() ? job.Result.Bytecode.size() : job.Result.OptimizationSteps.front().SizeBefore;
+
+            ShaderObject object;
+            object.API = RendererAPI::Vulkan;
+            object.Type = job.Type;
+            object.EntryPoint = *job.EntryPoint;
+            if (!job.Result.Bytecode.empty())
+                object.Blob = ShaderBlob::create(std::move(job.Result.Bytecode));
+            object.Reflection = std::move(job.Result.Reflection);
+
+            group.Objects.push_back(std::move(object));
+        }
+
+        if (!jobs.empty())
+        {
+            WR_INFO("Compiled {} shaders in {:.2f} ms ({} threads)", jobs.size(), totalTime, threadCount);
 
-            if (std::find(apis.begin(), apis.end(), RendererAPI::Vulkan) != apis.end())
+            if (unoptimizedSize != optimizedSize)
+                WR_INFO("Optimized shader bytecode from {} to {} bytes", unoptimizedSize, optimizedSize);
+        }
+
+        // shared headers are usually included by many shaders, only hash each of them once
+        std::unordered_map<std::string, ShaderDependency> dependencyCache;
+
+        for (auto& job : jobs)
+        {
+            ShaderGroup& group = groups[job.GroupIndex];
+
+            for (const auto& path : job.Result.Dependencies)
             {
-                ShaderCompilationResult vkVShader = compileHLSLToSpirv(path, ShaderType::Vertex, vertexEntryPoint);
-                WR_ASSERT(vkVShader.Success, "failed to compile Vulkan vertex shader\nerror message:\n{}", vkVShader.ErrorMessage);
+                std::string pathString = path.generic_string();
+
+                auto existing = std::find_if(group.Dependencies.begin(), group.Dependencies.end(), [&pathString](const ShaderDependency& dependency) { return dependency.Path == pathString; });
+                if (existing != group.Dependencies.end())
+                    continue;
+
+                auto it = dependencyCache.find(pathString);
+                if (it == dependencyCache.end())
+                {
+                    ShaderDependency dependency;
+                    dependency.Path = pathString;
 
-                ShaderObject vkVertex;
-                vkVertex.API = RendererAPI::Vulkan;
-                vkVertex.Type = ShaderType::Vertex;
-                vkVertex.EntryPoint = vertexEntryPoint;
-                vkVertex.Bytecode = vkVShader.Bytecode;
+                    ShaderSourceStat stat;
+                    getSourceStat(path, stat);
+                    dependency.WriteTime = stat.WriteTime;
+                    dependency.Size = stat.Size;
 
-                ShaderCompilationResult vkPShader = compileHLSLToSpirv(path, ShaderType::Pixel, pixelEntryPoint);
-                WR_ASSERT(vkPShader.Success, "failed to compile Vulkan pixel shader\nerror message:\n{}", vkPShader.ErrorMessage);
+                    std::array<uint32_t, 8> sha256{};
+                    getSourceHash(path, sha256);
+                    std::memcpy(dependency.SHA256, sha256.data(), sizeof(uint32_t) * 8);
 
-                ShaderObject vkPixel;
-                vkPixel.API = RendererAPI::Vulkan;
-                vkPixel.Type = ShaderType::Pixel;
-                vkPixel.EntryPoint = pixelEntryPoint;
-                vkPixel.Bytecode = vkPShader.Bytecode;
+                    it = dependencyCache.emplace(pathString, dependency).first;
+                }
 
-                group.Objects.push_back(vkVertex);
-                group.Objects.push_back(vkPixel);
+                group.Dependencies.push_back(it->second);
             }
+        }
+
+        for (auto& group : groups)
+        {
+            std::sort(group.Dependencies.begin(), group.Dependencies.end(), [](const ShaderDependency& lhs, const ShaderDependency& rhs) { return lhs.Path < rhs.Path; });
 
-            groups.push_back(group);
+            std::array<uint32_t, 8> dependencyHash = combineDependencyHashes(group.SHA256, group.Dependencies);
+            std::memcpy(group.DependencyHash, dependencyHash.data(), sizeof(uint32_t) * 8);
         }
 
-        return ShaderCache(groups);
+        return ShaderCache(std::move(groups), currentConfig);
     }
 
-    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::filesystem::path& path, const std::string& computeEntryPoint)
+    uint32_t ShaderCompiler::getVariantCount(const std::vector<ShaderVariantAxis>& axes)
     {
-        return createShaderCacheHLSL(path, computeEntryPoint, { RendererAPI::Vulkan });
+        uint32_t count = 1;
+        for (const auto& axis : axes)
+            count *= axis.Values.empty() ? 2 : static_cast<uint32_t>(axis.Values.size());
+
+        return count;
     }
 
-    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::filesystem::path& path, const std::string& computeEntryPoint, const std::vector<RendererAPI>& apis)
+    std::vector<uint32_t> ShaderCompiler::getRequestedVariants(const ShaderInfo& info)
     {
-        return createShaderCacheHLSL(std::vector<std::filesystem::path>{ path }, std::vector<std::string>{ computeEntryPoint }, apis);
+        uint32_t variantCount = getVariantCount(info.VariantAxes);
+
+        std::vector<uint32_t> variants;
+        if (info.Variants.empty())
+        {
+            variants.resize(variantCount);
+            for (uint32_t i = 0; i < variantCount; i++)
+                variants[i] = i;
+
+            return variants;
+        }
+
+        for (uint32_t variantKey : info.Variants)
+        {
+            if (variantKey >= variantCount)
+            {
+                WR_ASSERT_OR_WARN(false, "Variant {} of shader {} is out of range ({} permutations)", variantKey, info.Path.string(), variantCount);
+                continue;
+            }
+
+            if (std::find(variants.begin(), variants.end(), variantKey) == variants.end())
+                variants.push_back(variantKey);
+        }
+
+        return variants;
     }
 
-    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& computeEntryPoints)
+    std::vector<ShaderMacro> ShaderCompiler::getVariantDefines(const std::vector<ShaderVariantAxis>& axes, uint32_t variantKey)
     {
-        return createShaderCacheHLSL(paths, computeEntryPoints, { RendererAPI::Vulkan });
+        std::vector<ShaderMacro> defines;
+        defines.reserve(axes.size());
+
+        for (const auto& axis : axes)
+        {
+            uint32_t radix = axis.Values.empty() ? 2 : static_cast<uint32_t>(axis.Values.size());
+            uint32_t valueIndex = variantKey % radix;
+            variantKey /= radix;
+
+            if (axis.Values.empty())
+            {
+                if (valueIndex == 1)
+                    defines.push_back(ShaderMacro{ .Name = axis.Macro, .Value = "1" });
+            }
+            else
+            {
+                defines.push_back(ShaderMacro{ .Name = axis.Macro, .Value = axis.Values[valueIndex] });
+            }
+        }
+
+        return defines;
     }
 
-    ShaderCache ShaderCompiler::createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& computeEntryPoints, const std::vector<RendererAPI>& apis)
+    uint64_t ShaderCompiler::getOptionsHash(ShaderConfiguration config, const ShaderOptimizationOptions& optimization, const std::vector<std::filesystem::path>& includeDirectories, ShaderFrontend frontend)
     {
-        WR_ASSERT(paths.size() == computeEntryPoints.size(), "must have same number of paths as compute entry points");
+        std::array<uint32_t, 8> sha256 = generateSHA256(Utils::GetCompileOptionsDescription(config, optimization, includeDirectories, frontend));
+        return (static_cast<uint64_t>(sha256[0]) << 32) | sha256[1];
+    }
 
-        std::vector<ShaderGroup> groups;
+    ShaderOptimizationOptions ShaderCompiler::getOptimizationOptions(ShaderConfiguration config, const ShaderCompileOptions& options)
+    {
+        if (options.Optimization)
+            return *options.Optimization;
 
-        for (uint32_t i = 0; i < paths.size(); i++)
+        // debug caches stay readable in graphics debuggers
+        if (config == ShaderConfiguration::Debug)
+            return ShaderOptimizationOptions{};
+
+        return ShaderOptimizationOptions{
+            .Preset = ShaderOptimizationPreset::Performance,
+            .InlineFunctions = false,
+            .EliminateDeadCode = false,
+            .StripDebugInfo = true
+        };
+    }
+
+    ShaderConfiguration ShaderCompiler::getConfiguration(const ShaderCompileOptions& options)
+    {
+        return options.Configuration.value_or(Utils::GetCurrentConfiguration());
+    }
+
+    std::vector<ShaderInfo> ShaderCompiler::findShaders(const std::filesystem::path& directory)
+    {
+        std::vector<ShaderInfo> shaderInfos;
+
+        std::error_code ec;
+        for (const auto& entry : std::filesystem::directory_iterator(directory, ec))
         {
-            std::filesystem::path path = paths[i];
-            std::string entryPoint = computeEntryPoints[i];
+            const std::filesystem::path& path = entry.path();
+            if (!path.has_extension() || path.extension() != ".hlsl")
+                continue;
 
-            std::ifstream file(path);
-            std::stringstream ss;
-            ss << file.rdbuf();
+            if (path.string().ends_with(".compute.hlsl"))
+            {
+                shaderInfos.push_back(ShaderInfo{
+                    .Path = path,
+                    .IsGraphics = false,
+                    .VertexOrComputeEntryPoint = "CShader"
+                });
 
-            std::string fileString = ss.str();
-            file.close();
+                continue;
+            }
 
-            std::array<uint32_t, 8> sha256 = generateSHA256(fileString);
+            shaderInfos.push_back(ShaderInfo{
+                .Path = path,
+                .IsGraphics = true,
+                .VertexOrComputeEntryPoint = "VShader",
+                .PixelEntryPoint = "PShader"
+            });
+        }
 
-            constexpr ShaderConfiguration currentConfig =
-#ifdef WR_DEBUG
-                ShaderConfiguration::Debug;
-#else
-                ShaderConfiguration::Release;
-#endif
+        // directory order is unspecified, keep the cache layout stable between runs
+        std::sort(shaderInfos.begin(), shaderInfos.end(), [](const ShaderInfo& lhs, const ShaderInfo& rhs) { return lhs.Path < rhs.Path; });
 
-            ShaderGroup group;
-            group.Name = path.filename().string();
-            group.Config = currentConfig;
+        return shaderInfos;
+    }
 
-            std::memcpy(group.SHA256, sha256.data(), sizeof(uint32_t) * 8);
+    bool ShaderCompiler::getSourceStat(const std::filesystem::path& path, ShaderSourceStat& outStat)
+    {
+        std::error_code ec;
 
-            if (std::find(apis.begin(), apis.end(), RendererAPI::Vulkan) != apis.end())
-            {
-                ShaderCompilationResult vkCShader = compileHLSLToSpirv(path, ShaderType::Compute, entryPoint);
-                WR_ASSERT(vkCShader.Success, "failed to compile Vulkan compute shader\nerror message:\n{}", vkCShader.ErrorMessage);
+        auto writeTime = std::filesystem::last_write_time(path, ec);
+        if (ec)
+            return false;
 
-                ShaderObject vkCompute;
-                vkCompute.API = RendererAPI::Vulkan;
-                vkCompute.Type = ShaderType::Compute;
-                vkCompute.EntryPoint = vkCShader.EntryPoint;
-                vkCompute.Bytecode = vkCShader.Bytecode;
+        auto size = std::filesystem::file_size(path, ec);
+        if (ec)
+            return false;
 
-                group.Objects.push_back(vkCompute);
-            }
+        outStat.WriteTime = static_cast<int64_t>(writeTime.time_since_epoch().count());
+        outStat.Size = static_cast<uint64_t>(size);
 
-            groups.push_back(group);
-        }
+        return true;
+    }
+
+    bool ShaderCompiler::getSourceHash(const std::filesystem::path& path, std::array<uint32_t, 8>& outHash)
+    {
+        std::string source;
+        if (!Utils::ReadShaderSource(path, source))
+            return false;
+
+        outHash = generateSHA256(source);
+        return true;
+    }
+
+    std::array<uint32_t, 8> ShaderCompiler::combineDependencyHashes(const uint32_t sourceHash[8], const std::vector<ShaderDependency>& dependencies)
+    {
+        std::vector<uint8_t> data(sizeof(uint32_t) * 8 * (dependencies.size() + 1));
+
+        std::memcpy(data.data(), sourceHash, sizeof(uint32_t) * 8);
+        for (size_t i = 0; i < dependencies.size(); i++)
+            std::memcpy(data.data() + sizeof(uint32_t) * 8 * (i + 1), dependencies[i].SHA256, sizeof(uint32_t) * 8);
 
-        return ShaderCache(groups);
+        return generateSHA256(data);
     }
 
 }
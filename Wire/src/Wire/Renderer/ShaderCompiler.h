@@ -1,5 +1,6 @@
 #pragma once
 
+#include <array>
 #include <vector>
 #include <string>
 #include <filesystem>
@@ -8,6 +9,14 @@
 
 namespace wire {
 
+    struct ShaderOptimizationStep
+    {
+        std::string Name;
+        size_t SizeBefore; // bytes
+        size_t SizeAfter;  // bytes
+        double Time;       // milliseconds
+    };
+
     struct ShaderCompilationResult
     {
         bool Success;
@@ -15,12 +24,35 @@ namespace wire {
 
         std::vector<uint8_t> Bytecode;
         std::string EntryPoint;
+        std::vector<std::filesystem::path> Dependencies;
+        ShaderReflection Reflection;
+
+        double CompileTime = 0.0; // milliseconds, including optimization
+        std::vector<ShaderOptimizationStep> OptimizationSteps;
+    };
+
+    struct ShaderCompilationTiming
+    {
+        std::string Name;
+        ShaderType Type;
+        double CompileTime; // milliseconds
+        std::vector<ShaderOptimizationStep> OptimizationSteps;
+    };
+
+    struct ShaderSourceStat
+    {
+        int64_t WriteTime = 0;
+        uint64_t Size = 0;
     };
 
     class ShaderCompiler
     {
     public:
-        static ShaderCompilationResult compileHLSLToSpirv(const std::filesystem::path& path, ShaderType type, const std::string& entryPoint);
+        static ShaderCompilationResult compileHLSLToSpirv(const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, ShaderFrontend frontend = ShaderFrontend::Shaderc);
+        static ShaderCompilationResult compileHLSLSourceToSpirv(const std::string& source, const std::filesystem::path& path, ShaderType type, const std::string& entryPoint, const ShaderCompileOptions& options = {}, const std::vector<ShaderMacro>& defines = {}, ShaderFrontend frontend = ShaderFrontend::Shaderc);
+        // runs each enabled step separately so its effect on the size can be recorded, the bytecode is left untouched on failure
+        static bool optimizeSpirv(std::vector<uint8_t>& bytecode, const ShaderOptimizationOptions& optimization, std::vector<ShaderOptimizationStep>* outSteps = nullptr, std::string* outError = nullptr);
+
         static ShaderCache createShaderCacheHLSL(const std::filesystem::path& path, const std::string& vertexEntryPoint, const std::string& pixelEntryPoint);
         static ShaderCache createShaderCacheHLSL(const std::filesystem::path& path, const std::string& vertexEntryPoint, const std::string& pixelEntryPoint, const std::vector<RendererAPI>& apis);
         static ShaderCache createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& vertexEntryPoints, const std::vector<std::string>& pixelEntryPoints);
@@ -30,6 +62,24 @@ namespace wire {
         static ShaderCache createShaderCacheHLSL(const std::filesystem::path& path, const std::string& computeEntryPoint, const std::vector<RendererAPI>& apis);
         static ShaderCache createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& computeEntryPoints);
         static ShaderCache createShaderCacheHLSL(const std::vector<std::filesystem::path>& paths, const std::vector<std::string>& computeEntryPoints, const std::vector<RendererAPI>& apis);
+
+        // groups are returned in the order of shaderInfos, then of their variants, regardless of how the work was scheduled
+        static ShaderCache createShaderCacheHLSL(const std::vector<ShaderInfo>& shaderInfos, const ShaderCompileOptions& options, const std::vector<RendererAPI>& apis = { RendererAPI::Vulkan }, std::vector<ShaderCompilationTiming>* outTimings = nullptr);
+
+        // hash of every compiler setting that affects the generated bytecode
+        static uint64_t getOptionsHash(ShaderConfiguration config, const ShaderOptimizationOptions& optimization, const std::vector<std::filesystem::path>& includeDirectories, ShaderFrontend frontend = ShaderFrontend::Shaderc);
+        static ShaderOptimizationOptions getOptimizationOptions(ShaderConfiguration config, const ShaderCompileOptions& options);
+        static ShaderConfiguration getConfiguration(const ShaderCompileOptions& options);
+
+        // *.compute.hlsl files are compute shaders with a CShader entry point, other *.hlsl files use VShader and PShader
+        static std::vector<ShaderInfo> findShaders(const std::filesystem::path& directory);
+        static bool getSourceStat(const std::filesystem::path& path, ShaderSourceStat& outStat);
+        static bool getSourceHash(const std::filesystem::path& path, std::array<uint32_t, 8>& outHash);
+        static std::array<uint32_t, 8> combineDependencyHashes(const uint32_t sourceHash[8], const std::vector<ShaderDependency>& dependencies);
+
+        static uint32_t getVariantCount(const std::vector<ShaderVariantAxis>& axes);
+        static std::vector<uint32_t> getRequestedVariants(const ShaderInfo& info);
+        static std::vector<ShaderMacro> getVariantDefines(const std::vector<ShaderVariantAxis>& axes, uint32_t variantKey);
     };
 
 }
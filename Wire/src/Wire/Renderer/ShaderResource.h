@@ -11,16 +11,6 @@
 
 namespace wire {
 
-    enum class ShaderResourceType
-    {
-        UniformBuffer = 0,
-        CombinedImageSampler,
-        SampledImage,
-        Sampler,
-        StorageBuffer,
-        StorageImage
-    };
-
     struct ShaderResourceInfo
     {
         uint32_t Binding;
@@ -54,6 +44,7 @@ namespace wire {
         virtual void update(const std::shared_ptr<Texture2D>& texture, uint32_t binding, uint32_t index, uint32_t mipLevel) = 0;
         virtual void update(const std::shared_ptr<Sampler>& sampler, uint32_t binding, uint32_t index) = 0;
         virtual void update(const std::shared_ptr<Texture2D>& texture, const std::shared_ptr<Sampler>& sampler, uint32_t binding, uint32_t index) = 0;
+        // bound as a storage buffer if it was created as one, a uniform buffer otherwise
         virtual void update(const std::shared_ptr<Buffer>& uniformBuffer, uint32_t binding, uint32_t index) = 0;
         virtual void update(const std::shared_ptr<Framebuffer>& storageImage, uint32_t binding, uint32_t index) = 0;
         virtual void update(const std::shared_ptr<Framebuffer>& storageImage, uint32_t binding, uint32_t index, uint32_t mipLevel) = 0;
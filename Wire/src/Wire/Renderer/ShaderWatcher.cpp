@@ -0,0 +1,194 @@
+#include "ShaderWatcher.h"
+
+#include "Wire/Core/Assert.h"
+
+#include <chrono>
+#include <algorithm>
+
+namespace wire {
+
+    namespace Utils {
+
+        // stat calls are cheap enough to poll a few dozen files, and work the same on every platform
+        static constexpr std::chrono::milliseconds ShaderWatchInterval(100);
+
+        static std::vector<WatchedShaderFile> GetWatchedFiles(const std::filesystem::path& sourcePath, const std::vector<std::string>& dependencyPaths)
+        {
+            std::vector<WatchedShaderFile> files;
+            files.push_back({ .Path = sourcePath });
+
+            for (const auto& path : dependencyPaths)
+                files.push_back({ .Path = path });
+
+            for (auto& file : files)
+                ShaderCompiler::getSourceStat(file.Path, file.Stat);
+
+            return files;
+        }
+
+        static bool HaveFilesChanged(std::vector<WatchedShaderFile>& files)
+        {
+            bool changed = false;
+
+            for (auto& file : files)
+            {
+                ShaderSourceStat stat;
+                ShaderCompiler::getSourceStat(file.Path, stat);
+
+                if (stat.WriteTime != file.Stat.WriteTime || stat.Size != file.Stat.Size)
+                {
+                    file.Stat = stat;
+                    changed = true;
+                }
+            }
+
+            return changed;
+        }
+
+        static bool IsGroupComplete(const ShaderGroup& group, const ShaderInfo& info)
+        {
+            size_t expectedObjects = info.IsGraphics ? 2 : 1;
+
+            return group.Objects.size() == expectedObjects
+                && std::none_of(group.Objects.begin(), group.Objects.end(), [](const ShaderObject& object) { return object.getBytecode().empty(); });
+        }
+
+    }
+
+    ShaderWatcher::~ShaderWatcher()
+    {
+        stop();
+    }
+
+    void ShaderWatcher::start(const ShaderCacheDesc& desc, const ShaderCache& cache)
+    {
+        WR_ASSERT(!m_Thread.joinable(), "Shader watcher started twice");
+
+        m_Desc = desc;
+        m_Stopping = false;
+
+        m_Shaders.clear();
+        for (const auto& info : desc.ShaderInfos)
+        {
+            WatchedShader& shader = m_Shaders.emplace_back();
+            shader.Info = info;
+            shader.Files = Utils::GetWatchedFiles(info.Path, cache.getDependencyPaths(info.Path.generic_string()));
+        }
+
+        m_Thread = std::thread([this]() { watchLoop(); });
+    }
+
+    void ShaderWatcher::stop()
+    {
+        if (!m_Thread.joinable())
+            return;
+
+        {
+            std::lock_guard lock(m_Mutex);
+            m_Stopping = true;
+        }
+
+        m_Condition.notify_all();
+        m_Thread.join();
+    }
+
+    bool ShaderWatcher::takeCompiledGroups(std::vector<ShaderGroup>& outGroups)
+    {
+        std::lock_guard lock(m_Mutex);
+
+        if (m_CompiledGroups.empty())
+            return false;
+
+        outGroups = std::move(m_CompiledGroups);
+        m_CompiledGroups.clear();
+
+        return true;
+    }
+
+    void ShaderWatcher::watchLoop()
+    {
+        std::unique_lock lock(m_Mutex);
+
+        while (!m_Condition.wait_for(lock, Utils::ShaderWatchInterval, [this]() { return m_Stopping; }))
+        {
+            lock.unlock();
+
+            std::vector<size_t> changed;
+            for (size_t i = 0; i < m_Shaders.size(); i++)
+            {
+                if (Utils::HaveFilesChanged(m_Shaders[i].Files))
+                    changed.push_back(i);
+            }
+
+            if (!changed.empty())
+                recompile(changed);
+
+            lock.lock();
+        }
+    }
+
+    void ShaderWatcher::recompile(const std::vector<size_t>& shaderIndices)
+    {
+        auto start = std::chrono::high_resolution_clock::now();
+
+        std::vector<ShaderInfo> infos;
+        for (size_t index : shaderIndices)
+            infos.push_back(m_Shaders[index].Info);
+
+        ShaderCache compiled = ShaderCompiler::createShaderCacheHLSL(infos, m_Desc.CompileOptions);
+        const std::vector<ShaderGroup>& compiledGroups = compiled.getGroups();
+
+        std::vector<ShaderGroup> groups;
+        for (size_t index : shaderIndices)
+        {
+            WatchedShader& shader = m_Shaders[index];
+            std::string sourcePath = shader.Info.Path.generic_string();
+
+            std::vector<const ShaderGroup*> shaderGroups;
+            for (const auto& group : compiledGroups)
+            {
+                if (group.SourcePath == sourcePath)
+                    shaderGroups.push_back(&group);
+            }
+
+            // the errors are already logged, keep running the last version that compiled
+            bool complete = !shaderGroups.empty() && std::all_of(shaderGroups.begin(), shaderGroups.end(), [&shader](const ShaderGroup* group)
+            {
+                return Utils::IsGroupComplete(*group, shader.Info);
+            });
+
+            if (!complete)
+            {
+                WR_ERROR("{} failed to compile, keeping the previous version", sourcePath);
+                continue;
+            }
+
+            // includes may have been added or removed by the edit
+            std::vector<std::string> dependencyPaths;
+            for (const ShaderGroup* group : shaderGroups)
+            {
+                for (const auto& dependency : group->Dependencies)
+                {
+                    if (std::find(dependencyPaths.begin(), dependencyPaths.end(), dependency.Path) == dependencyPaths.end())
+                        dependencyPaths.push_back(dependency.Path);
+                }
+
+                groups.push_back(*group);
+            }
+
+            shader.Files = Utils::GetWatchedFiles(shader.Info.Path, dependencyPaths);
+        }
+
+        if (groups.empty())
+            return;
+
+        double time = std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count();
+        WR_INFO("Recompiled {} shader group(s) in {:.1f} ms", groups.size(), time);
+
+        std::lock_guard lock(m_Mutex);
+
+        m_CompiledGroups.insert(m_CompiledGroups.end(), std::make_move_iterator(groups.begin()), std::make_move_iterator(groups.end()));
+        m_HasRecompiled = true;
+    }
+
+}
@@ -0,0 +1,61 @@
+#pragma once
+
+#include "ShaderCache.h"
+#include "ShaderCompiler.h"
+
+#include <mutex>
+#include <atomic>
+#include <thread>
+#include <vector>
+#include <filesystem>
+#include <condition_variable>
+
+namespace wire {
+
+    struct WatchedShaderFile
+    {
+        std::filesystem::path Path;
+        ShaderSourceStat Stat;
+    };
+
+    // recompiles shaders on a background thread when their sources or includes change on disk
+    class ShaderWatcher
+    {
+    public:
+        ShaderWatcher() = default;
+        ~ShaderWatcher();
+
+        ShaderWatcher(const ShaderWatcher&) = delete;
+        ShaderWatcher& operator=(const ShaderWatcher&) = delete;
+
+        void start(const ShaderCacheDesc& desc, const ShaderCache& cache);
+        void stop();
+
+        // groups compiled since the last call, the device swaps them in at the start of a frame
+        bool takeCompiledGroups(std::vector<ShaderGroup>& outGroups);
+
+        bool hasRecompiled() const { return m_HasRecompiled; }
+        const std::filesystem::path& getCachePath() const { return m_Desc.CachePath; }
+    private:
+        struct WatchedShader
+        {
+            ShaderInfo Info;
+            std::vector<WatchedShaderFile> Files; // the source first, then everything it includes
+        };
+
+        void watchLoop();
+        void recompile(const std::vector<size_t>& shaderIndices);
+    private:
+        ShaderCacheDesc m_Desc;
+        std::vector<WatchedShader> m_Shaders;
+
+        std::thread m_Thread;
+        std::mutex m_Mutex;
+        std::condition_variable m_Condition;
+        bool m_Stopping = false;
+
+        std::vector<ShaderGroup> m_CompiledGroups;
+        std::atomic<bool> m_HasRecompiled = false;
+    };
+
+}
@@ -0,0 +1,357 @@
+#include "TextRenderer.h"
+
+#include "Instance.h"
+#include "Wire/Core/Assert.h"
+
+#include <algorithm>
+
+namespace wire {
+
+    namespace Utils {
+
+        // frames a laid out run stays cached without being drawn
+        constexpr static uint64_t s_RunLifetime = 120;
+
+        static uint32_t DecodeUTF8(std::string_view text, size_t& index)
+        {
+            uint8_t lead = static_cast<uint8_t>(text[index++]);
+            if (lead < 0x80)
+                return lead;
+
+            int continuationCount = lead >= 0xF0 ? 3 : lead >= 0xE0 ? 2 : lead >= 0xC0 ? 1 : 0;
+            if (continuationCount == 0)
+                return 0xFFFD;
+
+            uint32_t codepoint = lead & (0x3F >> continuationCount);
+            for (int i = 0; i < continuationCount; i++)
+            {
+                if (index >= text.size() || (static_cast<uint8_t>(text[index]) & 0xC0) != 0x80)
+                    return 0xFFFD;
+
+                codepoint = (codepoint << 6) | (static_cast<uint8_t>(text[index++]) & 0x3F);
+            }
+
+            return codepoint;
+        }
+
+    }
+
+    size_t TextRenderer::RunKeyHash::operator()(const RunKeyView& key) const
+    {
+        size_t seed = std::hash<std::string_view>{}(key.Text);
+        seed ^= std::hash<const Font*>{}(key.Font) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+        seed ^= std::hash<float>{}(key.Size) + 0x9e3779b9 + (seed << 6) + (seed >> 2);
+
+        return seed;
+    }
+
+    TextRenderer::TextRenderer(Device* device, const TextRendererDesc& desc)
+        : m_Device(device), m_Desc(desc)
+    {
+        InputLayout layout{};
+        layout.VertexBufferLayout = {
+            { "POSITION", ShaderDataType::Float3, sizeof(glm::vec3), offsetof(TextVertex, Position) },
+            { "COLOR",    ShaderDataType::Float4, sizeof(glm::vec4), offsetof(TextVertex, Color)    },
+            { "TEXCOORD", ShaderDataType::Float2, sizeof(glm::vec2), offsetof(TextVertex, TexCoord) },
+            { "TEXCOORD", ShaderDataType::Int,    sizeof(int),       offsetof(TextVertex, FontIndex) }
+        };
+        layout.Stride = sizeof(TextVertex);
+        layout.PushConstantInfos.push_back(
+            PushConstantInfo{
+                .Size = sizeof(glm::mat4),
+                .Offset = 0,
+                .Shader = ShaderType::Vertex
+            }
+        );
+
+        // the resource layout is reflected from the shader
+        GraphicsPipelineDesc pipelineDesc{};
+        pipelineDesc.Layout = layout;
+        pipelineDesc.ShaderPath = desc.ShaderPath;
+        pipelineDesc.Topology = PrimitiveTopology::TriangleList;
+        pipelineDesc.RenderPass = desc.RenderPass;
+
+        m_Pipeline = m_Device->createGraphicsPipeline(pipelineDesc, "TextRenderer::m_Pipeline");
+
+        SamplerDesc samplerDesc{};
+        samplerDesc.MinFilter = SamplerFilter::Linear;
+        samplerDesc.MagFilter = SamplerFilter::Linear;
+        samplerDesc.AddressModeU = AddressMode::ClampToEdge;
+        samplerDesc.AddressModeV = AddressMode::ClampToEdge;
+        samplerDesc.AddressModeW = AddressMode::ClampToEdge;
+        samplerDesc.EnableAnisotropy = false;
+        samplerDesc.MaxAnisotropy = 1.0f;
+        samplerDesc.BorderColor = BorderColor::FloatTransparentBlack;
+        samplerDesc.MipmapMode = MipmapMode::Linear;
+
+        m_Sampler = m_Device->createSampler(samplerDesc, "TextRenderer::m_Sampler");
+
+        std::vector<uint32_t> indices(static_cast<size_t>(m_Desc.MaxQuadsPerFrame) * 6);
+        for (uint32_t quad = 0; quad < m_Desc.MaxQuadsPerFrame; quad++)
+        {
+            uint32_t vertex = quad * 4;
+            uint32_t* index = indices.data() + static_cast<size_t>(quad) * 6;
+
+            index[0] = vertex + 0;
+            index[1] = vertex + 1;
+            index[2] = vertex + 2;
+            index[3] = vertex + 2;
+            index[4] = vertex + 3;
+            index[5] = vertex + 0;
+        }
+
+        m_IndexBuffer = m_Device->createBuffer(IndexBuffer, indices.size() * sizeof(uint32_t), indices.data(), "TextRenderer::m_IndexBuffer");
+
+        uint32_t framesInFlight = m_Device->getInstance().getNumFramesInFlight();
+        size_t vertexBufferSize = sizeof(TextVertex) * 4 * m_Desc.MaxQuadsPerFrame * framesInFlight;
+
+        // vertex buffers are host visible and coherent, so the mapping stays open
+        m_VertexBuffer = m_Device->createBuffer(VertexBuffer, vertexBufferSize, nullptr, "TextRenderer::m_VertexBuffer");
+        m_Vertices = reinterpret_cast<TextVertex*>(m_VertexBuffer->map(vertexBufferSize));
+
+        m_FrameResources.resize(framesInFlight);
+    }
+
+    TextRenderer::~TextRenderer()
+    {
+        m_VertexBuffer->unmap();
+
+        for (const auto& frame : m_FrameResources)
+        {
+            for (const auto& resource : frame.Resources)
+                m_Device->drop(resource);
+        }
+
+        m_Device->drop(m_VertexBuffer);
+        m_Device->drop(m_IndexBuffer);
+        m_Device->drop(m_Sampler);
+        m_Device->drop(m_Pipeline);
+    }
+
+    void TextRenderer::begin(const glm::mat4& viewProjection)
+    {
+        m_ViewProjection = viewProjection;
+        m_Frame++;
+
+        m_FontDraws.clear();
+        m_FontIndices.clear();
+
+        // nothing refers to a run between frames, so this is the only safe point to drop them
+        if (m_Frame % Utils::s_RunLifetime == 0)
+        {
+            std::erase_if(m_Runs, [frame = m_Frame](const auto& run)
+            {
+                return run.second.LastUsedFrame + Utils::s_RunLifetime < frame;
+            });
+        }
+    }
+
+    void TextRenderer::drawText(std::string_view text, const std::shared_ptr<Font>& font, const glm::vec3& position, float size, const glm::vec4& color)
+    {
+        if (text.empty() || !font)
+            return;
+
+        const TextRun& run = getRun(text, font, size);
+        if (run.Quads.empty())
+            return;
+
+        auto [it, inserted] = m_FontIndices.try_emplace(font.get(), m_FontDraws.size());
+        if (inserted)
+            m_FontDraws.push_back(FontDraws{ .Font = font });
+
+        m_FontDraws[it->second].Texts.push_back(QueuedText{ &run, position, color });
+    }
+
+    void TextRenderer::end(CommandList& commandList)
+    {
+        m_DrawCallCount = 0;
+
+        if (m_FontDraws.empty())
+            return;
+
+        uint32_t frameIndex = m_Device->getFrameIndex();
+        uint32_t frameVertexOffset = frameIndex * m_Desc.MaxQuadsPerFrame * 4;
+        TextVertex* vertices = m_Vertices + frameVertexOffset;
+
+        uint32_t quadCount = 0;
+        bool overflow = false;
+
+        commandList.bindPipeline(m_Pipeline);
+        commandList.pushConstants(ShaderType::Vertex, m_ViewProjection);
+        commandList.bindVertexBuffers({ m_VertexBuffer });
+        commandList.bindIndexBuffer(m_IndexBuffer);
+
+        for (uint32_t batch = 0; static_cast<size_t>(batch) * s_MaxFonts < m_FontDraws.size(); batch++)
+        {
+            size_t firstFont = static_cast<size_t>(batch) * s_MaxFonts;
+            size_t fontCount = std::min<size_t>(s_MaxFonts, m_FontDraws.size() - firstFont);
+            uint32_t batchStart = quadCount;
+
+            for (size_t slot = 0; slot < fontCount && !overflow; slot++)
+            {
+                int fontIndex = static_cast<int>(slot);
+
+                for (const QueuedText& text : m_FontDraws[firstFont + slot].Texts)
+                {
+                    const std::vector<GlyphQuad>& quads = text.Run->Quads;
+                    if (quadCount + quads.size() > m_Desc.MaxQuadsPerFrame)
+                    {
+                        overflow = true;
+                        break;
+                    }
+
+                    // left, bottom, right, top of every glyph in one add
+                    glm::vec4 origin(text.Position.x, text.Position.y, text.Position.x, text.Position.y);
+                    float z = text.Position.z;
+
+                    TextVertex* vertex = vertices + static_cast<size_t>(quadCount) * 4;
+                    for (const GlyphQuad& quad : quads)
+                    {
+                        glm::vec4 bounds = origin + quad.Plane;
+                        const glm::vec4& texCoord = quad.TexCoord;
+
+                        vertex[0] = { { bounds.x, bounds.y, z }, text.Color, { texCoord.x, texCoord.y }, fontIndex };
+                        vertex[1] = { { bounds.z, bounds.y, z }, text.Color, { texCoord.z, texCoord.y }, fontIndex };
+                        vertex[2] = { { bounds.z, bounds.w, z }, text.Color, { texCoord.z, texCoord.w }, fontIndex };
+                        vertex[3] = { { bounds.x, bounds.w, z }, text.Color, { texCoord.x, texCoord.w }, fontIndex };
+
+                        vertex += 4;
+                    }
+
+                    quadCount += static_cast<uint32_t>(quads.size());
+                }
+            }
+
+            if (quadCount != batchStart)
+            {
+                commandList.bindShaderResource(0, getBatchResource(frameIndex, batch, firstFont, fontCount));
+                commandList.drawIndexed((quadCount - batchStart) * 6, frameVertexOffset + batchStart * 4);
+
+                m_DrawCallCount++;
+            }
+
+            if (overflow)
+                break;
+        }
+
+        if (overflow)
+            WR_WARN("TextRenderer ran out of quads this frame ({} max), the remaining text was dropped", m_Desc.MaxQuadsPerFrame);
+    }
+
+    const TextRenderer::TextRun& TextRenderer::getRun(std::string_view text, const std::shared_ptr<Font>& font, float size)
+    {
+        auto it = m_Runs.find(RunKeyView{ text, font.get(), size });
+        if (it != m_Runs.end() && it->second.Font.lock() == font)
+        {
+            it->second.LastUsedFrame = m_Frame;
+            return it->second;
+        }
+
+        TextRun run;
+        run.Font = font;
+        run.LastUsedFrame = m_Frame;
+
+        const MSDFData& data = font->getMSDFData();
+        const std::shared_ptr<Texture2D>& atlas = font->getAtlasTexture();
+
+        glm::vec4 texelSize(1.0f / atlas->getWidth(), 1.0f / atlas->getHeight(), 1.0f / atlas->getWidth(), 1.0f / atlas->getHeight());
+
+        const GlyphMetrics* fallback = data.getGlyph('?');
+        const GlyphMetrics* space = data.getGlyph(' ');
+
+        double x = 0.0;
+        double y = 0.0;
+
+        size_t index = 0;
+        while (index < text.size())
+        {
+            uint32_t codepoint = Utils::DecodeUTF8(text, index);
+
+            if (codepoint == '\r')
+                continue;
+
+            if (codepoint == '\n')
+            {
+                x = 0.0;
+                y -= data.Metrics.LineHeight;
+                continue;
+            }
+
+            if (codepoint == '\t')
+            {
+                x += space ? space->Advance * 4.0 : 0.0;
+                continue;
+            }
+
+            const GlyphMetrics* glyph = data.getGlyph(codepoint);
+            if (!glyph)
+            {
+                glyph = fallback;
+                codepoint = '?';
+
+                if (!glyph)
+                    continue;
+            }
+
+            if (glyph->PlaneLeft != glyph->PlaneRight)
+            {
+                GlyphQuad quad;
+                quad.Plane = glm::vec4(
+                    x + glyph->PlaneLeft,
+                    y + glyph->PlaneBottom,
+                    x + glyph->PlaneRight,
+                    y + glyph->PlaneTop
+                ) * size;
+                quad.TexCoord = glm::vec4(glyph->AtlasLeft, glyph->AtlasBottom, glyph->AtlasRight, glyph->AtlasTop) * texelSize;
+
+                run.Quads.push_back(quad);
+            }
+
+            // kerning depends on the glyph that follows
+            size_t nextIndex = index;
+            uint32_t nextCodepoint = nextIndex < text.size() ? Utils::DecodeUTF8(text, nextIndex) : 0;
+
+            x += nextCodepoint ? data.getAdvance(codepoint, nextCodepoint) : glyph->Advance;
+        }
+
+        if (it != m_Runs.end())
+        {
+            it->second = std::move(run);
+            return it->second;
+        }
+
+        return m_Runs.emplace(RunKey{ std::string(text), font.get(), size }, std::move(run)).first->second;
+    }
+
+    std::shared_ptr<ShaderResource> TextRenderer::getBatchResource(uint32_t frameIndex, uint32_t batch, size_t firstFont, size_t fontCount)
+    {
+        FrameResources& frame = m_FrameResources[frameIndex];
+
+        if (frame.Resources.size() <= batch)
+        {
+            std::shared_ptr<ShaderResource> resource = m_Device->createShaderResource(0, m_Pipeline->getResourceLayout(), "TextRenderer batch resource");
+            resource->update(m_Sampler, 1, 0);
+
+            frame.Resources.push_back(resource);
+            frame.BoundTextures.emplace_back();
+        }
+
+        // this frame's previous submission has finished, so its descriptors can be rewritten.
+        // every element of the array has to be valid, the unused slots repeat the first font
+        const std::shared_ptr<ShaderResource>& resource = frame.Resources[batch];
+        auto& boundTextures = frame.BoundTextures[batch];
+
+        for (uint32_t slot = 0; slot < s_MaxFonts; slot++)
+        {
+            const std::shared_ptr<Texture2D>& texture = m_FontDraws[firstFont + (slot < fontCount ? slot : 0)].Font->getAtlasTexture();
+            if (boundTextures[slot] == texture)
+                continue;
+
+            resource->update(texture, 0, slot);
+            boundTextures[slot] = texture;
+        }
+
+        return resource;
+    }
+
+}
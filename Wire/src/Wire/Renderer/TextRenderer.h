@@ -0,0 +1,144 @@
+#pragma once
+
+#include "Device.h"
+#include "Font.h"
+#include "MSDFData.h"
+
+#include <glm/glm.hpp>
+
+#include <array>
+#include <memory>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+namespace wire {
+
+    struct TextVertex
+    {
+        glm::vec3 Position;
+        glm::vec4 Color;
+        glm::vec2 TexCoord;
+        int FontIndex;
+    };
+
+    struct TextRendererDesc
+    {
+        std::shared_ptr<RenderPass> RenderPass;
+        std::string ShaderPath = "shadercache://UIText.hlsl";
+        uint32_t MaxQuadsPerFrame = 16384;
+    };
+
+    // lays out and batches text for the UIText shader, every font shares one texture array so a draw covers up to s_MaxFonts fonts
+    class TextRenderer
+    {
+    public:
+        constexpr static uint32_t s_MaxFonts = 32; // size of r_Textures in UIText.hlsl
+
+        TextRenderer(Device* device, const TextRendererDesc& desc);
+        ~TextRenderer();
+
+        TextRenderer(const TextRenderer&) = delete;
+        TextRenderer& operator=(const TextRenderer&) = delete;
+
+        void begin(const glm::mat4& viewProjection);
+        // position is the baseline of the first line, size is the height of an em
+        void drawText(std::string_view text, const std::shared_ptr<Font>& font, const glm::vec3& position, float size, const glm::vec4& color = glm::vec4(1.0f));
+        // records the draws into a command list inside a render pass compatible with the desc
+        void end(CommandList& commandList);
+
+        size_t getCachedRunCount() const { return m_Runs.size(); }
+        uint32_t getDrawCallCount() const { return m_DrawCallCount; }
+    private:
+        // plane and texture bounds packed as left, bottom, right, top so a quad is placed with one vector add
+        struct GlyphQuad
+        {
+            glm::vec4 Plane;
+            glm::vec4 TexCoord;
+        };
+
+        struct TextRun
+        {
+            std::weak_ptr<Font> Font; // a new font can reuse the address of a destroyed one
+            std::vector<GlyphQuad> Quads;
+            uint64_t LastUsedFrame = 0;
+        };
+
+        struct RunKeyView
+        {
+            std::string_view Text;
+            const Font* Font;
+            float Size;
+        };
+
+        struct RunKey
+        {
+            std::string Text;
+            const Font* Font;
+            float Size;
+
+            operator RunKeyView() const { return { Text, Font, Size }; }
+        };
+
+        struct RunKeyHash
+        {
+            using is_transparent = void;
+
+            size_t operator()(const RunKeyView& key) const;
+            size_t operator()(const RunKey& key) const { return (*this)(RunKeyView(key)); }
+        };
+
+        struct RunKeyEqual
+        {
+            using is_transparent = void;
+
+            bool operator()(const RunKeyView& lhs, const RunKeyView& rhs) const { return lhs.Font == rhs.Font && lhs.Size == rhs.Size && lhs.Text == rhs.Text; }
+        };
+
+        struct QueuedText
+        {
+            const TextRun* Run;
+            glm::vec3 Position;
+            glm::vec4 Color;
+        };
+
+        struct FontDraws
+        {
+            std::shared_ptr<Font> Font;
+            std::vector<QueuedText> Texts;
+        };
+
+        struct FrameResources
+        {
+            std::vector<std::shared_ptr<ShaderResource>> Resources; // one per batch of fonts
+            std::vector<std::array<std::shared_ptr<Texture2D>, s_MaxFonts>> BoundTextures;
+        };
+
+        const TextRun& getRun(std::string_view text, const std::shared_ptr<Font>& font, float size);
+        std::shared_ptr<ShaderResource> getBatchResource(uint32_t frameIndex, uint32_t batch, size_t firstFont, size_t fontCount);
+    private:
+        Device* m_Device = nullptr;
+        TextRendererDesc m_Desc;
+
+        std::shared_ptr<GraphicsPipeline> m_Pipeline;
+        std::shared_ptr<Sampler> m_Sampler;
+        std::shared_ptr<Buffer> m_IndexBuffer;
+
+        // one slice of MaxQuadsPerFrame quads per frame in flight, mapped for the lifetime of the renderer
+        std::shared_ptr<Buffer> m_VertexBuffer;
+        TextVertex* m_Vertices = nullptr;
+
+        std::vector<FrameResources> m_FrameResources;
+
+        std::unordered_map<RunKey, TextRun, RunKeyHash, RunKeyEqual> m_Runs;
+        // in order of first use this frame, so fonts keep their batch and slot while the scene does not change
+        std::vector<FontDraws> m_FontDraws;
+        std::unordered_map<const Font*, size_t> m_FontIndices;
+
+        glm::mat4 m_ViewProjection = glm::mat4(1.0f);
+        uint64_t m_Frame = 0;
+        uint32_t m_DrawCallCount = 0;
+    };
+
+}
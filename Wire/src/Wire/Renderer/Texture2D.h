@@ -3,10 +3,24 @@
 #include "IResource.h"
 #include "Wire/Core/UUID.h"
 
+#include <vector>
 #include <cstdint>
 
 namespace wire {
 
+    enum class TextureFormat
+    {
+        RGBA8 = 0,
+        R8 = 1 // sampled as (r, r, r, 1), so shaders written for rgba still read it
+    };
+
+    struct TextureRegion
+    {
+        const void* Data; // tightly packed rows in the format of the texture
+        uint32_t X, Y;
+        uint32_t Width, Height;
+    };
+
     class Texture2D : public IResource
     {
     public:
@@ -14,6 +28,10 @@ namespace wire {
 
         virtual uint32_t getWidth() const = 0;
         virtual uint32_t getHeight() const = 0;
+        virtual TextureFormat getFormat() const = 0;
+
+        // uploads every region in one submission, the rest of the texture is left as it is
+        virtual void update(const std::vector<TextureRegion>& regions) = 0;
 
         virtual UUID getUUID() const = 0;
     };
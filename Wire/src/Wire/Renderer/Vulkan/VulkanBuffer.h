@@ -21,6 +21,7 @@ namespace wire {
         virtual size_t getSize() const override { return m_Size; }
 
         VkBuffer getBuffer() const { return m_Buffer; }
+        BufferType getType() const { return m_Type; }
         
     protected:
         virtual void destroy() override;
@@ -6,35 +6,203 @@
 #include "VulkanShaderResource.h"
 #include "VulkanGraphicsPipeline.h"
 
+#include "Wire/Core/ThreadPool.h"
 #include "Wire/Renderer/ComputePipeline.h"
 
 #include <array>
+#include <limits>
+#include <chrono>
+#include <format>
+#include <cstring>
+#include <algorithm>
 
 namespace wire {
 
+    // the first dispatches of each candidate are dropped, they include cold caches and pipeline warm up
+    constexpr static uint32_t s_TuningWarmupSamples = 2;
+    constexpr static uint32_t s_TuningSampleCount = 8;
+
+    namespace Utils {
+
+        // identifies a tuned pipeline across runs, so unlike the device's pipeline key it holds no addresses
+        static std::string GetTuningKey(const ComputePipelineDesc& desc, const ShaderObjectView& shader)
+        {
+            std::string key = desc.ShaderPath + "#" + std::to_string(desc.ShaderVariant);
+
+            // an edited shader is tuned again, the best size for the old code says little about the new one
+            key += ";";
+            if (shader.SHA256)
+            {
+                for (uint32_t word : *shader.SHA256)
+                    key += std::format("{:08x}", word);
+            }
+
+            for (const auto& constant : desc.SpecializationConstants)
+                key += ";" + std::to_string(constant.ID) + "=" + std::to_string(constant.Value);
+
+            // a different set of candidates is tuned again
+            key += ";";
+            for (const auto& workgroupSize : desc.WorkgroupSizeCandidates)
+                key += std::format("{}x{}x{},", workgroupSize[0], workgroupSize[1], workgroupSize[2]);
+
+            return key;
+        }
+
+        static void RemoveUnsupportedWorkgroupSizes(std::vector<std::array<uint32_t, 3>>& workgroupSizes, const VkPhysicalDeviceLimits& limits, std::string_view debugName)
+        {
+            std::erase_if(workgroupSizes, [&limits, debugName](const std::array<uint32_t, 3>& workgroupSize)
+            {
+                bool supported = workgroupSize[0] * workgroupSize[1] * workgroupSize[2] <= limits.maxComputeWorkGroupInvocations;
+                for (uint32_t i = 0; i < 3; i++)
+                    supported &= workgroupSize[i] > 0 && workgroupSize[i] <= limits.maxComputeWorkGroupSize[i];
+
+                if (!supported)
+                    WR_WARN("{}: workgroup size {}x{}x{} is not supported by the device, skipping it", debugName, workgroupSize[0], workgroupSize[1], workgroupSize[2]);
+
+                return !supported;
+            });
+        }
+
+        // numthreads is a literal in HLSL, so the size is rewritten in the LocalSize execution mode instead of specialized
+        static std::vector<uint8_t> OverrideWorkgroupSize(std::span<const uint8_t> bytecode, const std::array<uint32_t, 3>& workgroupSize, std::string_view debugName)
+        {
+            constexpr uint32_t OpExecutionMode = 16;
+            constexpr uint32_t OpDecorate = 71;
+            constexpr uint32_t ExecutionModeLocalSize = 17;
+            constexpr uint32_t DecorationBuiltIn = 11;
+            constexpr uint32_t BuiltInWorkgroupSize = 25;
+            constexpr size_t HeaderWordCount = 5;
+
+            std::vector<uint32_t> words(bytecode.size() / sizeof(uint32_t));
+            std::memcpy(words.data(), bytecode.data(), words.size() * sizeof(uint32_t));
+
+            bool patched = false;
+
+            for (size_t i = HeaderWordCount; i < words.size();)
+            {
+                uint32_t wordCount = words[i] >> 16;
+                uint32_t opcode = words[i] & 0xFFFF;
+
+                if (wordCount == 0 || i + wordCount > words.size())
+                    break;
+
+                if (opcode == OpExecutionMode && wordCount == 6 && words[i + 2] == ExecutionModeLocalSize)
+                {
+                    std::copy(workgroupSize.begin(), workgroupSize.end(), words.begin() + i + 3);
+                    patched = true;
+                }
+                else if (opcode == OpDecorate && wordCount == 4 && words[i + 2] == DecorationBuiltIn && words[i + 3] == BuiltInWorkgroupSize)
+                {
+                    WR_WARN("{}: shader declares a WorkgroupSize constant, the workgroup size override is ignored by the driver", debugName);
+                }
+
+                i += wordCount;
+            }
+
+            WR_ASSERT_OR_WARN(patched, "{}: no LocalSize execution mode found, workgroup size was not overridden", debugName);
+
+            std::vector<uint8_t> result(words.size() * sizeof(uint32_t));
+            std::memcpy(result.data(), words.data(), result.size());
+
+            return result;
+        }
+
+    }
+
     VulkanComputePipeline::VulkanComputePipeline(Device* device, const ComputePipelineDesc& desc, std::string_view debugName)
-        : m_Device(device), m_InputLayout(desc.Layout), m_DebugName(debugName)
+        : m_Device(device), m_DebugName(debugName), m_Fallback(desc.Fallback)
+    {
+        VulkanDevice* vk = (VulkanDevice*)device;
+
+        ShaderResult shaderResult = vk->getShaderCache().getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, false, desc.ShaderVariant);
+        std::array stages = { shaderResult.VertexOrCompute };
+
+        // anything left out of the desc is taken from the shader itself
+        ComputePipelineDesc createDesc = desc;
+        if (!createDesc.Layout.ResourceLayout)
+            createDesc.Layout.ResourceLayout = vk->getOrCreateShaderResourceLayout(Utils::GetReflectedLayoutInfo(stages), m_DebugName + " (reflected layout)");
+        if (createDesc.Layout.PushConstantInfos.empty())
+            createDesc.Layout.PushConstantInfos = Utils::GetReflectedPushConstants(stages);
+
+        Utils::ValidateReflectedLayout(stages, createDesc.Layout.ResourceLayout, createDesc.Layout.PushConstantInfos, m_DebugName);
+        Utils::ValidateSpecializationConstants(stages, createDesc.SpecializationConstants, m_DebugName);
+
+        m_InputLayout = createDesc.Layout;
+
+        if (!createDesc.WorkgroupSizeCandidates.empty())
+        {
+            m_TuningKey = Utils::GetTuningKey(createDesc, shaderResult.VertexOrCompute);
+            Utils::RemoveUnsupportedWorkgroupSizes(createDesc.WorkgroupSizeCandidates, vk->getLimits(), m_DebugName);
+
+            std::array<uint32_t, 3> tunedWorkgroupSize;
+            if (vk->getTunedWorkgroupSize(m_TuningKey, tunedWorkgroupSize))
+            {
+                createDesc.WorkgroupSize = tunedWorkgroupSize;
+                createDesc.WorkgroupSizeCandidates.clear();
+            }
+            else if (!vk->supportsTimestamps() || createDesc.WorkgroupSizeCandidates.size() < 2)
+            {
+                // nothing to measure or nothing to choose from, the first candidate is the best guess
+                if (!createDesc.WorkgroupSizeCandidates.empty())
+                    createDesc.WorkgroupSize = createDesc.WorkgroupSizeCandidates[0];
+
+                createDesc.WorkgroupSizeCandidates.clear();
+            }
+        }
+
+        // reloads keep the layout, resources bound against it stay compatible. they also keep the candidates,
+        // a reload with the same bytecode finds its tuned size under the key and a changed shader is tuned again
+        m_Desc = createDesc;
+        m_Desc.WorkgroupSize = desc.WorkgroupSize;
+        m_Desc.WorkgroupSizeCandidates = desc.WorkgroupSizeCandidates;
+        m_Desc.CompileAsync = false;
+        m_Desc.Fallback = nullptr;
+
+        if (shaderResult.VertexOrCompute.Reflection)
+            std::copy(std::begin(shaderResult.VertexOrCompute.Reflection->WorkgroupSize), std::end(shaderResult.VertexOrCompute.Reflection->WorkgroupSize), m_WorkgroupSize.begin());
+
+        for (uint32_t i = 0; i < 3; i++)
+        {
+            if (createDesc.WorkgroupSize[i] != 0)
+                m_WorkgroupSize[i] = createDesc.WorkgroupSize[i];
+        }
+
+        if (desc.CompileAsync)
+        {
+            m_CompileTask = ThreadPool::shared().submit([this, createDesc]()
+            {
+                create(createDesc);
+                m_Ready = true;
+            });
+        }
+        else
+        {
+            create(createDesc);
+            m_Ready = true;
+        }
+    }
+
+    void VulkanComputePipeline::create(const ComputePipelineDesc& desc)
     {
-        ShaderCache& cache = device->getShaderCache();
+        ShaderCache& cache = m_Device->getShaderCache();
 
-        ShaderResult shaderResult = cache.getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, false);
+        ShaderResult shaderResult = cache.getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, false, desc.ShaderVariant);
         
         WR_ASSERT(!shaderResult.IsGraphics, "compute pipeline shader must be a compute shader");
         
-        VkShaderModuleCreateInfo moduleInfo{};
-        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        moduleInfo.codeSize = shaderResult.VertexOrCompute.Bytecode.size();
-        moduleInfo.pCode = reinterpret_cast<uint32_t*>(shaderResult.VertexOrCompute.Bytecode.data());
-        
-        VulkanDevice* vk = (VulkanDevice*)device;
-        m_Device = vk;
-
-        VkResult result = vkCreateShaderModule(vk->getDevice(), &moduleInfo, vk->getAllocator(), &m_ComputeShader);
-        VK_CHECK(result, "failed to create Vulkan shader module");
+        VulkanDevice* vk = (VulkanDevice*)m_Device;
 
         std::string workingDebugName = m_DebugName;
         workingDebugName += " (compute shader module)";
-        VK_DEBUG_NAME(vk->getDevice(), SHADER_MODULE, m_ComputeShader, workingDebugName.c_str());
+        if (desc.WorkgroupSize == std::array<uint32_t, 3>{ 0, 0, 0 })
+        {
+            m_ComputeShader = vk->getObjectCache().acquireShaderModule(shaderResult.VertexOrCompute.Bytecode, workingDebugName);
+        }
+        else
+        {
+            std::vector<uint8_t> bytecode = Utils::OverrideWorkgroupSize(shaderResult.VertexOrCompute.Bytecode, m_WorkgroupSize, m_DebugName);
+            m_ComputeShader = vk->getObjectCache().acquireShaderModule(bytecode, workingDebugName);
+        }
 
         VkPipelineShaderStageCreateInfo computeShaderStageInfo{};
         computeShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -42,6 +210,12 @@ namespace wire {
         computeShaderStageInfo.module = m_ComputeShader;
         computeShaderStageInfo.pName = "CShader";
 
+        std::vector<VkSpecializationMapEntry> specializationEntries;
+        VkSpecializationInfo specializationInfo = Utils::GetSpecializationInfo(desc.SpecializationConstants, specializationEntries);
+
+        if (!desc.SpecializationConstants.empty())
+            computeShaderStageInfo.pSpecializationInfo = &specializationInfo;
+
         std::array shaderStages = { computeShaderStageInfo };
 
         VkPipelineDynamicStateCreateInfo dynamicState{};
@@ -66,31 +240,50 @@ namespace wire {
         if (vkShaderResourceLayout)
             setLayouts = vkShaderResourceLayout->getLayouts();
 
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
-        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = (uint32_t)pushConstantRanges.size();
-        pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
-
-        result = vkCreatePipelineLayout(vk->getDevice(), &pipelineLayoutInfo, vk->getAllocator(), &m_Layout);
-        VK_CHECK(result, "failed to create create Vulkan pipeline layout");
-
         workingDebugName = m_DebugName;
         workingDebugName += " (pipeline layout)";
-        VK_DEBUG_NAME(vk->getDevice(), PIPELINE_LAYOUT, m_Layout, workingDebugName.c_str());
+        m_Layout = vk->getObjectCache().acquirePipelineLayout(setLayouts, pushConstantRanges, workingDebugName);
+        m_PushConstantRanges = pushConstantRanges;
 
         VkComputePipelineCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_COMPUTE_PIPELINE_CREATE_INFO;
         createInfo.layout = m_Layout;
         createInfo.stage = computeShaderStageInfo;
+
+        VkPipelineCreationFeedbackEXT creationFeedback{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+        feedbackInfo.pPipelineCreationFeedback = &creationFeedback;
+
+        if (vk->supportsPipelineCreationFeedback())
+            createInfo.pNext = &feedbackInfo;
+
+        auto start = std::chrono::high_resolution_clock::now();
         
-        result = vkCreateComputePipelines(vk->getDevice(), nullptr, 1, &createInfo, vk->getAllocator(), &m_Pipeline);
+        VkResult result = vkCreateComputePipelines(vk->getDevice(), vk->getPipelineCache(), 1, &createInfo, vk->getAllocator(), &m_Pipeline);
         VK_CHECK(result, "failed to create Vulkan compute pipeline");
 
+        vk->recordPipelineCreation(creationFeedback, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
         workingDebugName = m_DebugName;
         workingDebugName += " (pipeline)";
         VK_DEBUG_NAME(vk->getDevice(), PIPELINE, m_Pipeline, workingDebugName.c_str());
+
+        if (!desc.WorkgroupSizeCandidates.empty())
+        {
+            ComputePipelineDesc candidateDesc = desc;
+            candidateDesc.WorkgroupSizeCandidates.clear();
+            candidateDesc.CompileAsync = false;
+            candidateDesc.Fallback = nullptr;
+
+            for (const auto& workgroupSize : desc.WorkgroupSizeCandidates)
+            {
+                candidateDesc.WorkgroupSize = workgroupSize;
+                m_TuningCandidates.push_back(std::make_unique<VulkanComputePipeline>(m_Device, candidateDesc, m_DebugName + " (workgroup size candidate)"));
+            }
+
+            m_TuningSamples.resize(m_TuningCandidates.size());
+        }
     }
 
     VulkanComputePipeline::~VulkanComputePipeline()
@@ -98,8 +291,153 @@ namespace wire {
         destroy();
     }
 
+    void VulkanComputePipeline::wait() const
+    {
+        if (m_CompileTask.valid())
+            m_CompileTask.wait();
+    }
+
+    void VulkanComputePipeline::reload()
+    {
+        if (m_ReloadTask.valid())
+        {
+            m_ReloadQueued = true;
+            return;
+        }
+
+        // the worker gets its own copy of the desc. the device's layout containers belong to this thread,
+        // so a layout the edited shader now needs is made here
+        ComputePipelineDesc desc = m_Desc;
+        if (!desc.Layout.ResourceLayout)
+        {
+            VulkanDevice* vk = (VulkanDevice*)m_Device;
+
+            ShaderResult shaderResult = vk->getShaderCache().getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, false, desc.ShaderVariant);
+            std::array stages = { shaderResult.VertexOrCompute };
+            desc.Layout.ResourceLayout = vk->getOrCreateShaderResourceLayout(Utils::GetReflectedLayoutInfo(stages), m_DebugName + " (reflected layout)");
+        }
+
+        m_ReloadTask = ThreadPool::shared().submit([this, desc]()
+        {
+            m_ReloadedPipeline = std::make_unique<VulkanComputePipeline>(m_Device, desc, m_DebugName);
+        });
+    }
+
+    bool VulkanComputePipeline::applyReload()
+    {
+        if (!m_ReloadTask.valid())
+            return true;
+
+        if (m_ReloadTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        m_ReloadTask.get();
+
+        std::swap(m_ComputeShader, m_ReloadedPipeline->m_ComputeShader);
+        std::swap(m_Layout, m_ReloadedPipeline->m_Layout);
+        std::swap(m_Pipeline, m_ReloadedPipeline->m_Pipeline);
+        std::swap(m_PushConstantRanges, m_ReloadedPipeline->m_PushConstantRanges);
+        std::swap(m_WorkgroupSize, m_ReloadedPipeline->m_WorkgroupSize);
+        std::swap(m_InputLayout, m_ReloadedPipeline->m_InputLayout);
+        m_Desc.Layout.ResourceLayout = m_InputLayout.ResourceLayout;
+
+        // candidates built from the old shader would measure the wrong code, tuning starts over under the new key
+        std::swap(m_TuningKey, m_ReloadedPipeline->m_TuningKey);
+        std::swap(m_TuningCandidates, m_ReloadedPipeline->m_TuningCandidates);
+        m_TuningSamples.assign(m_TuningCandidates.size(), {});
+        m_NextTuningCandidate = 0;
+
+        // frees the old objects through the resource free queue, after the frames using them are done
+        m_ReloadedPipeline.reset();
+
+        if (m_ReloadQueued)
+        {
+            m_ReloadQueued = false;
+            reload();
+
+            return false;
+        }
+
+        return true;
+    }
+
+    bool VulkanComputePipeline::getTuningCandidate(uint32_t& outCandidate, VkPipeline& outPipeline, std::array<uint32_t, 3>& outWorkgroupSize)
+    {
+        if (!m_Ready || m_TuningCandidates.empty())
+            return false;
+
+        uint32_t candidate = m_NextTuningCandidate++ % static_cast<uint32_t>(m_TuningCandidates.size());
+
+        outCandidate = candidate;
+        outPipeline = m_TuningCandidates[candidate]->m_Pipeline;
+        outWorkgroupSize = m_TuningCandidates[candidate]->m_WorkgroupSize;
+
+        return true;
+    }
+
+    void VulkanComputePipeline::recordTuningSample(uint32_t candidate, double time)
+    {
+        // samples still in flight when tuning finished or restarted
+        if (candidate >= m_TuningSamples.size())
+            return;
+
+        m_TuningSamples[candidate].push_back(time);
+
+        bool complete = std::all_of(m_TuningSamples.begin(), m_TuningSamples.end(), [](const std::vector<double>& samples)
+        {
+            return samples.size() >= s_TuningWarmupSamples + s_TuningSampleCount;
+        });
+
+        if (complete)
+            finishTuning();
+    }
+
+    void VulkanComputePipeline::finishTuning()
+    {
+        size_t best = 0;
+        double bestTime = std::numeric_limits<double>::max();
+
+        for (size_t i = 0; i < m_TuningSamples.size(); i++)
+        {
+            std::vector<double> samples(m_TuningSamples[i].begin() + s_TuningWarmupSamples, m_TuningSamples[i].end());
+
+            // the median ignores frames where other work held up the dispatch
+            std::nth_element(samples.begin(), samples.begin() + samples.size() / 2, samples.end());
+            double median = samples[samples.size() / 2];
+
+            if (median < bestTime)
+            {
+                best = i;
+                bestTime = median;
+            }
+        }
+
+        VulkanComputePipeline& winner = *m_TuningCandidates[best];
+
+        std::swap(m_ComputeShader, winner.m_ComputeShader);
+        std::swap(m_Layout, winner.m_Layout);
+        std::swap(m_Pipeline, winner.m_Pipeline);
+        std::swap(m_WorkgroupSize, winner.m_WorkgroupSize);
+
+        WR_INFO("{}: autotuned workgroup size {}x{}x{} ({:.3f} ms, {} candidates)", m_DebugName, m_WorkgroupSize[0], m_WorkgroupSize[1], m_WorkgroupSize[2], bestTime, m_TuningCandidates.size());
+
+        static_cast<VulkanDevice*>(m_Device)->setTunedWorkgroupSize(m_TuningKey, m_WorkgroupSize);
+
+        // the previous objects moved into the winner, they are freed with the candidates once no frame uses them
+        m_TuningCandidates.clear();
+        m_TuningSamples.clear();
+        m_NextTuningCandidate = 0;
+    }
+
     void VulkanComputePipeline::destroy()
     {
+        wait();
+
+        if (m_ReloadTask.valid())
+            m_ReloadTask.wait();
+        m_ReloadedPipeline.reset();
+        m_TuningCandidates.clear();
+
         if (m_Valid && m_Device)
         {
             m_Device->submitResourceFree([pipeline = m_Pipeline, pipelineLayout = m_Layout, computeShader = m_ComputeShader](Device* device)
@@ -107,8 +445,8 @@ namespace wire {
                 VulkanDevice* vk = (VulkanDevice*)device;
                 
                 vkDestroyPipeline(vk->getDevice(), pipeline, vk->getAllocator());
-                vkDestroyPipelineLayout(vk->getDevice(), pipelineLayout, vk->getAllocator());
-                vkDestroyShaderModule(vk->getDevice(), computeShader, vk->getAllocator());
+                vk->getObjectCache().releasePipelineLayout(pipelineLayout);
+                vk->getObjectCache().releaseShaderModule(computeShader);
             });
         }
     }
@@ -5,6 +5,9 @@
 #include <vulkan/vulkan.h>
 
 #include <array>
+#include <atomic>
+#include <future>
+#include <memory>
 #include <vector>
 
 namespace wire {
@@ -15,22 +18,62 @@ namespace wire {
         VulkanComputePipeline(Device* device, const ComputePipelineDesc& desc, std::string_view debugName = {});
         virtual ~VulkanComputePipeline();
         
+        virtual bool isReady() const override { return m_Ready; }
+        virtual void wait() const override;
+
+        virtual std::shared_ptr<ComputePipeline> getFallback() const override { return m_Fallback; }
+        virtual std::shared_ptr<ShaderResourceLayout> getResourceLayout() const override { return m_InputLayout.ResourceLayout; }
+        virtual std::array<uint32_t, 3> getWorkgroupSize() const override { return m_WorkgroupSize; }
+
         VkPipeline getPipeline() const { return m_Pipeline; }
         VkPipelineLayout getPipelineLayout() const { return m_Layout; }
+        const std::vector<VkPushConstantRange>& getPushConstantRanges() const { return m_PushConstantRanges; }
+
+        // rebuilds the pipeline on a worker thread from the shader currently in the cache
+        void reload();
+        // swaps in a finished reload, returns false while one is still compiling
+        bool applyReload();
+
+        const std::string& getShaderPath() const { return m_Desc.ShaderPath; }
+
+        // the candidate the next timed dispatch should use, false once tuning is done or while the pipeline compiles
+        bool getTuningCandidate(uint32_t& outCandidate, VkPipeline& outPipeline, std::array<uint32_t, 3>& outWorkgroupSize);
+        // switches to the fastest candidate once every one of them has enough samples
+        void recordTuningSample(uint32_t candidate, double time);
     protected:
         virtual void destroy() override;
         virtual void invalidate() noexcept override;
+    private:
+        void create(const ComputePipelineDesc& desc);
+        void finishTuning();
     private:
         Device* m_Device = nullptr;
 
         std::string m_DebugName;
+        ComputePipelineDesc m_Desc; // with the reflected layout filled in
 
-        const ComputeInputLayout m_InputLayout;
+        ComputeInputLayout m_InputLayout;
+        std::array<uint32_t, 3> m_WorkgroupSize = { 1, 1, 1 };
 
         VkShaderModule m_ComputeShader = nullptr;
         
         VkPipelineLayout m_Layout = nullptr;
         VkPipeline m_Pipeline = nullptr;
+        std::vector<VkPushConstantRange> m_PushConstantRanges;
+
+        std::shared_ptr<ComputePipeline> m_Fallback;
+        std::atomic<bool> m_Ready = false;
+        std::future<void> m_CompileTask;
+
+        // one pipeline per workgroup size candidate, dispatches rotate through them until a winner is picked
+        std::string m_TuningKey;
+        std::vector<std::unique_ptr<VulkanComputePipeline>> m_TuningCandidates;
+        std::vector<std::vector<double>> m_TuningSamples; // milliseconds
+        uint32_t m_NextTuningCandidate = 0;
+
+        std::unique_ptr<VulkanComputePipeline> m_ReloadedPipeline;
+        std::future<void> m_ReloadTask;
+        bool m_ReloadQueued = false;
     };
 
 }
@@ -20,6 +20,7 @@
 #include <vector>
 #include <iostream>
 #include <algorithm>
+#include <unordered_set>
 
 namespace wire {
     
@@ -34,6 +35,9 @@ namespace wire {
         "VK_LAYER_KHRONOS_validation"
     };    
 
+    // two per timed dispatch, the autotuner only needs a handful each frame
+    constexpr static uint32_t s_MaxTimestampQueries = 64;
+
     const static std::vector<const char*> s_DeviceExtensions = {
         VK_KHR_SWAPCHAIN_EXTENSION_NAME,
 #ifdef WR_PLATFORM_MAC
@@ -95,6 +99,96 @@ namespace wire {
             return requiredExtensions.empty();
         }
 
+        template<typename T>
+        static void AppendPipelineKey(std::string& key, const T& value)
+        {
+            key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        static void AppendPipelineKey(std::string& key, const std::vector<PushConstantInfo>& pushConstantInfos)
+        {
+            AppendPipelineKey(key, pushConstantInfos.size());
+            for (const auto& pushConstant : pushConstantInfos)
+            {
+                AppendPipelineKey(key, pushConstant.Size);
+                AppendPipelineKey(key, pushConstant.Offset);
+                AppendPipelineKey(key, pushConstant.Shader);
+            }
+        }
+
+        static void AppendPipelineKey(std::string& key, const std::vector<SpecializationConstant>& specializationConstants)
+        {
+            AppendPipelineKey(key, specializationConstants.size());
+            for (const auto& constant : specializationConstants)
+            {
+                AppendPipelineKey(key, constant.ID);
+                AppendPipelineKey(key, constant.Value);
+            }
+        }
+
+        // everything that affects the created pipeline, resources are identified by address
+        static std::string GetPipelineKey(const GraphicsPipelineDesc& desc)
+        {
+            std::string key = desc.ShaderPath;
+            key.push_back('\0');
+
+            AppendPipelineKey(key, desc.ShaderVariant);
+            AppendPipelineKey(key, desc.Topology);
+            AppendPipelineKey(key, desc.RenderPass.get());
+            AppendPipelineKey(key, desc.Fallback.get());
+            AppendPipelineKey(key, desc.Layout.ResourceLayout.get());
+            AppendPipelineKey(key, desc.Layout.Stride);
+            AppendPipelineKey(key, desc.Layout.InputRate);
+            AppendPipelineKey(key, desc.Layout.PushConstantInfos);
+            AppendPipelineKey(key, desc.SpecializationConstants);
+
+            AppendPipelineKey(key, desc.Layout.VertexBufferLayout.size());
+            for (const auto& element : desc.Layout.VertexBufferLayout)
+            {
+                AppendPipelineKey(key, element.Type);
+                AppendPipelineKey(key, element.Size);
+                AppendPipelineKey(key, element.Offset);
+            }
+
+            return key;
+        }
+
+        static std::string GetPipelineKey(const ComputePipelineDesc& desc)
+        {
+            std::string key = desc.ShaderPath;
+            key.push_back('\0');
+
+            AppendPipelineKey(key, desc.ShaderVariant);
+            AppendPipelineKey(key, desc.Fallback.get());
+            AppendPipelineKey(key, desc.Layout.ResourceLayout.get());
+            AppendPipelineKey(key, desc.Layout.PushConstantInfos);
+            AppendPipelineKey(key, desc.SpecializationConstants);
+            AppendPipelineKey(key, desc.WorkgroupSize);
+
+            AppendPipelineKey(key, desc.WorkgroupSizeCandidates.size());
+            for (const auto& workgroupSize : desc.WorkgroupSizeCandidates)
+                AppendPipelineKey(key, workgroupSize);
+
+            return key;
+        }
+
+        static bool IsDeviceExtensionSupported(VkPhysicalDevice device, const char* extensionName)
+        {
+            uint32_t extensionCount;
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, nullptr);
+
+            std::vector<VkExtensionProperties> availableExtensions(extensionCount);
+            vkEnumerateDeviceExtensionProperties(device, nullptr, &extensionCount, availableExtensions.data());
+
+            for (const auto& extension : availableExtensions)
+            {
+                if (std::strcmp(extension.extensionName, extensionName) == 0)
+                    return true;
+            }
+
+            return false;
+        }
+
         SwapchainSupportDetails QuerySwapchainSupport(VkPhysicalDevice device, VkSurfaceKHR surface)
         {
             SwapchainSupportDetails details;
@@ -285,12 +379,19 @@ namespace wire {
         createCommandPool();
         createDescriptorPool();
 
+        m_ObjectCache.create(this);
+
         m_Swapchain = createSwapchain(swapchainInfo);
 
         createSyncObject();
+        createTimestampQueryPools();
 
         m_ShaderCache = ShaderCache::createOrGetShaderCache(deviceInfo.ShaderCache);
-        m_FontCache = FontCache::createOrGetFontCache(deviceInfo.FontCache);
+        if (deviceInfo.ShaderCache.HotReload && !deviceInfo.ShaderCache.LoadOnly)
+            m_ShaderWatcher.start(deviceInfo.ShaderCache, m_ShaderCache);
+        // the font cache can generate its atlases with a compute pipeline
+        m_PipelineCache.create(this, deviceInfo.PipelineCachePath);
+        m_FontCache = FontCache::createOrGetFontCache(deviceInfo.FontCache, this);
     }
 
     VulkanDevice::~VulkanDevice()
@@ -309,6 +410,9 @@ namespace wire {
         VkResult result = vkWaitForFences(m_Device, 1, &m_InFlightFences[m_FrameIndex], VK_TRUE, std::numeric_limits<uint64_t>::max());
         VK_CHECK(result, "Failed to wait for Vulkan fence!");
 
+        readTimestamps();
+        applyShaderReloads();
+
         bool success = m_Swapchain->acquireNextImage(m_ImageIndex);
         if (!success)
         {
@@ -344,6 +448,9 @@ namespace wire {
             }
             m_ResourceFreeQueue[m_FrameIndex].clear();
 
+            m_TimestampSamples[m_FrameIndex].clear();
+            m_UsedTimestampQueries[m_FrameIndex] = 0;
+
             return;
         }
 
@@ -355,6 +462,10 @@ namespace wire {
         VkResult result = vkBeginCommandBuffer(m_FrameCommandBuffers[m_FrameIndex], &beginInfo);
         VK_CHECK(result, "Failed to begin Vulkan command buffer!");
 
+        // the secondary buffers executed below write the timestamps, so the reset goes first
+        if (m_UsedTimestampQueries[m_FrameIndex] > 0)
+            vkCmdResetQueryPool(m_FrameCommandBuffers[m_FrameIndex], m_TimestampQueryPools[m_FrameIndex], 0, m_UsedTimestampQueries[m_FrameIndex]);
+
         glm::vec2 extent = m_Swapchain->getExtent();
 
         for (const auto& listInfo : m_SubmittedCommandLists[m_FrameIndex])
@@ -436,6 +547,8 @@ namespace wire {
         }
         m_ResourceFreeQueue[m_FrameIndex].clear();
 
+        m_PipelineCache.onFrameEnd();
+
         m_FrameIndex = (m_FrameIndex + 1) % WR_FRAMES_IN_FLIGHT;
     }
 
@@ -484,7 +597,7 @@ namespace wire {
 
         for (const CommandScope& scope : commandList.getScopes())
         {
-            executeCommandScope(commandBuffer, scope);
+            executeCommandScope(commandBuffer, scope, false);
         }
 
         result = vkEndCommandBuffer(commandBuffer);
@@ -576,7 +689,7 @@ namespace wire {
             VkResult result = vkBeginCommandBuffer(commandBuffer, &beginInfo);
             VK_CHECK(result, "Failed to begin Vulkan command buffer!");
 
-            executeCommandScope(commandBuffer, scope);
+            executeCommandScope(commandBuffer, scope, true);
 
             result = vkEndCommandBuffer(commandBuffer);
             VK_CHECK(result, "Failed to end Vulkan command buffer!");
@@ -588,7 +701,7 @@ namespace wire {
         m_SubmittedCommandLists[m_FrameIndex].push_back(listData);
     }
 
-    void VulkanDevice::executeCommandScope(VkCommandBuffer commandBuffer, const CommandScope& commandScope)
+    void VulkanDevice::executeCommandScope(VkCommandBuffer commandBuffer, const CommandScope& commandScope, bool frameCommands)
     {
         for (const auto& command : commandScope.Commands)
         {
@@ -625,19 +738,33 @@ namespace wire {
                 const auto& args = std::get<CommandEntry::PushConstantsArgs>(command.Args);
 
                 VkPipelineLayout layout = nullptr;
+                const std::vector<VkPushConstantRange>* ranges = nullptr;
 
                 if (args.IsGraphics)
                 {
                     const VulkanGraphicsPipeline* vkPipeline = static_cast<const VulkanGraphicsPipeline*>(std::get<std::shared_ptr<GraphicsPipeline>>(args.Pipeline).get());
                     layout = vkPipeline->getPipelineLayout();
+                    ranges = &vkPipeline->getPushConstantRanges();
                 }
                 else
                 {
                     const VulkanComputePipeline* vkPipeline = static_cast<const VulkanComputePipeline*>(std::get<std::shared_ptr<ComputePipeline>>(args.Pipeline).get());
                     layout = vkPipeline->getPipelineLayout();
+                    ranges = &vkPipeline->getPushConstantRanges();
+                }
+
+                // every stage whose range overlaps the update has to be named, reflected layouts share ranges between stages
+                VkShaderStageFlags stageFlags = 0;
+                for (const auto& range : *ranges)
+                {
+                    if (range.offset < args.Offset + args.Size && args.Offset < range.offset + range.size)
+                        stageFlags |= range.stageFlags;
                 }
 
-                vkCmdPushConstants(commandBuffer, layout, Utils::ConvertShaderType(args.Stage), args.Offset, args.Size, args.Data);
+                if (stageFlags == 0)
+                    stageFlags = Utils::ConvertShaderType(args.Stage);
+
+                vkCmdPushConstants(commandBuffer, layout, stageFlags, args.Offset, args.Size, args.Data);
                 break;
             }
             case CommandType::BindShaderResource:
@@ -772,14 +899,14 @@ namespace wire {
             {
                 const auto& args = std::get<CommandEntry::DrawArgs>(command.Args);
                 
-                vkCmdDraw(commandBuffer, args.VertexCount, 1, args.VertexOffset, 0);
+                vkCmdDraw(commandBuffer, args.VertexCount, args.InstanceCount, args.VertexOffset, args.FirstInstance);
                 break;
             }
             case CommandType::DrawIndexed:
             {
                 const auto& args = std::get<CommandEntry::DrawIndexedArgs>(command.Args);
 
-                vkCmdDrawIndexed(commandBuffer, args.IndexCount, 1, args.IndexOffset, args.VertexOffset, 0);
+                vkCmdDrawIndexed(commandBuffer, args.IndexCount, args.InstanceCount, args.IndexOffset, args.VertexOffset, args.FirstInstance);
                 break;
             }
             case CommandType::Dispatch:
@@ -789,6 +916,13 @@ namespace wire {
                 vkCmdDispatch(commandBuffer, args.GroupCountX, args.GroupCountY, args.GroupCountZ);
                 break;
             }
+            case CommandType::DispatchThreads:
+            {
+                const auto& args = std::get<CommandEntry::DispatchThreadsArgs>(command.Args);
+
+                dispatchThreads(commandBuffer, args.Pipeline, args.ThreadCountX, args.ThreadCountY, args.ThreadCountZ, frameCommands);
+                break;
+            }
             case CommandType::CopyBuffer:
             {
                 const auto& args = std::get<CommandEntry::CopyBufferArgs>(command.Args);
@@ -1011,6 +1145,118 @@ namespace wire {
         }
     }
 
+    void VulkanDevice::dispatchThreads(VkCommandBuffer commandBuffer, const std::shared_ptr<ComputePipeline>& pipeline, uint32_t threadCountX, uint32_t threadCountY, uint32_t threadCountZ, bool frameCommands)
+    {
+        VulkanComputePipeline* vkPipeline = static_cast<VulkanComputePipeline*>(pipeline.get());
+
+        std::array<uint32_t, 3> workgroupSize = vkPipeline->getWorkgroupSize();
+        VkPipeline candidatePipeline = nullptr;
+        uint32_t candidate = 0;
+
+        bool timed = frameCommands
+            && m_UsedTimestampQueries[m_FrameIndex] + 2 <= s_MaxTimestampQueries
+            && vkPipeline->getTuningCandidate(candidate, candidatePipeline, workgroupSize);
+
+        uint32_t query = m_UsedTimestampQueries[m_FrameIndex];
+
+        if (timed)
+        {
+            // candidates share the pipeline layout, so the bound resources and push constants stay valid
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, candidatePipeline);
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_TOP_OF_PIPE_BIT, m_TimestampQueryPools[m_FrameIndex], query);
+        }
+
+        vkCmdDispatch(
+            commandBuffer,
+            (threadCountX + workgroupSize[0] - 1) / workgroupSize[0],
+            (threadCountY + workgroupSize[1] - 1) / workgroupSize[1],
+            (threadCountZ + workgroupSize[2] - 1) / workgroupSize[2]
+        );
+
+        if (timed)
+        {
+            vkCmdWriteTimestamp(commandBuffer, VK_PIPELINE_STAGE_BOTTOM_OF_PIPE_BIT, m_TimestampQueryPools[m_FrameIndex], query + 1);
+            vkCmdBindPipeline(commandBuffer, VK_PIPELINE_BIND_POINT_COMPUTE, vkPipeline->getPipeline());
+
+            m_UsedTimestampQueries[m_FrameIndex] += 2;
+            m_TimestampSamples[m_FrameIndex].push_back(TimestampSample{ .Pipeline = pipeline, .Candidate = candidate, .Query = query });
+        }
+    }
+
+    void VulkanDevice::readTimestamps()
+    {
+        std::vector<TimestampSample>& samples = m_TimestampSamples[m_FrameIndex];
+        uint32_t queryCount = m_UsedTimestampQueries[m_FrameIndex];
+
+        m_UsedTimestampQueries[m_FrameIndex] = 0;
+
+        if (samples.empty())
+            return;
+
+        // the frame's fence has been waited on, every query it wrote is available
+        std::vector<uint64_t> timestamps(queryCount);
+        VkResult result = vkGetQueryPoolResults(m_Device, m_TimestampQueryPools[m_FrameIndex], 0, queryCount, timestamps.size() * sizeof(uint64_t), timestamps.data(), sizeof(uint64_t), VK_QUERY_RESULT_64_BIT);
+
+        if (result == VK_SUCCESS)
+        {
+            for (const auto& sample : samples)
+            {
+                uint64_t ticks = (timestamps[sample.Query + 1] - timestamps[sample.Query]) & m_TimestampMask;
+                double time = static_cast<double>(ticks) * m_TimestampPeriod / 1000000.0;
+
+                static_cast<VulkanComputePipeline*>(sample.Pipeline.get())->recordTuningSample(sample.Candidate, time);
+            }
+        }
+
+        samples.clear();
+    }
+
+    void VulkanDevice::applyShaderReloads()
+    {
+        std::vector<ShaderGroup> groups;
+        if (m_ShaderWatcher.takeCompiledGroups(groups))
+        {
+            std::unordered_set<std::string> names;
+            for (const auto& group : groups)
+                names.insert("shadercache://" + group.Name);
+
+            m_ShaderCache.replaceGroups(std::move(groups));
+
+            for (auto& [key, weakPipeline] : m_GraphicsPipelines)
+            {
+                std::shared_ptr<GraphicsPipeline> pipeline = weakPipeline.lock();
+                if (!pipeline || !names.contains(static_cast<VulkanGraphicsPipeline*>(pipeline.get())->getShaderPath()))
+                    continue;
+
+                static_cast<VulkanGraphicsPipeline*>(pipeline.get())->reload();
+                m_ReloadingGraphicsPipelines.push_back(pipeline);
+            }
+
+            for (auto& [key, weakPipeline] : m_ComputePipelines)
+            {
+                std::shared_ptr<ComputePipeline> pipeline = weakPipeline.lock();
+                if (!pipeline || !names.contains(static_cast<VulkanComputePipeline*>(pipeline.get())->getShaderPath()))
+                    continue;
+
+                static_cast<VulkanComputePipeline*>(pipeline.get())->reload();
+                m_ReloadingComputePipelines.push_back(pipeline);
+            }
+        }
+
+        // never waits, a pipeline that is still compiling keeps rendering with its old objects
+        std::erase_if(m_ReloadingGraphicsPipelines, [](const std::weak_ptr<GraphicsPipeline>& weakPipeline)
+        {
+            std::shared_ptr<GraphicsPipeline> pipeline = weakPipeline.lock();
+            return !pipeline || static_cast<VulkanGraphicsPipeline*>(pipeline.get())->applyReload();
+        });
+
+        std::erase_if(m_ReloadingComputePipelines, [](const std::weak_ptr<ComputePipeline>& weakPipeline)
+        {
+            std::shared_ptr<ComputePipeline> pipeline = weakPipeline.lock();
+            return !pipeline || static_cast<VulkanComputePipeline*>(pipeline.get())->applyReload();
+        });
+    }
+
     void VulkanDevice::submitResourceFree(std::function<void(Device*)>&& func)
     {
         if (!m_Valid)
@@ -1131,6 +1377,33 @@ namespace wire {
         return layout;
     }
 
+    std::shared_ptr<ShaderResourceLayout> VulkanDevice::getOrCreateShaderResourceLayout(const ShaderResourceLayoutInfo& layoutInfo, std::string_view debugName)
+    {
+        std::string key;
+        for (uint32_t set = 0; set < layoutInfo.Sets.size(); set++)
+        {
+            for (const auto& resource : layoutInfo.Sets[set].Resources)
+            {
+                uint32_t fields[] = { set, resource.Binding, static_cast<uint32_t>(resource.Type), resource.ArrayCount, static_cast<uint32_t>(resource.Stage) };
+                key.append(reinterpret_cast<const char*>(fields), sizeof(fields));
+            }
+        }
+
+        if (key.empty())
+            return nullptr;
+
+        if (auto it = m_ReflectedLayouts.find(key); it != m_ReflectedLayouts.end())
+        {
+            if (std::shared_ptr<ShaderResourceLayout> layout = it->second.lock())
+                return layout;
+        }
+
+        std::shared_ptr<ShaderResourceLayout> layout = createShaderResourceLayout(layoutInfo, debugName);
+        m_ReflectedLayouts[key] = layout;
+
+        return layout;
+    }
+
     std::shared_ptr<ShaderResource> VulkanDevice::createShaderResource(uint32_t set, const std::shared_ptr<ShaderResourceLayout>& layout, std::string_view debugName)
     {
         if (!m_Valid)
@@ -1153,8 +1426,27 @@ namespace wire {
             return nullptr;
         }
         
+        std::string key = Utils::GetPipelineKey(desc);
+        if (auto it = m_GraphicsPipelines.find(key); it != m_GraphicsPipelines.end())
+        {
+            if (std::shared_ptr<GraphicsPipeline> pipeline = it->second.lock())
+            {
+                // the pipeline may have been created async, a synchronous caller expects it to be usable right away
+                if (!desc.CompileAsync)
+                    pipeline->wait();
+
+                m_ObjectCache.recordPipelineLookup(true);
+                return pipeline;
+            }
+        }
+
+        std::erase_if(m_GraphicsPipelines, [](const auto& entry) { return entry.second.expired(); });
+
         auto graphicsPipeline = std::make_shared<VulkanGraphicsPipeline>(this, desc, debugName);
         m_Resources.push_back(graphicsPipeline);
+
+        m_GraphicsPipelines[key] = graphicsPipeline;
+        m_ObjectCache.recordPipelineLookup(false);
         
         return graphicsPipeline;
     }
@@ -1167,8 +1459,27 @@ namespace wire {
             return nullptr;
         }
         
+        std::string key = Utils::GetPipelineKey(desc);
+        if (auto it = m_ComputePipelines.find(key); it != m_ComputePipelines.end())
+        {
+            if (std::shared_ptr<ComputePipeline> pipeline = it->second.lock())
+            {
+                // the pipeline may have been created async, a synchronous caller expects it to be usable right away
+                if (!desc.CompileAsync)
+                    pipeline->wait();
+
+                m_ObjectCache.recordPipelineLookup(true);
+                return pipeline;
+            }
+        }
+
+        std::erase_if(m_ComputePipelines, [](const auto& entry) { return entry.second.expired(); });
+
         auto computePipeline = std::make_shared<VulkanComputePipeline>(this, desc, debugName);
         m_Resources.push_back(computePipeline);
+
+        m_ComputePipelines[key] = computePipeline;
+        m_ObjectCache.recordPipelineLookup(false);
         
         return computePipeline;
     }
@@ -1201,6 +1512,20 @@ namespace wire {
         return texture;
     }
 
+    std::shared_ptr<Texture2D> VulkanDevice::createTexture2D(const void* data, uint32_t width, uint32_t height, TextureFormat format, std::string_view debugName)
+    {
+        if (!m_Valid)
+        {
+            WR_ASSERT_OR_WARN(false, "Device used after destroyed");
+            return nullptr;
+        }
+        
+        auto texture = std::make_shared<VulkanTexture2D>(this, data, width, height, format, debugName);
+        m_Resources.push_back(texture);
+        
+        return texture;
+    }
+
     std::shared_ptr<Sampler> VulkanDevice::createSampler(const SamplerDesc& desc, std::string_view debugName)
     {
         if (!m_Valid)
@@ -1258,6 +1583,25 @@ namespace wire {
         return nullptr;
     }
 
+    PipelineStatistics VulkanDevice::getPipelineStatistics() const
+    {
+        PipelineStatistics statistics = m_PipelineCache.getStatistics();
+        m_ObjectCache.getStatistics(statistics);
+
+        statistics.Pipelines.Live = 0;
+        for (const auto& [key, pipeline] : m_GraphicsPipelines)
+            statistics.Pipelines.Live += pipeline.expired() ? 0 : 1;
+        for (const auto& [key, pipeline] : m_ComputePipelines)
+            statistics.Pipelines.Live += pipeline.expired() ? 0 : 1;
+
+        return statistics;
+    }
+
+    void VulkanDevice::recordPipelineCreation(const VkPipelineCreationFeedbackEXT& feedback, double creationTime)
+    {
+        m_PipelineCache.recordCreation(feedback, m_SupportsPipelineCreationFeedback, creationTime);
+    }
+
     float VulkanDevice::getMaxAnisotropy() const
     {
         if (!m_Valid)
@@ -1276,6 +1620,8 @@ namespace wire {
     {
         if (m_Valid && m_Instance)
         {
+            m_ShaderWatcher.stop();
+
             vkDeviceWaitIdle(m_Device);
             
             m_Swapchain = nullptr;
@@ -1287,6 +1633,14 @@ namespace wire {
             }
             
             m_FontCache.release();
+
+            // pipelines are gone, so nothing reads the cache anymore. saves the next startup from recompiling
+            if (m_ShaderWatcher.hasRecompiled())
+                m_ShaderCache.outputToFile(m_ShaderWatcher.getCachePath());
+
+            m_ReloadingGraphicsPipelines.clear();
+            m_ReloadingComputePipelines.clear();
+            m_TimestampSamples.clear();
             
             for (auto& queue : m_ResourceFreeQueue)
             {
@@ -1298,6 +1652,10 @@ namespace wire {
             
             for (VkFence fence : m_InFlightFences)
                 vkDestroyFence(m_Device, fence, getAllocator());
+
+            for (VkQueryPool queryPool : m_TimestampQueryPools)
+                vkDestroyQueryPool(m_Device, queryPool, getAllocator());
+            m_TimestampQueryPools.clear();
             
             for (VkSemaphore semaphore : m_ImageAvailableSemaphores)
                 vkDestroySemaphore(m_Device, semaphore, getAllocator());
@@ -1307,6 +1665,12 @@ namespace wire {
                 vkDestroySemaphore(m_Device, semaphore, getAllocator());
             m_RenderFinishedSemaphores.clear();
             
+            m_GraphicsPipelines.clear();
+            m_ComputePipelines.clear();
+
+            m_PipelineCache.destroy();
+            m_ObjectCache.destroy();
+
             vkDestroyDescriptorPool(m_Device, m_DescriptorPool, getAllocator());
             vkDestroyCommandPool(m_Device, m_CommandPool, getAllocator());
             m_FrameCommandBuffers.clear();
@@ -1468,17 +1832,30 @@ namespace wire {
             queueCreateInfo.pQueuePriorities = &queuePriority;
         }
 
+        std::vector<const char*> extensions = s_DeviceExtensions;
+
+        m_SupportsPipelineCreationFeedback = Utils::IsDeviceExtensionSupported(m_PhysicalDevice, VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+        if (m_SupportsPipelineCreationFeedback)
+            extensions.push_back(VK_EXT_PIPELINE_CREATION_FEEDBACK_EXTENSION_NAME);
+
+        VkPhysicalDeviceFeatures supportedFeatures;
+        vkGetPhysicalDeviceFeatures(m_PhysicalDevice, &supportedFeatures);
+
+        // optional, only the compute font atlas generator needs it
+        m_SupportsShaderFloat64 = supportedFeatures.shaderFloat64;
+
         VkPhysicalDeviceFeatures deviceFeatures{};
         deviceFeatures.sampleRateShading = VK_TRUE;
         deviceFeatures.samplerAnisotropy = VK_TRUE;
+        deviceFeatures.shaderFloat64 = m_SupportsShaderFloat64 ? VK_TRUE : VK_FALSE;
 
         VkDeviceCreateInfo createInfo{};
         createInfo.sType = VK_STRUCTURE_TYPE_DEVICE_CREATE_INFO;
         createInfo.queueCreateInfoCount = (uint32_t)queueCreateInfos.size();
         createInfo.pQueueCreateInfos = queueCreateInfos.data();
         createInfo.pEnabledFeatures = &deviceFeatures;
-        createInfo.enabledExtensionCount = (uint32_t)s_DeviceExtensions.size();
-        createInfo.ppEnabledExtensionNames = s_DeviceExtensions.data();
+        createInfo.enabledExtensionCount = (uint32_t)extensions.size();
+        createInfo.ppEnabledExtensionNames = extensions.data();
 
         if (s_EnableValidationLayers)
         {
@@ -1636,6 +2013,49 @@ namespace wire {
         }
     }
     
+    void VulkanDevice::createTimestampQueryPools()
+    {
+        VkPhysicalDeviceProperties properties;
+        vkGetPhysicalDeviceProperties(m_PhysicalDevice, &properties);
+        m_Limits = properties.limits;
+
+        uint32_t queueFamilyCount = 0;
+        vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, nullptr);
+
+        std::vector<VkQueueFamilyProperties> queueFamilies(queueFamilyCount);
+        vkGetPhysicalDeviceQueueFamilyProperties(m_PhysicalDevice, &queueFamilyCount, queueFamilies.data());
+
+        uint32_t validBits = queueFamilies[getGraphicsQueueFamily()].timestampValidBits;
+
+        m_UsedTimestampQueries.resize(WR_FRAMES_IN_FLIGHT);
+        m_TimestampSamples.resize(WR_FRAMES_IN_FLIGHT);
+
+        if (!m_Limits.timestampComputeAndGraphics || validBits == 0)
+        {
+            WR_WARN("Device does not support timestamp queries, compute workgroup sizes will not be autotuned");
+            return;
+        }
+
+        m_TimestampPeriod = m_Limits.timestampPeriod;
+        m_TimestampMask = validBits >= 64 ? ~0ull : (1ull << validBits) - 1;
+
+        VkQueryPoolCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_QUERY_POOL_CREATE_INFO;
+        createInfo.queryType = VK_QUERY_TYPE_TIMESTAMP;
+        createInfo.queryCount = s_MaxTimestampQueries;
+
+        m_TimestampQueryPools.resize(WR_FRAMES_IN_FLIGHT);
+
+        for (size_t i = 0; i < WR_FRAMES_IN_FLIGHT; i++)
+        {
+            VkResult result = vkCreateQueryPool(m_Device, &createInfo, getAllocator(), &m_TimestampQueryPools[i]);
+            VK_CHECK(result, "Failed to create Vulkan query pool!");
+
+            std::string queryPoolName = "VulkanRenderer::m_TimestampQueryPools[" + std::to_string(i) + "]";
+            VK_DEBUG_NAME(m_Device, QUERY_POOL, m_TimestampQueryPools[i], queryPoolName.c_str());
+        }
+    }
+
     void VulkanDevice::loadExtensions()
     {
         exts::vkSetDebugUtilsObjectNameEXT = (PFN_vkSetDebugUtilsObjectNameEXT)vkGetDeviceProcAddr(m_Device, "vkSetDebugUtilsObjectNameEXT");
@@ -1,12 +1,18 @@
 #pragma once
 
 #include "VulkanInstance.h"
+#include "VulkanObjectCache.h"
+#include "VulkanPipelineCache.h"
 #include "Wire/Renderer/Device.h"
+#include "Wire/Renderer/ShaderWatcher.h"
 
 #include <vulkan/vulkan.h>
 
+#include <array>
 #include <memory>
+#include <string>
 #include <vector>
+#include <unordered_map>
 
 struct GLFWwindow;
 
@@ -93,6 +99,7 @@ namespace wire {
         virtual std::shared_ptr<ComputePipeline> createComputePipeline(const ComputePipelineDesc& desc, std::string_view debugName = {}) override;
         virtual std::shared_ptr<Texture2D> createTexture2D(const std::filesystem::path& path, std::string_view debugName = {}) override;
         virtual std::shared_ptr<Texture2D> createTexture2D(uint32_t* data, uint32_t width, uint32_t height, std::string_view debugName = {}) override;
+        virtual std::shared_ptr<Texture2D> createTexture2D(const void* data, uint32_t width, uint32_t height, TextureFormat format, std::string_view debugName = {}) override;
         virtual std::shared_ptr<Sampler> createSampler(const SamplerDesc& desc, std::string_view debugName = {}) override;
         virtual std::shared_ptr<Font> createFont(const std::filesystem::path& path, std::string_view debugName = {}, uint32_t minChar = 0x0020, uint32_t maxChar = 0x00FF) override;
         virtual std::shared_ptr<Font> getFontFromCache(const std::filesystem::path& path) override;
@@ -103,6 +110,8 @@ namespace wire {
         virtual const FontCache& getFontCache() const override { return m_FontCache; }
 
         virtual float getMaxAnisotropy() const override;
+        virtual bool supportsShaderFloat64() const override { return m_SupportsShaderFloat64; }
+        virtual PipelineStatistics getPipelineStatistics() const override;
 
         VkCommandBuffer beginCommandListOverride(const std::shared_ptr<RenderPass>& renderPass = nullptr);
         void endCommandListOverride();
@@ -113,6 +122,20 @@ namespace wire {
         VkQueue getGraphicsQueue() const { return m_GraphicsQueue; }
         const VkAllocationCallbacks* getAllocator() const { return m_Instance->getAllocator(); }
         VkDescriptorPool getDescriptorPool() const { return m_DescriptorPool; }
+        VkPipelineCache getPipelineCache() const { return m_PipelineCache.getPipelineCache(); }
+        VulkanObjectCache& getObjectCache() { return m_ObjectCache; }
+
+        // shared between pipelines whose shaders reflect to the same layout, nullptr when there is nothing to bind
+        std::shared_ptr<ShaderResourceLayout> getOrCreateShaderResourceLayout(const ShaderResourceLayoutInfo& layoutInfo, std::string_view debugName = {});
+
+        bool supportsPipelineCreationFeedback() const { return m_SupportsPipelineCreationFeedback; }
+        void recordPipelineCreation(const VkPipelineCreationFeedbackEXT& feedback, double creationTime);
+
+        // compute workgroup size autotuning, see ComputePipelineDesc::WorkgroupSizeCandidates
+        bool supportsTimestamps() const { return m_TimestampPeriod > 0.0f; }
+        const VkPhysicalDeviceLimits& getLimits() const { return m_Limits; }
+        bool getTunedWorkgroupSize(const std::string& key, std::array<uint32_t, 3>& outWorkgroupSize) const { return m_PipelineCache.getTunedWorkgroupSize(key, outWorkgroupSize); }
+        void setTunedWorkgroupSize(const std::string& key, const std::array<uint32_t, 3>& workgroupSize) { m_PipelineCache.setTunedWorkgroupSize(key, workgroupSize); }
 
         VkSurfaceKHR getSurface() const { return m_Instance->getSurface(); }
 
@@ -131,10 +154,18 @@ namespace wire {
         void createCommandPool();
         void createDescriptorPool();
         void createSyncObject();
+        void createTimestampQueryPools();
 
         void loadExtensions();
 
-        void executeCommandScope(VkCommandBuffer commandBuffer, const CommandScope& commandScope);
+        // frame commands may time dispatches for the autotuner, single time commands never do
+        void executeCommandScope(VkCommandBuffer commandBuffer, const CommandScope& commandScope, bool frameCommands);
+        void dispatchThreads(VkCommandBuffer commandBuffer, const std::shared_ptr<ComputePipeline>& pipeline, uint32_t threadCountX, uint32_t threadCountY, uint32_t threadCountZ, bool frameCommands);
+        // hands the timings of the frame that just finished to the pipelines being tuned
+        void readTimestamps();
+
+        // installs shaders the watcher recompiled and swaps in pipelines that finished rebuilding
+        void applyShaderReloads();
     private:
         struct CommandListData
         {
@@ -142,6 +173,13 @@ namespace wire {
             std::vector<CommandScope::Type> Types;
             std::vector<std::shared_ptr<RenderPass>> RenderPasses;
         };
+
+        struct TimestampSample
+        {
+            std::shared_ptr<ComputePipeline> Pipeline;
+            uint32_t Candidate;
+            uint32_t Query; // begin, the end is the next query
+        };
     private:
         VulkanInstance* m_Instance = nullptr;
 
@@ -162,6 +200,16 @@ namespace wire {
 
         bool m_SkipFrame = false;
         bool m_DidSwapchainResize = false;
+        bool m_SupportsPipelineCreationFeedback = false;
+        bool m_SupportsShaderFloat64 = false;
+
+        VkPhysicalDeviceLimits m_Limits{};
+        float m_TimestampPeriod = 0.0f; // nanoseconds per tick, 0 = timestamps are unsupported
+        uint64_t m_TimestampMask = 0;
+
+        std::vector<VkQueryPool> m_TimestampQueryPools;
+        std::vector<uint32_t> m_UsedTimestampQueries;
+        std::vector<std::vector<TimestampSample>> m_TimestampSamples;
 
         std::vector<std::vector<VkCommandBuffer>> m_SecondaryCommandBufferPool;
         std::vector<uint32_t> m_UsedSecondaryCommandBufferCount;
@@ -175,6 +223,17 @@ namespace wire {
 
         ShaderCache m_ShaderCache;
         FontCache m_FontCache;
+        VulkanPipelineCache m_PipelineCache;
+        VulkanObjectCache m_ObjectCache;
+        ShaderWatcher m_ShaderWatcher;
+
+        // identical descs return the same pipeline while it is alive
+        std::unordered_map<std::string, std::weak_ptr<GraphicsPipeline>> m_GraphicsPipelines;
+        std::unordered_map<std::string, std::weak_ptr<ComputePipeline>> m_ComputePipelines;
+        std::unordered_map<std::string, std::weak_ptr<ShaderResourceLayout>> m_ReflectedLayouts;
+
+        std::vector<std::weak_ptr<GraphicsPipeline>> m_ReloadingGraphicsPipelines;
+        std::vector<std::weak_ptr<ComputePipeline>> m_ReloadingComputePipelines;
 
         std::vector<std::vector<std::function<void(Device*)>>> m_ResourceFreeQueue;
     };
@@ -2,9 +2,6 @@
 
 #include "Wire/Renderer/Device.h"
 
-#undef INFINITE
-#include <msdf-atlas-gen.h>
-
 #include <vector>
 #include <filesystem>
 
@@ -19,7 +16,7 @@ namespace wire {
         virtual ~VulkanFont();
 
         virtual const std::shared_ptr<Texture2D>& getAtlasTexture() const override { return m_AtlasTexture; }
-        virtual const MSDFData& getMSDFData() const override { return *m_Data; }
+        virtual const MSDFData& getMSDFData() const override { return m_Data; }
     protected:
         virtual void destroy() override;
         virtual void invalidate() noexcept override;
@@ -30,7 +27,7 @@ namespace wire {
 
         std::string m_DebugName;
 
-        MSDFData* m_Data = nullptr;
+        MSDFData m_Data;
         std::shared_ptr<Texture2D> m_AtlasTexture = nullptr;
     };
 
@@ -7,11 +7,14 @@
 #include "VulkanShaderResource.h"
 
 #include "Wire/Core/Assert.h"
+#include "Wire/Core/ThreadPool.h"
 
 #include <vulkan/vulkan.h>
 
 #include <array>
 #include <vector>
+#include <chrono>
+#include <algorithm>
 
 namespace wire {
 
@@ -72,6 +75,128 @@ namespace wire {
             return VkDescriptorType(0);
         }
 
+        ShaderResourceLayoutInfo GetReflectedLayoutInfo(std::span<const ShaderObjectView> stages)
+        {
+            ShaderResourceLayoutInfo layoutInfo{};
+
+            for (const auto& stage : stages)
+            {
+                if (!stage.Reflection)
+                    continue;
+
+                for (const auto& resource : stage.Reflection->Resources)
+                {
+                    if (layoutInfo.Sets.size() <= resource.Set)
+                        layoutInfo.Sets.resize(resource.Set + 1);
+
+                    layoutInfo.Sets[resource.Set].Resources.push_back(ShaderResourceInfo{
+                        .Binding = resource.Binding,
+                        .Type = resource.Type,
+                        .ArrayCount = resource.ArrayCount,
+                        .Stage = stage.Type
+                    });
+                }
+            }
+
+            return layoutInfo;
+        }
+
+        std::vector<PushConstantInfo> GetReflectedPushConstants(std::span<const ShaderObjectView> stages)
+        {
+            std::vector<PushConstantInfo> pushConstants;
+
+            for (const auto& stage : stages)
+            {
+                if (!stage.Reflection || stage.Reflection->PushConstantSize == 0)
+                    continue;
+
+                pushConstants.push_back(PushConstantInfo{
+                    .Size = stage.Reflection->PushConstantSize,
+                    .Offset = stage.Reflection->PushConstantOffset,
+                    .Shader = stage.Type
+                });
+            }
+
+            return pushConstants;
+        }
+
+        void ValidateReflectedLayout(std::span<const ShaderObjectView> stages, const std::shared_ptr<ShaderResourceLayout>& resourceLayout, const std::vector<PushConstantInfo>& pushConstants, std::string_view debugName)
+        {
+            const ShaderResourceLayoutInfo* layoutInfo = resourceLayout ? &static_cast<VulkanShaderResourceLayout*>(resourceLayout.get())->getInfo() : nullptr;
+
+            for (const auto& stage : stages)
+            {
+                if (!stage.Reflection)
+                    continue;
+
+                for (const auto& resource : stage.Reflection->Resources)
+                {
+                    const ShaderResourceInfo* declared = nullptr;
+                    if (layoutInfo && resource.Set < layoutInfo->Sets.size())
+                    {
+                        for (const auto& info : layoutInfo->Sets[resource.Set].Resources)
+                        {
+                            if (info.Binding == resource.Binding)
+                                declared = &info;
+                        }
+                    }
+
+                    if (!declared)
+                        WR_WARN("{}: set {} binding {} is used by the {} shader but missing from the layout", debugName, resource.Set, resource.Binding, stage.EntryPoint);
+                    else if (declared->Type != resource.Type || declared->ArrayCount < resource.ArrayCount)
+                        WR_WARN("{}: set {} binding {} does not match its declaration in the {} shader", debugName, resource.Set, resource.Binding, stage.EntryPoint);
+                }
+
+                uint32_t pushConstantEnd = stage.Reflection->PushConstantOffset + stage.Reflection->PushConstantSize;
+                if (stage.Reflection->PushConstantSize == 0)
+                    continue;
+
+                bool covered = std::any_of(pushConstants.begin(), pushConstants.end(), [&](const PushConstantInfo& info)
+                {
+                    return info.Shader == stage.Type && info.Offset <= stage.Reflection->PushConstantOffset && info.Offset + info.Size >= pushConstantEnd;
+                });
+
+                if (!covered)
+                    WR_WARN("{}: push constants of the {} shader ({} bytes at offset {}) are not covered by the layout", debugName, stage.EntryPoint, stage.Reflection->PushConstantSize, stage.Reflection->PushConstantOffset);
+            }
+        }
+
+        void ValidateSpecializationConstants(std::span<const ShaderObjectView> stages, const std::vector<SpecializationConstant>& constants, std::string_view debugName)
+        {
+            for (const auto& constant : constants)
+            {
+                bool declared = std::any_of(stages.begin(), stages.end(), [&constant](const ShaderObjectView& stage)
+                {
+                    return stage.Reflection && std::find(stage.Reflection->SpecializationConstants.begin(), stage.Reflection->SpecializationConstants.end(), constant.ID) != stage.Reflection->SpecializationConstants.end();
+                });
+
+                if (!declared)
+                    WR_WARN("{}: specialization constant {} is not declared by any stage", debugName, constant.ID);
+            }
+        }
+
+        VkSpecializationInfo GetSpecializationInfo(const std::vector<SpecializationConstant>& constants, std::vector<VkSpecializationMapEntry>& outEntries)
+        {
+            outEntries.clear();
+            outEntries.reserve(constants.size());
+
+            for (size_t i = 0; i < constants.size(); i++)
+            {
+                VkSpecializationMapEntry& entry = outEntries.emplace_back();
+                entry.constantID = constants[i].ID;
+                entry.offset = static_cast<uint32_t>(i * sizeof(SpecializationConstant) + offsetof(SpecializationConstant, Value));
+                entry.size = sizeof(uint32_t);
+            }
+
+            VkSpecializationInfo specializationInfo{};
+            specializationInfo.mapEntryCount = static_cast<uint32_t>(outEntries.size());
+            specializationInfo.pMapEntries = outEntries.data();
+            specializationInfo.dataSize = constants.size() * sizeof(SpecializationConstant);
+            specializationInfo.pData = constants.data();
+
+            return specializationInfo;
+        }
+
         static VkPrimitiveTopology ConvertPrimitiveTopology(PrimitiveTopology topology)
         {
             switch (topology)
@@ -90,7 +215,7 @@ namespace wire {
             VkVertexInputBindingDescription bindingDescription{};
             bindingDescription.binding = 0;
             bindingDescription.stride = (uint32_t)layout.Stride;
-            bindingDescription.inputRate = VK_VERTEX_INPUT_RATE_VERTEX;
+            bindingDescription.inputRate = layout.InputRate == VertexInputRate::Instance ? VK_VERTEX_INPUT_RATE_INSTANCE : VK_VERTEX_INPUT_RATE_VERTEX;
 
             return bindingDescription;
         }
@@ -115,35 +240,58 @@ namespace wire {
     }
 
     VulkanGraphicsPipeline::VulkanGraphicsPipeline(Device* device, const GraphicsPipelineDesc& desc, std::string_view debugName)
-        : m_Device((VulkanDevice*)device), m_RenderPass(desc.RenderPass), m_ShaderResourceLayout(desc.Layout.ResourceLayout), m_DebugName(debugName)
+        : m_Device((VulkanDevice*)device), m_DebugName(debugName), m_RenderPass(desc.RenderPass), m_Fallback(desc.Fallback)
     {
-        ShaderCache& cache = device->getShaderCache();
+        ShaderResult shaderResult = m_Device->getShaderCache().getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, true, desc.ShaderVariant);
+        std::array stages = { shaderResult.VertexOrCompute, shaderResult.Pixel };
 
-        ShaderResult shaderResult = cache.getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, true);
+        // anything left out of the desc is taken from the shader itself
+        GraphicsPipelineDesc createDesc = desc;
+        if (!createDesc.Layout.ResourceLayout)
+            createDesc.Layout.ResourceLayout = m_Device->getOrCreateShaderResourceLayout(Utils::GetReflectedLayoutInfo(stages), m_DebugName + " (reflected layout)");
+        if (createDesc.Layout.PushConstantInfos.empty())
+            createDesc.Layout.PushConstantInfos = Utils::GetReflectedPushConstants(stages);
 
-        VkShaderModuleCreateInfo moduleInfo{};
-        moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
-        moduleInfo.codeSize = shaderResult.VertexOrCompute.Bytecode.size();
-        moduleInfo.pCode = reinterpret_cast<uint32_t*>(shaderResult.VertexOrCompute.Bytecode.data());
+        Utils::ValidateReflectedLayout(stages, createDesc.Layout.ResourceLayout, createDesc.Layout.PushConstantInfos, m_DebugName);
+        Utils::ValidateSpecializationConstants(stages, createDesc.SpecializationConstants, m_DebugName);
 
-        VulkanDevice* vk = m_Device;
+        m_ShaderResourceLayout = createDesc.Layout.ResourceLayout;
 
-        VkResult result = vkCreateShaderModule(vk->getDevice(), &moduleInfo, vk->getAllocator(), &m_VertexShader);
-        VK_CHECK(result, "Failed to create Vulkan shader module!");
+        // reloads keep the layout, resources bound against it stay compatible
+        m_Desc = createDesc;
+        m_Desc.CompileAsync = false;
+        m_Desc.Fallback = nullptr;
 
-        std::string workingDebugName = m_DebugName;
-        workingDebugName += " (vertex shader module)";
-        VK_DEBUG_NAME(vk->getDevice(), SHADER_MODULE, m_VertexShader, workingDebugName.c_str());
+        if (desc.CompileAsync)
+        {
+            m_CompileTask = ThreadPool::shared().submit([this, createDesc]()
+            {
+                create(createDesc);
+                m_Ready = true;
+            });
+        }
+        else
+        {
+            create(createDesc);
+            m_Ready = true;
+        }
+    }
+
+    void VulkanGraphicsPipeline::create(const GraphicsPipelineDesc& desc)
+    {
+        ShaderCache& cache = m_Device->getShaderCache();
+
+        ShaderResult shaderResult = cache.getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, true, desc.ShaderVariant);
 
-        moduleInfo.codeSize = shaderResult.Pixel.Bytecode.size();
-        moduleInfo.pCode = reinterpret_cast<uint32_t*>(shaderResult.Pixel.Bytecode.data());
+        VulkanDevice* vk = m_Device;
 
-        result = vkCreateShaderModule(vk->getDevice(), &moduleInfo, vk->getAllocator(), &m_PixelShader);
-        VK_CHECK(result, "Failed to create Vulkan shader module!");
+        std::string workingDebugName = m_DebugName;
+        workingDebugName += " (vertex shader module)";
+        m_VertexShader = vk->getObjectCache().acquireShaderModule(shaderResult.VertexOrCompute.Bytecode, workingDebugName);
 
         workingDebugName = m_DebugName;
         workingDebugName += " (pixel shader module)";
-        VK_DEBUG_NAME(vk->getDevice(), SHADER_MODULE, m_PixelShader, workingDebugName.c_str());
+        m_PixelShader = vk->getObjectCache().acquireShaderModule(shaderResult.Pixel.Bytecode, workingDebugName);
 
         VkPipelineShaderStageCreateInfo vertexShaderStageInfo{};
         vertexShaderStageInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_SHADER_STAGE_CREATE_INFO;
@@ -157,6 +305,15 @@ namespace wire {
         pixelShaderStageInfo.module = m_PixelShader;
         pixelShaderStageInfo.pName = "PShader";
 
+        std::vector<VkSpecializationMapEntry> specializationEntries;
+        VkSpecializationInfo specializationInfo = Utils::GetSpecializationInfo(desc.SpecializationConstants, specializationEntries);
+
+        if (!desc.SpecializationConstants.empty())
+        {
+            vertexShaderStageInfo.pSpecializationInfo = &specializationInfo;
+            pixelShaderStageInfo.pSpecializationInfo = &specializationInfo;
+        }
+
         std::array shaderStages = { vertexShaderStageInfo, pixelShaderStageInfo };
 
         std::vector<VkDynamicState> dynamicStates = {
@@ -259,19 +416,10 @@ namespace wire {
         if (vkShaderResourceLayout)
             setLayouts = vkShaderResourceLayout->getLayouts();
 
-        VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
-        pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
-        pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
-        pipelineLayoutInfo.pSetLayouts = setLayouts.data();
-        pipelineLayoutInfo.pushConstantRangeCount = (uint32_t)pushConstantRanges.size();
-        pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
-
-        result = vkCreatePipelineLayout(vk->getDevice(), &pipelineLayoutInfo, vk->getAllocator(), &m_PipelineLayout);
-        VK_CHECK(result, "Failed to create Vulkan pipeline layout!");
-
         workingDebugName = m_DebugName;
         workingDebugName += " (pipeline layout)";
-        VK_DEBUG_NAME(vk->getDevice(), PIPELINE_LAYOUT, m_PipelineLayout, workingDebugName.c_str());
+        m_PipelineLayout = vk->getObjectCache().acquirePipelineLayout(setLayouts, pushConstantRanges, workingDebugName);
+        m_PushConstantRanges = pushConstantRanges;
 
         VkGraphicsPipelineCreateInfo pipelineInfo{};
         pipelineInfo.sType = VK_STRUCTURE_TYPE_GRAPHICS_PIPELINE_CREATE_INFO;
@@ -289,9 +437,21 @@ namespace wire {
         pipelineInfo.renderPass = ((VulkanRenderPass*)m_RenderPass.get())->getRenderPass();
         pipelineInfo.subpass = 0;
 
-        result = vkCreateGraphicsPipelines(vk->getDevice(), 0, 1, &pipelineInfo, vk->getAllocator(), &m_Pipeline);
+        VkPipelineCreationFeedbackEXT creationFeedback{};
+        VkPipelineCreationFeedbackCreateInfoEXT feedbackInfo{};
+        feedbackInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CREATION_FEEDBACK_CREATE_INFO_EXT;
+        feedbackInfo.pPipelineCreationFeedback = &creationFeedback;
+
+        if (vk->supportsPipelineCreationFeedback())
+            pipelineInfo.pNext = &feedbackInfo;
+
+        auto start = std::chrono::high_resolution_clock::now();
+
+        VkResult result = vkCreateGraphicsPipelines(vk->getDevice(), vk->getPipelineCache(), 1, &pipelineInfo, vk->getAllocator(), &m_Pipeline);
         VK_CHECK(result, "Failed to create Vulkan graphics pipeline!");
 
+        vk->recordPipelineCreation(creationFeedback, std::chrono::duration<double, std::milli>(std::chrono::high_resolution_clock::now() - start).count());
+
         workingDebugName = m_DebugName;
         workingDebugName += " (pipeline)";
         VK_DEBUG_NAME(vk->getDevice(), PIPELINE, m_Pipeline, workingDebugName.c_str());
@@ -302,8 +462,75 @@ namespace wire {
         destroy();
     }
 
+    void VulkanGraphicsPipeline::wait() const
+    {
+        if (m_CompileTask.valid())
+            m_CompileTask.wait();
+    }
+
+    void VulkanGraphicsPipeline::reload()
+    {
+        if (m_ReloadTask.valid())
+        {
+            m_ReloadQueued = true;
+            return;
+        }
+
+        // the device's layout containers belong to this thread, so a layout the edited shader now needs is made here
+        GraphicsPipelineDesc desc = m_Desc;
+        if (!desc.Layout.ResourceLayout)
+        {
+            ShaderResult shaderResult = m_Device->getShaderCache().getShaderFromURL(desc.ShaderPath, RendererAPI::Vulkan, true, desc.ShaderVariant);
+            std::array stages = { shaderResult.VertexOrCompute, shaderResult.Pixel };
+            desc.Layout.ResourceLayout = m_Device->getOrCreateShaderResourceLayout(Utils::GetReflectedLayoutInfo(stages), m_DebugName + " (reflected layout)");
+        }
+
+        m_ReloadTask = ThreadPool::shared().submit([this, desc]()
+        {
+            m_ReloadedPipeline = std::make_unique<VulkanGraphicsPipeline>(m_Device, desc, m_DebugName);
+        });
+    }
+
+    bool VulkanGraphicsPipeline::applyReload()
+    {
+        if (!m_ReloadTask.valid())
+            return true;
+
+        if (m_ReloadTask.wait_for(std::chrono::seconds(0)) != std::future_status::ready)
+            return false;
+
+        m_ReloadTask.get();
+
+        std::swap(m_VertexShader, m_ReloadedPipeline->m_VertexShader);
+        std::swap(m_PixelShader, m_ReloadedPipeline->m_PixelShader);
+        std::swap(m_PipelineLayout, m_ReloadedPipeline->m_PipelineLayout);
+        std::swap(m_Pipeline, m_ReloadedPipeline->m_Pipeline);
+        std::swap(m_PushConstantRanges, m_ReloadedPipeline->m_PushConstantRanges);
+        std::swap(m_ShaderResourceLayout, m_ReloadedPipeline->m_ShaderResourceLayout);
+        m_Desc.Layout.ResourceLayout = m_ShaderResourceLayout;
+
+        // frees the old objects through the resource free queue, after the frames using them are done
+        m_ReloadedPipeline.reset();
+
+        if (m_ReloadQueued)
+        {
+            m_ReloadQueued = false;
+            reload();
+
+            return false;
+        }
+
+        return true;
+    }
+
     void VulkanGraphicsPipeline::destroy()
     {
+        wait();
+
+        if (m_ReloadTask.valid())
+            m_ReloadTask.wait();
+        m_ReloadedPipeline.reset();
+
         if (m_Valid && m_Device)
         {
             m_Device->submitResourceFree(
@@ -313,9 +540,9 @@ namespace wire {
                     VulkanDevice* vk = (VulkanDevice*)device;
 
                     vkDestroyPipeline(vk->getDevice(), pipeline, vk->getAllocator());
-                    vkDestroyPipelineLayout(vk->getDevice(), pipelineLayout, vk->getAllocator());
-                    vkDestroyShaderModule(vk->getDevice(), pixelShader, vk->getAllocator());
-                    vkDestroyShaderModule(vk->getDevice(), vertexShader, vk->getAllocator());
+                    vk->getObjectCache().releasePipelineLayout(pipelineLayout);
+                    vk->getObjectCache().releaseShaderModule(pixelShader);
+                    vk->getObjectCache().releaseShaderModule(vertexShader);
                 }
             );
         }
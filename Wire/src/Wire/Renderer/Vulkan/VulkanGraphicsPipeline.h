@@ -4,8 +4,13 @@
 
 #include <vulkan/vulkan.h>
 
+#include <span>
 #include <array>
+#include <atomic>
+#include <future>
+#include <memory>
 #include <string>
+#include <vector>
 
 namespace wire {
 
@@ -15,15 +20,32 @@ namespace wire {
         VulkanGraphicsPipeline(Device* device, const GraphicsPipelineDesc& desc, std::string_view debugName);
         virtual ~VulkanGraphicsPipeline();
 
+        virtual bool isReady() const override { return m_Ready; }
+        virtual void wait() const override;
+
+        virtual std::shared_ptr<GraphicsPipeline> getFallback() const override { return m_Fallback; }
+        virtual std::shared_ptr<ShaderResourceLayout> getResourceLayout() const override { return m_ShaderResourceLayout; }
+
         VkPipeline getPipeline() const { return m_Pipeline; }
         VkPipelineLayout getPipelineLayout() const { return m_PipelineLayout; }
+        const std::vector<VkPushConstantRange>& getPushConstantRanges() const { return m_PushConstantRanges; }
+
+        // rebuilds the pipeline on a worker thread from the shader currently in the cache
+        void reload();
+        // swaps in a finished reload, returns false while one is still compiling
+        bool applyReload();
+
+        const std::string& getShaderPath() const { return m_Desc.ShaderPath; }
     protected:
         virtual void destroy() override;
         virtual void invalidate() noexcept override;
+    private:
+        void create(const GraphicsPipelineDesc& desc);
     private:
         VulkanDevice* m_Device;
 
         std::string m_DebugName;
+        GraphicsPipelineDesc m_Desc; // with the reflected layout filled in
 
         std::shared_ptr<RenderPass> m_RenderPass;
 
@@ -32,6 +54,15 @@ namespace wire {
         
         VkPipelineLayout m_PipelineLayout;
         VkPipeline m_Pipeline;
+        std::vector<VkPushConstantRange> m_PushConstantRanges;
+
+        std::shared_ptr<GraphicsPipeline> m_Fallback;
+        std::atomic<bool> m_Ready = false;
+        std::future<void> m_CompileTask;
+
+        std::unique_ptr<VulkanGraphicsPipeline> m_ReloadedPipeline;
+        std::future<void> m_ReloadTask;
+        bool m_ReloadQueued = false;
     };
 
     namespace Utils {
@@ -39,6 +70,15 @@ namespace wire {
         VkShaderStageFlags ConvertShaderType(ShaderType type);
         VkDescriptorType ConvertDescriptorType(ShaderResourceType type);
 
+        // bindings and push constants used by several stages are listed once per stage
+        ShaderResourceLayoutInfo GetReflectedLayoutInfo(std::span<const ShaderObjectView> stages);
+        std::vector<PushConstantInfo> GetReflectedPushConstants(std::span<const ShaderObjectView> stages);
+        void ValidateReflectedLayout(std::span<const ShaderObjectView> stages, const std::shared_ptr<ShaderResourceLayout>& resourceLayout, const std::vector<PushConstantInfo>& pushConstants, std::string_view debugName);
+        void ValidateSpecializationConstants(std::span<const ShaderObjectView> stages, const std::vector<SpecializationConstant>& constants, std::string_view debugName);
+
+        // the returned info points into constants and outEntries
+        VkSpecializationInfo GetSpecializationInfo(const std::vector<SpecializationConstant>& constants, std::vector<VkSpecializationMapEntry>& outEntries);
+
     }
 
 }
@@ -0,0 +1,224 @@
+#include "VulkanObjectCache.h"
+
+#include "VulkanDevice.h"
+
+#include "Wire/Core/Assert.h"
+
+namespace wire {
+
+    namespace Utils {
+
+        template<typename T>
+        static void AppendKey(std::string& key, const T& value)
+        {
+            static_assert(std::is_trivially_copyable_v<T>);
+            key.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+    }
+
+    void VulkanObjectCache::create(VulkanDevice* device)
+    {
+        m_Device = device;
+    }
+
+    void VulkanObjectCache::destroy()
+    {
+        if (!m_Device)
+            return;
+
+        std::lock_guard lock(m_Mutex);
+
+        // anything left here was never released by its owner
+        for (auto& [key, entry] : m_PipelineLayouts.Objects)
+            vkDestroyPipelineLayout(m_Device->getDevice(), entry.Object, m_Device->getAllocator());
+        for (auto& [key, entry] : m_SetLayouts.Objects)
+            vkDestroyDescriptorSetLayout(m_Device->getDevice(), entry.Object, m_Device->getAllocator());
+        for (auto& [key, entry] : m_ShaderModules.Objects)
+            vkDestroyShaderModule(m_Device->getDevice(), entry.Object, m_Device->getAllocator());
+
+        m_PipelineLayouts = {};
+        m_SetLayouts = {};
+        m_ShaderModules = {};
+        m_Device = nullptr;
+    }
+
+    VkShaderModule VulkanObjectCache::acquireShaderModule(std::span<const uint8_t> bytecode, std::string_view debugName)
+    {
+        std::string_view key(reinterpret_cast<const char*>(bytecode.data()), bytecode.size());
+
+        return acquire(m_ShaderModules, key, [&]()
+        {
+            VkShaderModuleCreateInfo moduleInfo{};
+            moduleInfo.sType = VK_STRUCTURE_TYPE_SHADER_MODULE_CREATE_INFO;
+            moduleInfo.codeSize = bytecode.size();
+            moduleInfo.pCode = reinterpret_cast<const uint32_t*>(bytecode.data());
+
+            VkShaderModule shaderModule;
+            VkResult result = vkCreateShaderModule(m_Device->getDevice(), &moduleInfo, m_Device->getAllocator(), &shaderModule);
+            VK_CHECK(result, "Failed to create Vulkan shader module!");
+
+            std::string name(debugName);
+            VK_DEBUG_NAME(m_Device->getDevice(), SHADER_MODULE, shaderModule, name.c_str());
+
+            return shaderModule;
+        });
+    }
+
+    VkDescriptorSetLayout VulkanObjectCache::acquireSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, std::string_view debugName)
+    {
+        std::string key;
+        for (const auto& binding : bindings)
+        {
+            WR_ASSERT(binding.pImmutableSamplers == nullptr, "immutable samplers are not supported by the object cache");
+
+            Utils::AppendKey(key, binding.binding);
+            Utils::AppendKey(key, binding.descriptorType);
+            Utils::AppendKey(key, binding.descriptorCount);
+            Utils::AppendKey(key, binding.stageFlags);
+        }
+
+        return acquire(m_SetLayouts, key, [&]()
+        {
+            VkDescriptorSetLayoutCreateInfo createInfo{};
+            createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
+            createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
+            createInfo.pBindings = bindings.data();
+
+            VkDescriptorSetLayout setLayout;
+            VkResult result = vkCreateDescriptorSetLayout(m_Device->getDevice(), &createInfo, m_Device->getAllocator(), &setLayout);
+            VK_CHECK(result, "failed to create Vulkan descriptor set layout");
+
+            std::string name(debugName);
+            VK_DEBUG_NAME(m_Device->getDevice(), DESCRIPTOR_SET_LAYOUT, setLayout, name.c_str());
+
+            return setLayout;
+        });
+    }
+
+    VkPipelineLayout VulkanObjectCache::acquirePipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges, std::string_view debugName)
+    {
+        // set layouts are deduplicated as well, so equal handles mean equal layouts
+        std::string key;
+        Utils::AppendKey(key, static_cast<uint32_t>(setLayouts.size()));
+        for (VkDescriptorSetLayout setLayout : setLayouts)
+            Utils::AppendKey(key, setLayout);
+        for (const auto& range : pushConstantRanges)
+        {
+            Utils::AppendKey(key, range.stageFlags);
+            Utils::AppendKey(key, range.offset);
+            Utils::AppendKey(key, range.size);
+        }
+
+        return acquire(m_PipelineLayouts, key, [&]()
+        {
+            VkPipelineLayoutCreateInfo pipelineLayoutInfo{};
+            pipelineLayoutInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_LAYOUT_CREATE_INFO;
+            pipelineLayoutInfo.setLayoutCount = static_cast<uint32_t>(setLayouts.size());
+            pipelineLayoutInfo.pSetLayouts = setLayouts.data();
+            pipelineLayoutInfo.pushConstantRangeCount = static_cast<uint32_t>(pushConstantRanges.size());
+            pipelineLayoutInfo.pPushConstantRanges = pushConstantRanges.data();
+
+            VkPipelineLayout pipelineLayout;
+            VkResult result = vkCreatePipelineLayout(m_Device->getDevice(), &pipelineLayoutInfo, m_Device->getAllocator(), &pipelineLayout);
+            VK_CHECK(result, "Failed to create Vulkan pipeline layout!");
+
+            std::string name(debugName);
+            VK_DEBUG_NAME(m_Device->getDevice(), PIPELINE_LAYOUT, pipelineLayout, name.c_str());
+
+            return pipelineLayout;
+        });
+    }
+
+    void VulkanObjectCache::releaseShaderModule(VkShaderModule shaderModule)
+    {
+        release(m_ShaderModules, shaderModule, [this](VkShaderModule object)
+        {
+            vkDestroyShaderModule(m_Device->getDevice(), object, m_Device->getAllocator());
+        });
+    }
+
+    void VulkanObjectCache::releaseSetLayout(VkDescriptorSetLayout setLayout)
+    {
+        release(m_SetLayouts, setLayout, [this](VkDescriptorSetLayout object)
+        {
+            vkDestroyDescriptorSetLayout(m_Device->getDevice(), object, m_Device->getAllocator());
+        });
+    }
+
+    void VulkanObjectCache::releasePipelineLayout(VkPipelineLayout pipelineLayout)
+    {
+        release(m_PipelineLayouts, pipelineLayout, [this](VkPipelineLayout object)
+        {
+            vkDestroyPipelineLayout(m_Device->getDevice(), object, m_Device->getAllocator());
+        });
+    }
+
+    void VulkanObjectCache::recordPipelineLookup(bool hit)
+    {
+        std::lock_guard lock(m_Mutex);
+
+        if (hit)
+            m_Pipelines.Hits++;
+        else
+            m_Pipelines.Misses++;
+    }
+
+    void VulkanObjectCache::getStatistics(PipelineStatistics& statistics) const
+    {
+        std::lock_guard lock(m_Mutex);
+
+        statistics.ShaderModules = m_ShaderModules.Statistics;
+        statistics.SetLayouts = m_SetLayouts.Statistics;
+        statistics.PipelineLayouts = m_PipelineLayouts.Statistics;
+        statistics.Pipelines = m_Pipelines;
+    }
+
+    template<typename T, typename CreateFunc>
+    T VulkanObjectCache::acquire(ObjectMap<T>& map, std::string_view key, CreateFunc&& create)
+    {
+        std::lock_guard lock(m_Mutex);
+
+        auto it = map.Objects.find(key);
+        if (it != map.Objects.end())
+        {
+            it->second.RefCount++;
+            map.Statistics.Hits++;
+
+            return it->second.Object;
+        }
+
+        T object = create();
+
+        map.Objects.emplace(std::string(key), typename ObjectMap<T>::Entry{ .Object = object, .RefCount = 1 });
+        map.Keys.emplace(object, std::string(key));
+        map.Statistics.Misses++;
+        map.Statistics.Live++;
+
+        return object;
+    }
+
+    template<typename T, typename DestroyFunc>
+    void VulkanObjectCache::release(ObjectMap<T>& map, T object, DestroyFunc&& destroy)
+    {
+        std::lock_guard lock(m_Mutex);
+
+        auto keyIt = map.Keys.find(object);
+        if (keyIt == map.Keys.end())
+        {
+            WR_ASSERT_OR_WARN(false, "Released a Vulkan object that is not owned by the object cache");
+            return;
+        }
+
+        auto it = map.Objects.find(keyIt->second);
+        if (--it->second.RefCount > 0)
+            return;
+
+        destroy(object);
+
+        map.Objects.erase(it);
+        map.Keys.erase(keyIt);
+        map.Statistics.Live--;
+    }
+
+}
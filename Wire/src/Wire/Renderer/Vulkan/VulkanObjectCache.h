@@ -0,0 +1,75 @@
+#pragma once
+
+#include "Wire/Renderer/Device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <span>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <string_view>
+#include <unordered_map>
+
+namespace wire {
+
+    class VulkanDevice;
+
+    // reference counted driver objects shared between resources with identical descriptions
+    class VulkanObjectCache
+    {
+    public:
+        VulkanObjectCache() = default;
+
+        void create(VulkanDevice* device);
+        void destroy();
+
+        VkShaderModule acquireShaderModule(std::span<const uint8_t> bytecode, std::string_view debugName = {});
+        VkDescriptorSetLayout acquireSetLayout(const std::vector<VkDescriptorSetLayoutBinding>& bindings, std::string_view debugName = {});
+        VkPipelineLayout acquirePipelineLayout(const std::vector<VkDescriptorSetLayout>& setLayouts, const std::vector<VkPushConstantRange>& pushConstantRanges, std::string_view debugName = {});
+
+        void releaseShaderModule(VkShaderModule shaderModule);
+        void releaseSetLayout(VkDescriptorSetLayout setLayout);
+        void releasePipelineLayout(VkPipelineLayout pipelineLayout);
+
+        void recordPipelineLookup(bool hit);
+        void getStatistics(PipelineStatistics& statistics) const;
+    private:
+        struct StringHash
+        {
+            using is_transparent = void;
+
+            size_t operator()(std::string_view string) const { return std::hash<std::string_view>{}(string); }
+        };
+
+        template<typename T>
+        struct ObjectMap
+        {
+            struct Entry
+            {
+                T Object;
+                uint32_t RefCount;
+            };
+
+            std::unordered_map<std::string, Entry, StringHash, std::equal_to<>> Objects;
+            std::unordered_map<T, std::string> Keys;
+            ObjectCacheStatistics Statistics;
+        };
+
+        template<typename T, typename CreateFunc>
+        T acquire(ObjectMap<T>& map, std::string_view key, CreateFunc&& create);
+
+        template<typename T, typename DestroyFunc>
+        void release(ObjectMap<T>& map, T object, DestroyFunc&& destroy);
+    private:
+        VulkanDevice* m_Device = nullptr;
+
+        mutable std::mutex m_Mutex;
+
+        ObjectMap<VkShaderModule> m_ShaderModules;
+        ObjectMap<VkDescriptorSetLayout> m_SetLayouts;
+        ObjectMap<VkPipelineLayout> m_PipelineLayouts;
+        ObjectCacheStatistics m_Pipelines;
+    };
+
+}
@@ -0,0 +1,287 @@
+#include "VulkanPipelineCache.h"
+
+#include "VulkanDevice.h"
+
+#include "Wire/Core/Assert.h"
+#include "Wire/Core/ThreadPool.h"
+#include "Wire/Serialization/Stream.h"
+
+#include <fstream>
+
+namespace wire {
+
+#define HEADER_VER(major, minor, patch, build) (static_cast<uint32_t>(major) << 24) \
+    | (static_cast<uint32_t>(minor) << 16) \
+    | (static_cast<uint32_t>(patch) << 8)  \
+    | (static_cast<uint32_t>(build))
+
+    struct PipelineCacheHeader
+    {
+        // ID data
+        const char AppID[4] = { 'W', 'I', 'R', 'E' };    // WIRE
+        const char TypeID[4] = { 'P', 'L', 'C', 'H' };   // PLCH  (pipeline cache)
+        const uint32_t Version = HEADER_VER(1, 1, 0, 0); // 1.1.0.0
+
+        // device data, the cache is thrown away if any of it changes
+        uint32_t VendorID;
+        uint32_t DeviceID;
+        uint32_t DriverVersion;
+        uint8_t PipelineCacheUUID[VK_UUID_SIZE];
+        uint8_t DriverUUID[VK_UUID_SIZE];
+
+        // cache data, followed by the tuned workgroup sizes
+        size_t DataSize;
+        uint32_t TunedWorkgroupSizeCount;
+    };
+
+    // frames between background saves, only taken when new pipelines were created
+    constexpr static uint32_t s_SaveInterval = 600;
+
+    void VulkanPipelineCache::create(VulkanDevice* device, const std::filesystem::path& path)
+    {
+        m_Device = device;
+        m_Path = path;
+
+        vkGetPhysicalDeviceProperties(device->getPhysicalDevice(), &m_Properties);
+
+        VkPhysicalDeviceIDProperties idProperties{};
+        idProperties.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_ID_PROPERTIES;
+
+        VkPhysicalDeviceProperties2 properties2{};
+        properties2.sType = VK_STRUCTURE_TYPE_PHYSICAL_DEVICE_PROPERTIES_2;
+        properties2.pNext = &idProperties;
+
+        vkGetPhysicalDeviceProperties2(device->getPhysicalDevice(), &properties2);
+        std::memcpy(m_DriverUUID, idProperties.driverUUID, VK_UUID_SIZE);
+
+        std::vector<uint8_t> initialData;
+        if (!m_Path.empty() && std::filesystem::exists(m_Path) && !readCacheFile(initialData, m_TunedWorkgroupSizes))
+        {
+            WR_WARN("Pipeline cache {} was created by a different device or driver, starting cold", m_Path.string());
+            initialData.clear();
+            m_TunedWorkgroupSizes.clear();
+        }
+
+        VkPipelineCacheCreateInfo createInfo{};
+        createInfo.sType = VK_STRUCTURE_TYPE_PIPELINE_CACHE_CREATE_INFO;
+        createInfo.initialDataSize = initialData.size();
+        createInfo.pInitialData = initialData.empty() ? nullptr : initialData.data();
+
+        VkResult result = vkCreatePipelineCache(device->getDevice(), &createInfo, device->getAllocator(), &m_PipelineCache);
+        if (result != VK_SUCCESS && !initialData.empty())
+        {
+            // some drivers reject data they consider corrupt instead of ignoring it
+            createInfo.initialDataSize = 0;
+            createInfo.pInitialData = nullptr;
+
+            result = vkCreatePipelineCache(device->getDevice(), &createInfo, device->getAllocator(), &m_PipelineCache);
+        }
+        VK_CHECK(result, "Failed to create Vulkan pipeline cache!");
+
+        VK_DEBUG_NAME(device->getDevice(), PIPELINE_CACHE, m_PipelineCache, "VulkanRenderer::m_PipelineCache");
+    }
+
+    void VulkanPipelineCache::destroy()
+    {
+        if (!m_PipelineCache)
+            return;
+
+        save();
+
+        if (m_SaveTask.valid())
+            m_SaveTask.wait();
+
+        vkDestroyPipelineCache(m_Device->getDevice(), m_PipelineCache, m_Device->getAllocator());
+        m_PipelineCache = nullptr;
+    }
+
+    void VulkanPipelineCache::save()
+    {
+        if (!m_PipelineCache || m_Path.empty())
+            return;
+
+        size_t dataSize = 0;
+        VkResult result = vkGetPipelineCacheData(m_Device->getDevice(), m_PipelineCache, &dataSize, nullptr);
+        VK_CHECK(result, "Failed to get Vulkan pipeline cache data!");
+
+        std::vector<uint8_t> data(dataSize);
+        result = vkGetPipelineCacheData(m_Device->getDevice(), m_PipelineCache, &dataSize, data.data());
+        VK_CHECK(result, "Failed to get Vulkan pipeline cache data!");
+        data.resize(dataSize);
+
+        m_PipelinesSinceSave = 0;
+        m_FramesSinceSave = 0;
+
+        PipelineCacheHeader header{};
+        header.VendorID = m_Properties.vendorID;
+        header.DeviceID = m_Properties.deviceID;
+        header.DriverVersion = m_Properties.driverVersion;
+        std::memcpy(header.PipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE);
+        std::memcpy(header.DriverUUID, m_DriverUUID, VK_UUID_SIZE);
+        header.DataSize = data.size();
+
+        std::unordered_map<std::string, std::array<uint32_t, 3>> workgroupSizes;
+        {
+            std::lock_guard lock(m_TuningMutex);
+            workgroupSizes = m_TunedWorkgroupSizes;
+        }
+
+        header.TunedWorkgroupSizeCount = static_cast<uint32_t>(workgroupSizes.size());
+
+        if (m_SaveTask.valid())
+            m_SaveTask.wait();
+
+        // the driver copy is taken above, only the file write happens off the render thread
+        m_SaveTask = ThreadPool::shared().submit([path = m_Path, header, data = std::move(data), workgroupSizes = std::move(workgroupSizes)]()
+        {
+            std::filesystem::path tempPath = path;
+            tempPath += ".tmp";
+
+            if (path.has_parent_path())
+                std::filesystem::create_directories(path.parent_path());
+
+            {
+                std::ofstream file(tempPath, std::ios::binary);
+                if (!file.good())
+                {
+                    WR_WARN("Failed to write pipeline cache {}", path.string());
+                    return;
+                }
+
+                StreamWriter stream(file);
+                stream.writeRaw(header);
+                stream.writeBuffer(MemoryBuffer(data.data(), data.size()), false);
+
+                for (const auto& [key, workgroupSize] : workgroupSizes)
+                {
+                    stream.writeString(key);
+                    stream.writeRaw(workgroupSize);
+                }
+            }
+
+            std::error_code ec;
+            std::filesystem::rename(tempPath, path, ec);
+            if (ec)
+                WR_WARN("Failed to replace pipeline cache {}: {}", path.string(), ec.message());
+        });
+    }
+
+    void VulkanPipelineCache::onFrameEnd()
+    {
+        m_FramesSinceSave++;
+
+        if (m_FramesSinceSave >= s_SaveInterval && m_PipelinesSinceSave > 0)
+            save();
+    }
+
+    void VulkanPipelineCache::recordCreation(const VkPipelineCreationFeedbackEXT& feedback, bool hasFeedback, double creationTime)
+    {
+        if (hasFeedback && (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_VALID_BIT_EXT))
+        {
+            if (feedback.flags & VK_PIPELINE_CREATION_FEEDBACK_APPLICATION_PIPELINE_CACHE_HIT_BIT_EXT)
+                m_WarmPipelines++;
+            else
+                m_ColdPipelines++;
+        }
+        else
+        {
+            m_UntrackedPipelines++;
+        }
+
+        m_TotalCreationTime += static_cast<uint64_t>(creationTime * 1000.0);
+        m_PipelinesSinceSave++;
+    }
+
+    bool VulkanPipelineCache::getTunedWorkgroupSize(const std::string& key, std::array<uint32_t, 3>& outWorkgroupSize) const
+    {
+        std::lock_guard lock(m_TuningMutex);
+
+        auto it = m_TunedWorkgroupSizes.find(key);
+        if (it == m_TunedWorkgroupSizes.end())
+            return false;
+
+        outWorkgroupSize = it->second;
+        return true;
+    }
+
+    void VulkanPipelineCache::setTunedWorkgroupSize(const std::string& key, const std::array<uint32_t, 3>& workgroupSize)
+    {
+        {
+            std::lock_guard lock(m_TuningMutex);
+            m_TunedWorkgroupSizes[key] = workgroupSize;
+        }
+
+        // picked up by the next periodic save
+        m_PipelinesSinceSave++;
+    }
+
+    PipelineStatistics VulkanPipelineCache::getStatistics() const
+    {
+        PipelineStatistics statistics{};
+        statistics.WarmPipelines = m_WarmPipelines;
+        statistics.ColdPipelines = m_ColdPipelines;
+        statistics.UntrackedPipelines = m_UntrackedPipelines;
+        statistics.TotalCreationTime = static_cast<double>(m_TotalCreationTime) / 1000.0;
+
+        return statistics;
+    }
+
+    bool VulkanPipelineCache::readCacheFile(std::vector<uint8_t>& outData, std::unordered_map<std::string, std::array<uint32_t, 3>>& outWorkgroupSizes) const
+    {
+        std::ifstream file(m_Path, std::ios::binary);
+        if (!file.good())
+            return false;
+
+        StreamReader stream(file);
+
+        PipelineCacheHeader header;
+        stream.readRaw(header);
+
+        PipelineCacheHeader expected{};
+        if (!file.good() ||
+            std::memcmp(header.AppID, expected.AppID, sizeof(expected.AppID)) != 0 ||
+            std::memcmp(header.TypeID, expected.TypeID, sizeof(expected.TypeID)) != 0 ||
+            header.Version != expected.Version)
+            return false;
+
+        if (header.VendorID != m_Properties.vendorID ||
+            header.DeviceID != m_Properties.deviceID ||
+            header.DriverVersion != m_Properties.driverVersion ||
+            std::memcmp(header.PipelineCacheUUID, m_Properties.pipelineCacheUUID, VK_UUID_SIZE) != 0 ||
+            std::memcmp(header.DriverUUID, m_DriverUUID, VK_UUID_SIZE) != 0)
+            return false;
+
+        outData.resize(header.DataSize);
+        file.read(reinterpret_cast<char*>(outData.data()), header.DataSize);
+        if (!file.good())
+            return false;
+
+        for (uint32_t i = 0; i < header.TunedWorkgroupSizeCount; i++)
+        {
+            std::string key;
+            std::array<uint32_t, 3> workgroupSize;
+            stream.readString(key);
+            stream.readRaw(workgroupSize);
+
+            if (!file.good())
+                return false;
+
+            outWorkgroupSizes[key] = workgroupSize;
+        }
+
+        // the driver's own header (VkPipelineCacheHeaderVersionOne) has to agree as well
+        constexpr size_t vkHeaderSize = sizeof(uint32_t) * 4 + VK_UUID_SIZE;
+        if (outData.size() < vkHeaderSize)
+            return false;
+
+        uint32_t vkHeader[4];
+        std::memcpy(vkHeader, outData.data(), sizeof(vkHeader));
+
+        return vkHeader[0] >= vkHeaderSize &&
+            vkHeader[1] == VK_PIPELINE_CACHE_HEADER_VERSION_ONE &&
+            vkHeader[2] == m_Properties.vendorID &&
+            vkHeader[3] == m_Properties.deviceID &&
+            std::memcmp(outData.data() + sizeof(vkHeader), m_Properties.pipelineCacheUUID, VK_UUID_SIZE) == 0;
+    }
+
+}
@@ -0,0 +1,62 @@
+#pragma once
+
+#include "Wire/Renderer/Device.h"
+
+#include <vulkan/vulkan.h>
+
+#include <array>
+#include <mutex>
+#include <atomic>
+#include <future>
+#include <filesystem>
+#include <unordered_map>
+
+namespace wire {
+
+    class VulkanDevice;
+
+    class VulkanPipelineCache
+    {
+    public:
+        VulkanPipelineCache() = default;
+
+        void create(VulkanDevice* device, const std::filesystem::path& path);
+        void destroy();
+
+        void save();
+        void onFrameEnd();
+
+        void recordCreation(const VkPipelineCreationFeedbackEXT& feedback, bool hasFeedback, double creationTime);
+        PipelineStatistics getStatistics() const;
+
+        VkPipelineCache getPipelineCache() const { return m_PipelineCache; }
+
+        // autotuned compute workgroup sizes, stored with the driver data so they are dropped along with it on a device change
+        bool getTunedWorkgroupSize(const std::string& key, std::array<uint32_t, 3>& outWorkgroupSize) const;
+        void setTunedWorkgroupSize(const std::string& key, const std::array<uint32_t, 3>& workgroupSize);
+    private:
+        bool readCacheFile(std::vector<uint8_t>& outData, std::unordered_map<std::string, std::array<uint32_t, 3>>& outWorkgroupSizes) const;
+    private:
+        VulkanDevice* m_Device = nullptr;
+        std::filesystem::path m_Path;
+
+        VkPipelineCache m_PipelineCache = nullptr;
+
+        VkPhysicalDeviceProperties m_Properties{};
+        uint8_t m_DriverUUID[VK_UUID_SIZE]{};
+
+        std::atomic<uint32_t> m_WarmPipelines = 0;
+        std::atomic<uint32_t> m_ColdPipelines = 0;
+        std::atomic<uint32_t> m_UntrackedPipelines = 0;
+        std::atomic<uint64_t> m_TotalCreationTime = 0; // microseconds
+
+        std::unordered_map<std::string, std::array<uint32_t, 3>> m_TunedWorkgroupSizes;
+        mutable std::mutex m_TuningMutex;
+
+        std::atomic<uint32_t> m_PipelinesSinceSave = 0;
+        uint32_t m_FramesSinceSave = 0;
+
+        std::future<void> m_SaveTask;
+    };
+
+}
@@ -5,10 +5,12 @@
 #include "VulkanFramebuffer.h"
 #include "VulkanGraphicsPipeline.h"
 
+#include <algorithm>
+
 namespace wire {
 
     VulkanShaderResourceLayout::VulkanShaderResourceLayout(VulkanDevice* device, const ShaderResourceLayoutInfo& layoutInfo, std::string_view debugName)
-        : m_Device(device), m_DebugName(debugName)
+        : m_Device(device), m_Info(layoutInfo), m_DebugName(debugName)
     {
         for (const auto& set : layoutInfo.Sets)
         {
@@ -16,6 +18,16 @@ namespace wire {
             
             for (const auto& resource : set.Resources)
             {
+                // a binding listed once per stage is visible to all of them
+                auto existing = std::find_if(bindings.begin(), bindings.end(), [&resource](const VkDescriptorSetLayoutBinding& binding) { return binding.binding == resource.Binding; });
+                if (existing != bindings.end())
+                {
+                    WR_ASSERT(existing->descriptorType == Utils::ConvertDescriptorType(resource.Type) && existing->descriptorCount == resource.ArrayCount, "binding {} is declared with different types", resource.Binding);
+
+                    existing->stageFlags |= Utils::ConvertShaderType(resource.Stage);
+                    continue;
+                }
+
                 VkDescriptorSetLayoutBinding binding{};
                 binding.binding = resource.Binding;
                 binding.descriptorType = Utils::ConvertDescriptorType(resource.Type);
@@ -26,20 +38,10 @@ namespace wire {
                 bindings.push_back(binding);
             }
             
-            VkDescriptorSetLayoutCreateInfo createInfo{};
-            createInfo.sType = VK_STRUCTURE_TYPE_DESCRIPTOR_SET_LAYOUT_CREATE_INFO;
-            createInfo.bindingCount = static_cast<uint32_t>(bindings.size());
-            createInfo.pBindings = bindings.data();
-            
-            VkDescriptorSetLayout setLayout;
-            VkResult result = vkCreateDescriptorSetLayout(m_Device->getDevice(), &createInfo, m_Device->getAllocator(), &setLayout);
-            VK_CHECK(result, "failed to create Vulkan descriptor set layout");
-            
-            m_SetLayouts.push_back(setLayout);
-            
             std::string debugName = m_DebugName;
-            debugName += " (" + std::to_string(m_SetLayouts.size() - 1) + ")";
-            VK_DEBUG_NAME(m_Device->getDevice(), DESCRIPTOR_SET_LAYOUT, setLayout, debugName.c_str());
+            debugName += " (" + std::to_string(m_SetLayouts.size()) + ")";
+
+            m_SetLayouts.push_back(m_Device->getObjectCache().acquireSetLayout(bindings, debugName));
         }
     }
 
@@ -57,7 +59,7 @@ namespace wire {
                 VulkanDevice* vk = (VulkanDevice*)device;
 
                 for (VkDescriptorSetLayout setLayout : setLayouts)
-                    vkDestroyDescriptorSetLayout(vk->getDevice(), setLayout, vk->getAllocator());
+                    vk->getObjectCache().releaseSetLayout(setLayout);
             });
         }
     }
@@ -226,7 +228,7 @@ namespace wire {
         descriptorWrite.dstSet = m_Set;
         descriptorWrite.dstBinding = binding;
         descriptorWrite.dstArrayElement = index;
-        descriptorWrite.descriptorType = VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
+        descriptorWrite.descriptorType = (vkBuffer->getType() & StorageBuffer) ? VK_DESCRIPTOR_TYPE_STORAGE_BUFFER : VK_DESCRIPTOR_TYPE_UNIFORM_BUFFER;
         descriptorWrite.descriptorCount = 1;
         descriptorWrite.pBufferInfo = &bufferInfo;
 
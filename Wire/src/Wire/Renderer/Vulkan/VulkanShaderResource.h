@@ -17,12 +17,14 @@ namespace wire {
         
         VkDescriptorSetLayout getLayout(uint32_t set) const { return m_SetLayouts[set]; }
         const std::vector<VkDescriptorSetLayout>& getLayouts() const { return m_SetLayouts; }
+        const ShaderResourceLayoutInfo& getInfo() const { return m_Info; }
     protected:
         virtual void destroy() override;
         virtual void invalidate() noexcept override;
     private:
         VulkanDevice* m_Device = nullptr;
         
+        ShaderResourceLayoutInfo m_Info;
         std::string m_DebugName;
         
         std::vector<VkDescriptorSetLayout> m_SetLayouts;
@@ -12,6 +12,30 @@ namespace wire {
 
     namespace Utils {
 
+        static VkFormat GetVkFormat(TextureFormat format)
+        {
+            switch (format)
+            {
+                case TextureFormat::RGBA8: return VK_FORMAT_R8G8B8A8_UNORM;
+                case TextureFormat::R8: return VK_FORMAT_R8_UNORM;
+            }
+
+            WR_ASSERT(false, "Unknown texture format!");
+            return VK_FORMAT_UNDEFINED;
+        }
+
+        static uint32_t GetTexelSize(TextureFormat format)
+        {
+            switch (format)
+            {
+                case TextureFormat::RGBA8: return 4;
+                case TextureFormat::R8: return 1;
+            }
+
+            WR_ASSERT(false, "Unknown texture format!");
+            return 0;
+        }
+
         static void CreateBuffer(VkDevice device, VkPhysicalDevice physicalDevice, const VkAllocationCallbacks* allocator, size_t size, VkBufferUsageFlags usage, VkMemoryPropertyFlags properties, VkBuffer& buffer, VkDeviceMemory& memory, std::string_view debugName, bool staging)
         {
             VkBufferCreateInfo bufferInfo{};
@@ -148,6 +172,14 @@ namespace wire {
                 sourceStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
                 destinationStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT;
             }
+            else if (oldLayout == VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL && newLayout == VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL)
+            {
+                barrier.srcAccessMask = VK_ACCESS_SHADER_READ_BIT;
+                barrier.dstAccessMask = VK_ACCESS_TRANSFER_WRITE_BIT;
+
+                sourceStage = VK_PIPELINE_STAGE_FRAGMENT_SHADER_BIT | VK_PIPELINE_STAGE_COMPUTE_SHADER_BIT;
+                destinationStage = VK_PIPELINE_STAGE_TRANSFER_BIT;
+            }
             else if (oldLayout == VK_IMAGE_LAYOUT_UNDEFINED && newLayout == VK_IMAGE_LAYOUT_DEPTH_STENCIL_ATTACHMENT_OPTIMAL)
             {
                 barrier.srcAccessMask = 0;
@@ -168,10 +200,10 @@ namespace wire {
             commandList.submitNativeCommand(command, id);
         }
 
-        static void CopyBufferToImage(CommandList& commandList, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height)
+        static void CopyBufferToImage(CommandList& commandList, VkBuffer buffer, VkImage image, uint32_t width, uint32_t height, VkDeviceSize bufferOffset = 0, int32_t x = 0, int32_t y = 0)
         {
             VkBufferImageCopy region{};
-            region.bufferOffset = 0;
+            region.bufferOffset = bufferOffset;
             region.bufferRowLength = 0;
             region.bufferImageHeight = 0;
 
@@ -180,7 +212,7 @@ namespace wire {
             region.imageSubresource.baseArrayLayer = 0;
             region.imageSubresource.layerCount = 1;
 
-            region.imageOffset = { 0, 0, 0 };
+            region.imageOffset = { x, y, 0 };
             region.imageExtent = {
                 width,
                 height,
@@ -201,13 +233,14 @@ namespace wire {
             commandList.submitNativeCommand(command, id);
         }
 
-        static VkImageView CreateImageView(VkDevice device, const VkAllocationCallbacks* allocator, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, std::string_view debugName)
+        static VkImageView CreateImageView(VkDevice device, const VkAllocationCallbacks* allocator, VkImage image, VkFormat format, VkImageAspectFlags aspectFlags, std::string_view debugName, VkComponentMapping components = {})
         {
             VkImageViewCreateInfo viewInfo{};
             viewInfo.sType = VK_STRUCTURE_TYPE_IMAGE_VIEW_CREATE_INFO;
             viewInfo.image = image;
             viewInfo.viewType = VK_IMAGE_VIEW_TYPE_2D;
             viewInfo.format = format;
+            viewInfo.components = components;
             viewInfo.subresourceRange.aspectMask = aspectFlags;
             viewInfo.subresourceRange.baseMipLevel = 0;
             viewInfo.subresourceRange.levelCount = 1;
@@ -317,11 +350,17 @@ namespace wire {
     }
 
     VulkanTexture2D::VulkanTexture2D(Device* device, uint32_t* data, uint32_t width, uint32_t height, std::string_view debugName)
-        : m_Device(device), m_DebugName(debugName), m_UUID()
+        : VulkanTexture2D(device, data, width, height, TextureFormat::RGBA8, debugName)
+    {
+    }
+
+    VulkanTexture2D::VulkanTexture2D(Device* device, const void* data, uint32_t width, uint32_t height, TextureFormat format, std::string_view debugName)
+        : m_Device(device), m_DebugName(debugName), m_UUID(), m_Format(format)
     {
         VulkanDevice* vk = (VulkanDevice*)device;
 
-        VkDeviceSize imageSize = (uint64_t)(width * height * 4);
+        VkFormat vkFormat = Utils::GetVkFormat(format);
+        VkDeviceSize imageSize = (VkDeviceSize)width * height * Utils::GetTexelSize(format);
 
         VkBuffer stagingBuffer;
         VkDeviceMemory stagingBufferMemory;
@@ -353,7 +392,7 @@ namespace wire {
             m_Width,
             m_Height,
             VK_SAMPLE_COUNT_1_BIT,
-            VK_FORMAT_R8G8B8A8_UNORM,
+            vkFormat,
             VK_IMAGE_TILING_OPTIMAL,
             VK_IMAGE_USAGE_TRANSFER_DST_BIT | VK_IMAGE_USAGE_SAMPLED_BIT,
             VK_MEMORY_PROPERTY_DEVICE_LOCAL_BIT,
@@ -367,7 +406,7 @@ namespace wire {
         Utils::TransitionImageLayout(
             commandList,
             m_Image,
-            VK_FORMAT_R8G8B8A8_UNORM,
+            vkFormat,
             VK_IMAGE_LAYOUT_UNDEFINED,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
         );
@@ -383,7 +422,7 @@ namespace wire {
         Utils::TransitionImageLayout(
             commandList,
             m_Image,
-            VK_FORMAT_R8G8B8A8_UNORM,
+            vkFormat,
             VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
             VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
         );
@@ -393,7 +432,12 @@ namespace wire {
         vkDestroyBuffer(vk->getDevice(), stagingBuffer, vk->getAllocator());
         vkFreeMemory(vk->getDevice(), stagingBufferMemory, vk->getAllocator());
 
-        m_ImageView = Utils::CreateImageView(vk->getDevice(), vk->getAllocator(), m_Image, VK_FORMAT_R8G8B8A8_UNORM, VK_IMAGE_ASPECT_COLOR_BIT, debugName);
+        // single channel textures read like a grey rgba texture
+        VkComponentMapping components{};
+        if (format == TextureFormat::R8)
+            components = { VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_R, VK_COMPONENT_SWIZZLE_ONE };
+
+        m_ImageView = Utils::CreateImageView(vk->getDevice(), vk->getAllocator(), m_Image, vkFormat, VK_IMAGE_ASPECT_COLOR_BIT, debugName, components);
     }
 
     VulkanTexture2D::VulkanTexture2D(VkImage image, VkDeviceMemory memory, VkImageView view, const std::vector<VkImageView>& mips, uint32_t width, uint32_t height)
@@ -402,6 +446,82 @@ namespace wire {
         m_NoFree = true;
     }
 
+    void VulkanTexture2D::update(const std::vector<TextureRegion>& regions)
+    {
+        if (regions.empty())
+            return;
+
+        VulkanDevice* vk = (VulkanDevice*)m_Device;
+
+        VkFormat vkFormat = Utils::GetVkFormat(m_Format);
+        uint32_t texelSize = Utils::GetTexelSize(m_Format);
+
+        VkDeviceSize uploadSize = 0;
+        for (const auto& region : regions)
+        {
+            WR_ASSERT(region.X + region.Width <= m_Width && region.Y + region.Height <= m_Height, "Texture region out of bounds!");
+            uploadSize += (VkDeviceSize)region.Width * region.Height * texelSize;
+        }
+
+        VkBuffer stagingBuffer;
+        VkDeviceMemory stagingBufferMemory;
+        Utils::CreateBuffer(
+            vk->getDevice(),
+            vk->getPhysicalDevice(),
+            vk->getAllocator(),
+            uploadSize,
+            VK_BUFFER_USAGE_TRANSFER_SRC_BIT,
+            VK_MEMORY_PROPERTY_HOST_VISIBLE_BIT | VK_MEMORY_PROPERTY_HOST_COHERENT_BIT,
+            stagingBuffer,
+            stagingBufferMemory,
+            m_DebugName,
+            true
+        );
+
+        uint8_t* bufferData;
+        vkMapMemory(vk->getDevice(), stagingBufferMemory, 0, uploadSize, 0, reinterpret_cast<void**>(&bufferData));
+
+        VkDeviceSize offset = 0;
+        for (const auto& region : regions)
+        {
+            VkDeviceSize regionSize = (VkDeviceSize)region.Width * region.Height * texelSize;
+            memcpy(bufferData + offset, region.Data, regionSize);
+            offset += regionSize;
+        }
+
+        vkUnmapMemory(vk->getDevice(), stagingBufferMemory);
+
+        CommandList commandList = vk->beginSingleTimeCommands();
+
+        Utils::TransitionImageLayout(
+            commandList,
+            m_Image,
+            vkFormat,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL
+        );
+
+        offset = 0;
+        for (const auto& region : regions)
+        {
+            Utils::CopyBufferToImage(commandList, stagingBuffer, m_Image, region.Width, region.Height, offset, (int32_t)region.X, (int32_t)region.Y);
+            offset += (VkDeviceSize)region.Width * region.Height * texelSize;
+        }
+
+        Utils::TransitionImageLayout(
+            commandList,
+            m_Image,
+            vkFormat,
+            VK_IMAGE_LAYOUT_TRANSFER_DST_OPTIMAL,
+            VK_IMAGE_LAYOUT_SHADER_READ_ONLY_OPTIMAL
+        );
+
+        vk->endSingleTimeCommands(commandList);
+
+        vkDestroyBuffer(vk->getDevice(), stagingBuffer, vk->getAllocator());
+        vkFreeMemory(vk->getDevice(), stagingBufferMemory, vk->getAllocator());
+    }
+
     VulkanTexture2D::~VulkanTexture2D()
     {
         destroy();
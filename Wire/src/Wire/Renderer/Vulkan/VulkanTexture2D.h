@@ -14,11 +14,15 @@ namespace wire {
     public:
         VulkanTexture2D(Device* device, const std::filesystem::path& path, std::string_view debugName);
         VulkanTexture2D(Device* device, uint32_t* data, uint32_t width, uint32_t height, std::string_view debugName);
+        VulkanTexture2D(Device* device, const void* data, uint32_t width, uint32_t height, TextureFormat format, std::string_view debugName);
         VulkanTexture2D(VkImage image, VkDeviceMemory memory, VkImageView view, const std::vector<VkImageView>& mips, uint32_t width, uint32_t height);
         virtual ~VulkanTexture2D();
 
         virtual uint32_t getWidth() const override { return m_Width; }
         virtual uint32_t getHeight() const override { return m_Height; }
+        virtual TextureFormat getFormat() const override { return m_Format; }
+
+        virtual void update(const std::vector<TextureRegion>& regions) override;
 
         virtual UUID getUUID() const override { return m_UUID; }
         
@@ -41,6 +45,7 @@ namespace wire {
         std::vector<VkImageView> m_Mips;
 
         uint32_t m_Width = 1, m_Height = 1;
+        TextureFormat m_Format = TextureFormat::RGBA8;
 
         bool m_NoFree = false;
     };
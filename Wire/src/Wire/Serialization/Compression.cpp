@@ -0,0 +1,163 @@
+#include "Compression.h"
+
+#include <cstring>
+#include <algorithm>
+
+namespace wire {
+
+    // a sequence is a token (literal length << 4 | match length - s_MinMatch), the literal length overflow,
+    // the literals, a little endian 16 bit offset and the match length overflow. lengths of 15 continue in
+    // bytes of 255 until a smaller byte ends them. the last sequence is only literals
+
+    constexpr static size_t s_MinMatch = 4;
+    constexpr static size_t s_MaxOffset = 65535;
+    constexpr static uint32_t s_HashBits = 16;
+
+    static uint32_t HashSequence(const uint8_t* data)
+    {
+        uint32_t value;
+        std::memcpy(&value, data, sizeof(uint32_t));
+
+        return (value * 2654435761u) >> (32 - s_HashBits);
+    }
+
+    static void WriteLength(std::vector<uint8_t>& out, size_t length)
+    {
+        while (length >= 255)
+        {
+            out.push_back(255);
+            length -= 255;
+        }
+
+        out.push_back(static_cast<uint8_t>(length));
+    }
+
+    static bool ReadLength(std::span<const uint8_t> in, size_t& position, size_t& length)
+    {
+        uint8_t byte;
+        do
+        {
+            if (position >= in.size())
+                return false;
+
+            byte = in[position++];
+            length += byte;
+        } while (byte == 255);
+
+        return true;
+    }
+
+    static void WriteSequence(std::vector<uint8_t>& out, const uint8_t* literals, size_t literalLength, size_t matchLength, size_t offset)
+    {
+        size_t matchCode = matchLength ? matchLength - s_MinMatch : 0;
+
+        out.push_back(static_cast<uint8_t>((std::min<size_t>(literalLength, 15) << 4) | std::min<size_t>(matchCode, 15)));
+        if (literalLength >= 15)
+            WriteLength(out, literalLength - 15);
+
+        out.insert(out.end(), literals, literals + literalLength);
+
+        if (matchLength == 0)
+            return;
+
+        out.push_back(static_cast<uint8_t>(offset & 0xFF));
+        out.push_back(static_cast<uint8_t>(offset >> 8));
+
+        if (matchCode >= 15)
+            WriteLength(out, matchCode - 15);
+    }
+
+    std::vector<uint8_t> compressLZ(std::span<const uint8_t> data)
+    {
+        const uint8_t* source = data.data();
+        size_t size = data.size();
+
+        std::vector<uint8_t> out;
+        out.reserve(size / 2 + 16);
+
+        // last position each 4 byte sequence was seen at
+        std::vector<uint32_t> table(static_cast<size_t>(1) << s_HashBits, UINT32_MAX);
+
+        size_t anchor = 0;
+        size_t position = 0;
+
+        while (position + s_MinMatch <= size)
+        {
+            uint32_t hash = HashSequence(source + position);
+            uint32_t candidate = table[hash];
+            table[hash] = static_cast<uint32_t>(position);
+
+            if (candidate == UINT32_MAX || position - candidate > s_MaxOffset || std::memcmp(source + candidate, source + position, s_MinMatch) != 0)
+            {
+                position++;
+                continue;
+            }
+
+            // matches may run into the bytes they produce, which is how runs are encoded
+            size_t matchLength = s_MinMatch;
+            while (position + matchLength < size && source[candidate + matchLength] == source[position + matchLength])
+                matchLength++;
+
+            WriteSequence(out, source + anchor, position - anchor, matchLength, position - candidate);
+
+            position += matchLength;
+            anchor = position;
+        }
+
+        WriteSequence(out, source + anchor, size - anchor, 0, 0);
+
+        return out;
+    }
+
+    bool decompressLZ(std::span<const uint8_t> compressed, uint8_t* out, size_t outSize)
+    {
+        size_t in = 0;
+        size_t written = 0;
+
+        while (in < compressed.size())
+        {
+            uint8_t token = compressed[in++];
+
+            size_t literalLength = token >> 4;
+            if (literalLength == 15 && !ReadLength(compressed, in, literalLength))
+                return false;
+
+            if (literalLength > compressed.size() - in || literalLength > outSize - written)
+                return false;
+
+            std::memcpy(out + written, compressed.data() + in, literalLength);
+            in += literalLength;
+            written += literalLength;
+
+            if (in == compressed.size())
+                break;
+
+            if (compressed.size() - in < 2)
+                return false;
+
+            size_t offset = compressed[in] | (static_cast<size_t>(compressed[in + 1]) << 8);
+            in += 2;
+
+            if (offset == 0 || offset > written)
+                return false;
+
+            size_t matchLength = token & 0xF;
+            if (matchLength == 15 && !ReadLength(compressed, in, matchLength))
+                return false;
+
+            matchLength += s_MinMatch;
+            if (matchLength > outSize - written)
+                return false;
+
+            // byte by byte, the match can overlap what it is writing
+            const uint8_t* match = out + written - offset;
+            for (size_t i = 0; i < matchLength; i++)
+                out[written + i] = match[i];
+
+            written += matchLength;
+        }
+
+        return written == outSize;
+    }
+
+}
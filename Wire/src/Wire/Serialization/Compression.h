@@ -0,0 +1,15 @@
+#pragma once
+
+#include <span>
+#include <vector>
+#include <cstdint>
+
+namespace wire {
+
+    // byte oriented lz77 in the style of lz4, there is no entropy stage so decoding is little more than memcpy.
+    // works best on data with long repeats, filter smooth data (like distance fields) with a delta first
+    std::vector<uint8_t> compressLZ(std::span<const uint8_t> data);
+    // false if the data is corrupt or does not decode to exactly outSize bytes
+    bool decompressLZ(std::span<const uint8_t> compressed, uint8_t* out, size_t outSize);
+
+}
@@ -0,0 +1,89 @@
+#include "MappedFile.h"
+
+#include "Wire/Core/Core.h"
+
+#ifdef WR_PLATFORM_WINDOWS
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+namespace wire {
+
+#ifdef WR_PLATFORM_WINDOWS
+
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_DELETE, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+        if (file == INVALID_HANDLE_VALUE)
+            return;
+
+        m_FileHandle = file;
+
+        LARGE_INTEGER size;
+        if (!GetFileSizeEx(file, &size) || size.QuadPart == 0)
+            return;
+
+        HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+        if (!mapping)
+            return;
+
+        m_MappingHandle = mapping;
+
+        void* data = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+        if (!data)
+            return;
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = static_cast<size_t>(size.QuadPart);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            UnmapViewOfFile(m_Data);
+        if (m_MappingHandle)
+            CloseHandle(m_MappingHandle);
+        if (m_FileHandle)
+            CloseHandle(m_FileHandle);
+    }
+
+#else
+
+    MappedFile::MappedFile(const std::filesystem::path& path)
+    {
+        int file = open(path.c_str(), O_RDONLY);
+        if (file < 0)
+            return;
+
+        struct stat info;
+        if (fstat(file, &info) != 0 || info.st_size == 0)
+        {
+            close(file);
+            return;
+        }
+
+        void* data = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, file, 0);
+
+        // the mapping keeps its own reference to the file
+        close(file);
+
+        if (data == MAP_FAILED)
+            return;
+
+        m_Data = static_cast<const uint8_t*>(data);
+        m_Size = static_cast<size_t>(info.st_size);
+    }
+
+    MappedFile::~MappedFile()
+    {
+        if (m_Data)
+            munmap(const_cast<uint8_t*>(m_Data), m_Size);
+    }
+
+#endif
+
+}
@@ -0,0 +1,30 @@
+#pragma once
+
+#include <span>
+#include <cstdint>
+#include <filesystem>
+
+namespace wire {
+
+    // read-only mapping of a whole file, pages are loaded by the os on first access
+    class MappedFile
+    {
+    public:
+        MappedFile() = default;
+        MappedFile(const std::filesystem::path& path);
+        ~MappedFile();
+
+        MappedFile(const MappedFile&) = delete;
+        MappedFile& operator=(const MappedFile&) = delete;
+
+        bool isValid() const { return m_Data != nullptr; }
+        std::span<const uint8_t> getData() const { return { m_Data, m_Size }; }
+    private:
+        const uint8_t* m_Data = nullptr;
+        size_t m_Size = 0;
+
+        void* m_FileHandle = nullptr;
+        void* m_MappingHandle = nullptr;
+    };
+
+}
@@ -4,9 +4,11 @@
 #include "Wire/Core/MemoryBuffer.h"
 
 #include <map>
+#include <span>
 #include <vector>
 #include <ostream>
 #include <istream>
+#include <streambuf>
 #include <concepts>
 #include <functional>
 #include <unordered_map>
@@ -26,6 +28,17 @@ namespace wire {
 		{ C::Deserialize(std::declval<StreamReader&>(), std::declval<C&>()) } -> std::same_as<void>;
 	};
 
+	// lets a StreamReader read memory that is already loaded or mapped, nothing is copied
+	class MemoryStreamBuffer : public std::streambuf
+	{
+	public:
+		MemoryStreamBuffer(std::span<const uint8_t> data)
+		{
+			char* begin = const_cast<char*>(reinterpret_cast<const char*>(data.data()));
+			setg(begin, begin, begin + data.size());
+		}
+	};
+
 	class StreamWriter
 	{
 	public:
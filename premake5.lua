@@ -30,32 +30,42 @@ Library = {}
 
 if os.host() == "windows" then
 	Library["Vulkan"] = "%{LibraryDir.Vulkan}/vulkan-1.lib"
+	Library["DXC"] = "%{LibraryDir.Vulkan}/dxcompiler.lib"
 
 	Library["ShaderC_Debug"] = "%{LibraryDir.Vulkan}/shaderc_sharedd.lib"
 	Library["SPIRV_Cross_Debug"] = "%{LibraryDir.Vulkan}/spirv-cross-cored.lib"
 	Library["SPIRV_Cross_GLSL_Debug"] = "%{LibraryDir.Vulkan}/spirv-cross-glsld.lib"
 	Library["SPIRV_Cross_HLSL_Debug"] = "%{LibraryDir.Vulkan}/spirv-cross-hlsld.lib"
 	Library["SPIRV_Cross_MSL_Debug"] = "%{LibraryDir.Vulkan}/spirv-cross-msld.lib"
+	Library["SPIRV_Tools_Debug"] = "%{LibraryDir.Vulkan}/SPIRV-Toolsd.lib"
+	Library["SPIRV_Tools_Opt_Debug"] = "%{LibraryDir.Vulkan}/SPIRV-Tools-optd.lib"
 
 	Library["ShaderC_Release"] = "%{LibraryDir.Vulkan}/shaderc_shared.lib"
 	Library["SPIRV_Cross_Release"] = "%{LibraryDir.Vulkan}/spirv-cross-core.lib"
 	Library["SPIRV_Cross_GLSL_Release"] = "%{LibraryDir.Vulkan}/spirv-cross-glsl.lib"
 	Library["SPIRV_Cross_HLSL_Release"] = "%{LibraryDir.Vulkan}/spirv-cross-hlsl.lib"
 	Library["SPIRV_Cross_MSL_Release"] = "%{LibraryDir.Vulkan}/spirv-cross-msl.lib"
+	Library["SPIRV_Tools_Release"] = "%{LibraryDir.Vulkan}/SPIRV-Tools.lib"
+	Library["SPIRV_Tools_Opt_Release"] = "%{LibraryDir.Vulkan}/SPIRV-Tools-opt.lib"
 elseif os.host() == "macosx" then
 	Library["Vulkan"] = "%{LibraryDir.Vulkan}/libvulkan.1.dylib"
+	Library["DXC"] = "%{LibraryDir.Vulkan}/libdxcompiler.dylib"
 
 	Library["ShaderC_Debug"] = "%{LibraryDir.Vulkan}/libshaderc.a"
 	Library["SPIRV_Cross_Debug"] = "%{LibraryDir.Vulkan}/libspirv-cross-core.a"
 	Library["SPIRV_Cross_GLSL_Debug"] = "%{LibraryDir.Vulkan}/libspirv-cross-glsl.a"
 	Library["SPIRV_Cross_HLSL_Debug"] = "%{LibraryDir.Vulkan}/libspirv-cross-hlsl.a"
 	Library["SPIRV_Cross_MSL_Debug"] = "%{LibraryDir.Vulkan}/libspirv-cross-msl.a"
+	Library["SPIRV_Tools_Debug"] = "%{LibraryDir.Vulkan}/libSPIRV-Tools.a"
+	Library["SPIRV_Tools_Opt_Debug"] = "%{LibraryDir.Vulkan}/libSPIRV-Tools-opt.a"
 
 	Library["ShaderC_Release"] = "%{LibraryDir.Vulkan}/libshaderc.a"
 	Library["SPIRV_Cross_Release"] = "%{LibraryDir.Vulkan}/libspirv-cross-core.a"
 	Library["SPIRV_Cross_GLSL_Release"] = "%{LibraryDir.Vulkan}/libspirv-cross-glsl.a"
 	Library["SPIRV_Cross_HLSL_Release"] = "%{LibraryDir.Vulkan}/libspirv-cross-hlsl.a"
 	Library["SPIRV_Cross_MSL_Release"] = "%{LibraryDir.Vulkan}/libspirv-cross-msl.a"
+	Library["SPIRV_Tools_Release"] = "%{LibraryDir.Vulkan}/libSPIRV-Tools.a"
+	Library["SPIRV_Tools_Opt_Release"] = "%{LibraryDir.Vulkan}/libSPIRV-Tools-opt.a"
 end
 
 workspace "wire"
@@ -135,7 +145,8 @@ project "wire"
 		"msdf-atlas-gen",
 		"portaudio",
 		"imgui",
-        "%{Library.Vulkan}"
+        "%{Library.Vulkan}",
+        "%{Library.DXC}"
     }
 
     filter "system:windows"
@@ -163,7 +174,9 @@ project "wire"
 			"%{Library.SPIRV_Cross_Debug}",
 			"%{Library.SPIRV_Cross_GLSL_Debug}",
 			"%{Library.SPIRV_Cross_HLSL_Debug}",
-			"%{Library.SPIRV_Cross_MSL_Debug}"
+			"%{Library.SPIRV_Cross_MSL_Debug}",
+			"%{Library.SPIRV_Tools_Opt_Debug}",
+			"%{Library.SPIRV_Tools_Debug}"
 		}
 
     filter "configurations:Release"
@@ -178,6 +191,8 @@ project "wire"
 			"%{Library.SPIRV_Cross_GLSL_Release}",
 			"%{Library.SPIRV_Cross_HLSL_Release}",
 			"%{Library.SPIRV_Cross_MSL_Release}",
+			"%{Library.SPIRV_Tools_Opt_Release}",
+			"%{Library.SPIRV_Tools_Release}",
 		}
 
     filter "configurations:Dist"
@@ -192,8 +207,80 @@ project "wire"
 			"%{Library.SPIRV_Cross_GLSL_Release}",
 			"%{Library.SPIRV_Cross_HLSL_Release}",
 			"%{Library.SPIRV_Cross_MSL_Release}",
+			"%{Library.SPIRV_Tools_Opt_Release}",
+			"%{Library.SPIRV_Tools_Release}",
 		}
 
+project "wire-shaderc"
+    location "wire-shaderc"
+    kind "ConsoleApp"
+    language "C++"
+    cppdialect "C++23"
+    staticruntime "off"
+
+    targetdir ("%{wks.location}/bin/" .. outputdir .. "/%{prj.name}")
+	objdir ("%{wks.location}/bin-int/" .. outputdir .. "/%{prj.name}")
+
+	files
+	{
+		"%{prj.location}/src/**.h",
+		"%{prj.location}/src/**.cpp",
+	}
+
+	includedirs
+	{
+		"%{wks.location}/Wire/src"
+	}
+
+    externalincludedirs
+	{
+		"%{IncludeDir.glm}",
+    }
+
+    links
+    {
+        "wire"
+    }
+
+    filter "system:windows"
+		systemversion "latest"
+
+		defines { "NOMINMAX" }
+
+	filter "system:macosx"
+		libdirs
+		{
+			"%{VULKAN_SDK}/lib"
+		}
+
+		links
+		{
+			"shaderc",
+			"shaderc_util",
+			"glslang",
+			"dxcompiler",
+			"vulkan",
+			"CoreFoundation.framework",
+			"CoreGraphics.framework",
+			"IOKit.framework",
+			"AppKit.framework"
+		}
+
+	filter "configurations:Debug"
+		defines "WR_DEBUG"
+		runtime "Debug"
+		symbols "on"
+
+	filter "configurations:Release"
+		defines "WR_RELEASE"
+		runtime "Release"
+		optimize "on"
+
+	filter "configurations:Dist"
+		defines "WR_DIST"
+		runtime "Release"
+		optimize "on"
+
 project "bloom"
     location "bloom"
     language "C++"
@@ -242,6 +329,7 @@ project "bloom"
 			"shaderc",
 			"shaderc_util",
 			"glslang",
+			"dxcompiler",
 			"vulkan",
 			"CoreFoundation.framework",
 			"CoreGraphics.framework",
@@ -274,3 +362,10 @@ project "bloom"
 		defines "WR_DIST"
 		runtime "Release"
 		optimize "on"
+
+		-- dist builds only load a prebuilt cache
+		dependson { "wire-shaderc" }
+		prebuildcommands
+		{
+			"\"%{wks.location}/bin/" .. outputdir .. "/wire-shaderc/wire-shaderc\" -c release -o \"%{prj.location}/wire.shadercache\" \"%{prj.location}/shaders\""
+		}
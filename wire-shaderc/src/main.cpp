@@ -0,0 +1,281 @@
+#include "Wire/Core/Log.h"
+#include "Wire/Renderer/ShaderCache.h"
+#include "Wire/Renderer/ShaderCompiler.h"
+
+#include <string>
+#include <vector>
+#include <fstream>
+#include <sstream>
+#include <iostream>
+#include <optional>
+#include <algorithm>
+#include <filesystem>
+#include <string_view>
+
+// builds a complete shader cache ahead of time so applications can run with LoadPrebuiltShaderCache
+//
+// usage: wire-shaderc [options] [shader directory...]
+//   -o <file>                       output cache (default wire.shadercache)
+//   -m <file>                       manifest listing shaders, see ReadManifest
+//   -c <debug|release|all>          configurations to build (default all)
+//   -I <directory>                  additional include directory
+//   -j <count>                      compile threads, 0 = one per hardware thread (default 0)
+//   -O <none|size|performance>      optimization preset
+//   --strip, --no-strip             strip debug info from the bytecode
+
+namespace Utils {
+
+    static std::vector<std::string> Tokenize(const std::string& line)
+    {
+        std::vector<std::string> tokens;
+
+        std::istringstream stream(line);
+        std::string token;
+        while (stream >> token)
+            tokens.push_back(token);
+
+        return tokens;
+    }
+
+    // one entry per line, paths are relative to the manifest:
+    //   graphics <path> <vertex entry point> <pixel entry point>
+    //   compute <path> <compute entry point>
+    //   variant <macro> [values...]    adds a variant axis to the previous shader, no values = toggle
+    //   frontend <shaderc|dxc>         hlsl front end of the previous shader (default shaderc)
+    //   include <directory>
+    static bool ReadManifest(const std::filesystem::path& path, std::vector<wire::ShaderInfo>& outShaderInfos, std::vector<std::filesystem::path>& outIncludeDirectories)
+    {
+        std::ifstream file(path);
+        if (!file.good())
+        {
+            WR_ERROR("Failed to open manifest {}", path.string());
+            return false;
+        }
+
+        std::filesystem::path root = path.parent_path();
+
+        std::string line;
+        uint32_t lineNumber = 0;
+
+        while (std::getline(file, line))
+        {
+            lineNumber++;
+
+            std::vector<std::string> tokens = Tokenize(line.substr(0, line.find('#')));
+            if (tokens.empty())
+                continue;
+
+            const std::string& command = tokens[0];
+
+            if (command == "graphics" && tokens.size() == 4)
+            {
+                outShaderInfos.push_back(wire::ShaderInfo{
+                    .Path = root / tokens[1],
+                    .IsGraphics = true,
+                    .VertexOrComputeEntryPoint = tokens[2],
+                    .PixelEntryPoint = tokens[3]
+                });
+            }
+            else if (command == "compute" && tokens.size() == 3)
+            {
+                outShaderInfos.push_back(wire::ShaderInfo{
+                    .Path = root / tokens[1],
+                    .IsGraphics = false,
+                    .VertexOrComputeEntryPoint = tokens[2]
+                });
+            }
+            else if (command == "variant" && tokens.size() >= 2 && !outShaderInfos.empty())
+            {
+                outShaderInfos.back().VariantAxes.push_back(wire::ShaderVariantAxis{
+                    .Macro = tokens[1],
+                    .Values = { tokens.begin() + 2, tokens.end() }
+                });
+            }
+            else if (command == "frontend" && tokens.size() == 2 && (tokens[1] == "shaderc" || tokens[1] == "dxc") && !outShaderInfos.empty())
+            {
+                outShaderInfos.back().Frontend = tokens[1] == "dxc" ? wire::ShaderFrontend::DXC : wire::ShaderFrontend::Shaderc;
+            }
+            else if (command == "include" && tokens.size() == 2)
+            {
+                outIncludeDirectories.push_back(root / tokens[1]);
+            }
+            else
+            {
+                WR_ERROR("{}:{}: invalid manifest entry \"{}\"", path.string(), lineNumber, line);
+                return false;
+            }
+        }
+
+        return true;
+    }
+
+    // failed compilations still produce a group, with empty bytecode
+    static bool IsCacheComplete(const std::filesystem::path& path, const std::vector<wire::ShaderInfo>& shaderInfos, wire::ShaderConfiguration config)
+    {
+        wire::ShaderCache cache = wire::ShaderCache::createFromFile(path);
+
+        bool complete = true;
+
+        for (const auto& info : shaderInfos)
+        {
+            std::string sourcePath = info.Path.generic_string();
+            uint32_t expectedObjects = info.IsGraphics ? 2 : 1;
+
+            for (uint32_t variantKey : wire::ShaderCompiler::getRequestedVariants(info))
+            {
+                auto it = std::find_if(cache.getGroups().begin(), cache.getGroups().end(), [&](const wire::ShaderGroup& group)
+                {
+                    return group.SourcePath == sourcePath && group.Config == config && group.VariantKey == variantKey;
+                });
+
+                bool valid = it != cache.getGroups().end() && it->Objects.size() == expectedObjects
+                    && std::none_of(it->Objects.begin(), it->Objects.end(), [](const wire::ShaderObject& object) { return object.getBytecode().empty(); });
+
+                if (!valid)
+                {
+                    WR_ERROR("{} (variant {}) failed to build", sourcePath, variantKey);
+                    complete = false;
+                }
+            }
+        }
+
+        return complete;
+    }
+
+}
+
+int main(int argc, char** argv)
+{
+    WR_SETUP_LOG({ &std::cout }, {}, "%c[%H:%M:%S]%c %m");
+
+    std::filesystem::path outputPath = "wire.shadercache";
+    std::vector<std::filesystem::path> shaderDirectories;
+    std::vector<std::filesystem::path> manifests;
+    std::vector<wire::ShaderConfiguration> configs = { wire::ShaderConfiguration::Debug, wire::ShaderConfiguration::Release };
+
+    wire::ShaderCompileOptions compileOptions{};
+    std::optional<wire::ShaderOptimizationPreset> preset;
+    std::optional<bool> stripDebugInfo;
+
+    for (int i = 1; i < argc; i++)
+    {
+        std::string_view arg = argv[i];
+
+        auto next = [&]() -> std::string_view
+        {
+            if (i + 1 >= argc)
+            {
+                WR_ERROR("{} expects a value", arg);
+                std::exit(1);
+            }
+
+            return argv[++i];
+        };
+
+        if (arg == "-o")
+            outputPath = next();
+        else if (arg == "-m")
+            manifests.emplace_back(next());
+        else if (arg == "-I")
+            compileOptions.IncludeDirectories.emplace_back(next());
+        else if (arg == "-j")
+            compileOptions.ThreadCount = static_cast<uint32_t>(std::stoul(std::string(next())));
+        else if (arg == "--strip")
+            stripDebugInfo = true;
+        else if (arg == "--no-strip")
+            stripDebugInfo = false;
+        else if (arg == "-c")
+        {
+            std::string_view value = next();
+            if (value == "debug")
+                configs = { wire::ShaderConfiguration::Debug };
+            else if (value == "release")
+                configs = { wire::ShaderConfiguration::Release };
+            else if (value != "all")
+            {
+                WR_ERROR("unknown configuration {}", value);
+                return 1;
+            }
+        }
+        else if (arg == "-O")
+        {
+            std::string_view value = next();
+            if (value == "none")
+                preset = wire::ShaderOptimizationPreset::None;
+            else if (value == "size")
+                preset = wire::ShaderOptimizationPreset::Size;
+            else if (value == "performance")
+                preset = wire::ShaderOptimizationPreset::Performance;
+            else
+            {
+                WR_ERROR("unknown optimization preset {}", value);
+                return 1;
+            }
+        }
+        else if (arg.starts_with("-"))
+        {
+            WR_ERROR("unknown option {}", arg);
+            return 1;
+        }
+        else
+            shaderDirectories.emplace_back(arg);
+    }
+
+    std::vector<wire::ShaderInfo> shaderInfos;
+
+    for (const auto& manifest : manifests)
+    {
+        if (!Utils::ReadManifest(manifest, shaderInfos, compileOptions.IncludeDirectories))
+            return 1;
+    }
+
+    if (shaderDirectories.empty() && manifests.empty())
+        shaderDirectories.emplace_back("shaders");
+
+    for (const auto& directory : shaderDirectories)
+    {
+        std::vector<wire::ShaderInfo> found = wire::ShaderCompiler::findShaders(directory);
+        if (found.empty())
+            WR_WARN("No shaders found in {}", directory.string());
+
+        shaderInfos.insert(shaderInfos.end(), found.begin(), found.end());
+    }
+
+    if (shaderInfos.empty())
+    {
+        WR_ERROR("Nothing to build");
+        return 1;
+    }
+
+    bool success = true;
+
+    // each configuration is merged into the same file, groups of the other one are kept
+    for (wire::ShaderConfiguration config : configs)
+    {
+        wire::ShaderCacheDesc desc{};
+        desc.CachePath = outputPath;
+        desc.ShaderInfos = shaderInfos;
+        desc.CompileOptions = compileOptions;
+        desc.CompileOptions.Configuration = config;
+
+        if (preset || stripDebugInfo)
+        {
+            wire::ShaderOptimizationOptions optimization = wire::ShaderCompiler::getOptimizationOptions(config, compileOptions);
+            optimization.Preset = preset.value_or(optimization.Preset);
+            optimization.StripDebugInfo = stripDebugInfo.value_or(optimization.StripDebugInfo);
+
+            desc.CompileOptions.Optimization = optimization;
+        }
+
+        WR_INFO("Building {} shaders ({})", shaderInfos.size(), config == wire::ShaderConfiguration::Debug ? "debug" : "release");
+
+        wire::ShaderCache::createOrGetShaderCache(desc);
+        success &= Utils::IsCacheComplete(outputPath, shaderInfos, config);
+    }
+
+    if (!success)
+        return 1;
+
+    WR_INFO("Wrote {}", outputPath.string());
+    return 0;
+}